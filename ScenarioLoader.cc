@@ -63,6 +63,9 @@ void ScenarioLoader::Save(char const *fname) const {
 
 	float ver = 1.0;
 	ofile << "version " << ver << std::endl;
+	// Mesma precisão das distâncias nos cenários de benchmark.
+	ofile.setf(std::ios::fixed, std::ios::floatfield);
+	ofile.precision(8);
 
 	for (unsigned int x = 0; x < experiments.size(); x++) {
 		ofile << experiments[x].bucket << "\t" << experiments[x].map << "\t" << experiments[x].scaleX << "\t";
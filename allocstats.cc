@@ -0,0 +1,133 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "allocstats.h"
+#include "memstats.h"
+
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+// Contadores das alocações. Atualizados atomicamente, já que o alocador pode
+// ser chamado de várias threads.
+static size_t live_bytes = 0;
+static size_t peak_bytes = 0;
+static size_t query_base = 0;
+
+// Maior lista aberta desde o último begin_query.
+static size_t openpeak = 0;
+
+// Cabeçalho de cada bloco alocado; tem 16 bytes para manter o alinhamento
+// garantido pelo malloc.
+union AllocHeader {
+	size_t size;
+	char pad[16];
+};
+
+static void *tracked_alloc(size_t size) {
+	AllocHeader *hdr = static_cast<AllocHeader *>(malloc(sizeof(AllocHeader) + size));
+	if (!hdr) {
+		return 0;
+	}
+	hdr->size = size;
+	size_t live = __sync_add_and_fetch(&live_bytes, size);
+	size_t peak = peak_bytes;
+	while (live > peak) {
+		size_t prev = __sync_val_compare_and_swap(&peak_bytes, peak, live);
+		if (prev == peak) {
+			break;
+		}
+		peak = prev;
+	}
+	return hdr + 1;
+}
+
+static void tracked_free(void *ptr) {
+	if (!ptr) {
+		return;
+	}
+	AllocHeader *hdr = static_cast<AllocHeader *>(ptr) - 1;
+	__sync_sub_and_fetch(&live_bytes, hdr->size);
+	free(hdr);
+}
+
+void *operator new(size_t size) throw(std::bad_alloc) {
+	void *ptr = tracked_alloc(size ? size : 1);
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void *operator new[](size_t size) throw(std::bad_alloc) {
+	return operator new(size);
+}
+
+void *operator new(size_t size, std::nothrow_t const &) throw() {
+	return tracked_alloc(size ? size : 1);
+}
+
+void *operator new[](size_t size, std::nothrow_t const &) throw() {
+	return tracked_alloc(size ? size : 1);
+}
+
+void operator delete(void *ptr) throw() {
+	tracked_free(ptr);
+}
+
+void operator delete[](void *ptr) throw() {
+	tracked_free(ptr);
+}
+
+void operator delete(void *ptr, std::nothrow_t const &) throw() {
+	tracked_free(ptr);
+}
+
+void operator delete[](void *ptr, std::nothrow_t const &) throw() {
+	tracked_free(ptr);
+}
+
+size_t AllocStats::get_live_bytes() {
+	return live_bytes;
+}
+
+void AllocStats::begin_query() {
+	query_base = live_bytes;
+	peak_bytes = live_bytes;
+	openpeak = 0;
+}
+
+size_t AllocStats::get_query_peak() {
+	return peak_bytes > query_base ? peak_bytes - query_base : 0;
+}
+
+static void record_open_list(size_t peak) {
+	if (peak > openpeak) {
+		openpeak = peak;
+	}
+}
+
+void AllocStats::install() {
+	MemStats::set_open_list_hook(record_open_list);
+}
+
+size_t AllocStats::get_open_list_peak() {
+	return openpeak;
+}
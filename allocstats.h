@@ -0,0 +1,50 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _ALLOCSTATS_H_
+#define _ALLOCSTATS_H_
+
+#include <cstddef>
+
+/*
+ * Contagem das alocações dinâmicas do driver. As alocações são contadas por
+ * versões próprias dos operadores new e delete globais (em allocstats.cc),
+ * que só são ligadas ao programa principal e não fazem parte da biblioteca.
+ */
+class AllocStats {
+public:
+	// Instala o registro do pico da lista aberta (veja MemStats).
+	static void install();
+
+	// Bytes alocados dinamicamente e ainda não liberados.
+	static size_t get_live_bytes();
+
+	/*
+	 * Começa a medir o pico de alocações e da lista aberta de uma consulta. O
+	 * pico de alocações é relativo ao que já estava alocado quando a medição
+	 * começou.
+	 */
+	static void begin_query();
+	static size_t get_query_peak();
+
+	// Maior lista aberta registrada desde o último begin_query.
+	static size_t get_open_list_peak();
+};
+
+#endif // _ALLOCSTATS_H_
@@ -0,0 +1,231 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _ARASTAR_H_
+#define _ARASTAR_H_
+
+#include "graph.h"
+#include "heap.h"
+#include "memstats.h"
+#include "search.h"
+
+#include <algorithm>
+#include <vector>
+
+/*
+ * Anytime Repairing A* (Likhachev, Gordon e Thrun, 2003). Faz uma sequência
+ * de buscas A* ponderadas com eps decrescente; a primeira acha rápido uma
+ * solução com custo até eps vezes o ótimo, e cada uma das seguintes a melhora
+ * reaproveitando as distâncias e a lista aberta da anterior. Nós cuja
+ * distância melhora depois de expandidos não são reabertos na mesma
+ * iteração, e sim guardados até a próxima (a lista INCONS do artigo).
+ *
+ * Como em ShortestPath, o estado da busca fica nos nós do grafo; ao fim de
+ * cada iteração, o nó de destino está expandido e a cadeia de pais dá o
+ * caminho atual. Os custos dos passos e a heurística são os de G::distance,
+ * de modo que, com um GridModel, a busca segue o modelo e a métrica dele.
+ */
+template <typename G>
+class BasicARAstar {
+public:
+	typedef typename G::node_type N;
+
+	// Começa uma busca com eps inicial 'eps', diminuído de 'decrement' a cada
+	// iteração até chegar a 1.
+	BasicARAstar(G &_g, N *src, N const *dst, double _eps, double _decrement)
+		: g(_g), start(src), goal(dst), eps(std::max(_eps, 1.0)), decrement(_decrement),
+		  bound(eps), open(KeyCmp(dst, &eps)), iterations(0), done(false),
+		  ins(0), upd(0), pop(0) {
+		g.init_single_source(start);
+		start->mark_seen();
+		open.insert(start);
+		ins++;
+	}
+
+	/*
+	 * Executa a próxima iteração. Retorna false se não houver mais o que
+	 * melhorar (veja finished) ou se o destino for inalcançável.
+	 */
+	bool improve();
+
+	// Se a solução atual é comprovadamente ótima (ou não existe).
+	bool finished() const           {	return done;	}
+
+	// eps usado pela última iteração e limite de subotimalidade da solução
+	// atual, que pode ser menor que eps.
+	double get_epsilon() const      {	return eps;	}
+	double get_bound() const        {	return bound;	}
+
+	// Número de iterações já executadas.
+	unsigned get_iterations() const {	return iterations;	}
+
+	// Contadores de inserções, atualizações e remoções do heap, somados
+	// sobre todas as iterações.
+	size_t get_inserts() const      {	return ins;	}
+	size_t get_updates() const      {	return upd;	}
+	size_t get_pops() const         {	return pop;	}
+
+private:
+	// Igual a BasicWeightedAstarCmp, mas lê eps do BasicARAstar, que muda
+	// entre as iterações.
+	struct KeyCmp {
+		KeyCmp(N const *dest, double const *_eps) : target(dest), eps(_eps) {	}
+
+		bool operator()(N const *lhs, N const *rhs) {
+			double dlhs = G::distance(lhs, target), drhs = G::distance(rhs, target);
+			double dl = lhs->get_distance() + *eps * dlhs, dr = rhs->get_distance() + *eps * drhs;
+			if (dl != dr)
+				return dl < dr;
+			return dlhs < drhs;
+		}
+	private:
+		N const *target;
+		double const *eps;
+	};
+
+	typedef Heap<N, KeyCmp, GetIndex, SetIndex> Queue;
+
+	void improve_path();
+	void update_bound();
+
+	G &g;
+	N *start;
+	N const *goal;
+	double eps, decrement, bound;
+	Queue open;
+	// Nós expandidos na iteração atual e nós inconsistentes já expandidos.
+	std::vector<N *> closed, incons;
+	unsigned iterations;
+	bool done;
+	size_t ins, upd, pop;
+
+	// Não copiável: o heap guarda um ponteiro para eps.
+	BasicARAstar(BasicARAstar const &);
+	BasicARAstar &operator=(BasicARAstar const &);
+};
+
+typedef BasicARAstar<Graph> ARAstar;
+
+template <typename G>
+bool BasicARAstar<G>::improve() {
+	if (done) {
+		return false;
+	}
+
+	if (iterations > 0) {
+		eps = std::max(eps - decrement, 1.0);
+		// Os nós expandidos na iteração anterior voltam a estar fora das
+		// listas; os inconsistentes entram na lista aberta, que é então
+		// reorganizada de acordo com o novo eps.
+		for (typename std::vector<N *>::iterator it = closed.begin(); it != closed.end(); ++it) {
+			(*it)->mark_unseen();
+		}
+		closed.clear();
+		for (typename std::vector<N *>::iterator it = incons.begin(); it != incons.end(); ++it) {
+			if ((*it)->still_unseen()) {
+				(*it)->mark_seen();
+				open.insert_unsorted(*it);
+				ins++;
+			}
+		}
+		incons.clear();
+		open.heapify();
+	}
+
+	improve_path();
+	iterations++;
+	MemStats::record_open_list(open.get_peak_size());
+	if (!goal->already_done()) {
+		// Inalcançável: a lista aberta esvaziou.
+		done = true;
+		return false;
+	}
+	update_bound();
+	if (eps <= 1.0 || bound <= 1.0) {
+		done = true;
+	}
+	return true;
+}
+
+/*
+ * Busca A* ponderada até expandir o destino, que é o mesmo que parar quando
+ * f(destino) não é maior que o menor f da lista aberta.
+ */
+template <typename G>
+void BasicARAstar<G>::improve_path() {
+	N *target = g.get_node(goal->get_x(), goal->get_y());
+	if (target->still_unseen() && target->get_distance() < 1.0E9) {
+		// O destino foi expandido na iteração anterior; tem que voltar para a
+		// lista aberta para que a condição de parada seja testada.
+		target->mark_seen();
+		open.insert(target);
+		ins++;
+	}
+
+	while (!open.empty()) {
+		N *u = open.extract();
+		pop++;
+		u->mark_done();
+		closed.push_back(u);
+		if (u == goal) {
+			break;
+		}
+
+		N *adj[MAX_NEIGHBOURS];
+		unsigned count = g.get_adjacent_nodes(u, adj);
+		for (unsigned ii = 0; ii < count; ii++) {
+			N *next = adj[ii];
+			double dist = u->get_distance() + G::distance(u, next);
+			if (next->get_distance() <= dist) {
+				continue;
+			}
+			next->set_distance(dist);
+			next->set_parent(u);
+			if (next->already_done()) {
+				// Já expandido nesta iteração: fica para a próxima.
+				incons.push_back(next);
+			} else if (next->already_seen()) {
+				open.update_elem(next);
+				upd++;
+			} else {
+				next->mark_seen();
+				open.insert(next);
+				ins++;
+			}
+		}
+	}
+}
+
+/*
+ * O custo ótimo é pelo menos o menor g + h dentre os nós nas listas aberta e
+ * INCONS, o que dá um limite possivelmente melhor que eps.
+ */
+template <typename G>
+void BasicARAstar<G>::update_bound() {
+	double minf = goal->get_distance();
+	for (size_t ii = 0; ii < open.size(); ii++) {
+		N const *node = open.get(ii);
+		minf = std::min(minf, node->get_distance() + G::distance(node, goal));
+	}
+	for (typename std::vector<N *>::const_iterator it = incons.begin(); it != incons.end(); ++it) {
+		minf = std::min(minf, (*it)->get_distance() + G::distance(*it, goal));
+	}
+	bound = minf > 0 ? std::max(std::min(eps, goal->get_distance() / minf), 1.0) : 1.0;
+}
+
+#endif // _ARASTAR_H_
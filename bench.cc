@@ -0,0 +1,193 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bench.h"
+#include "compactsearch.h"
+#include "memstats.h"
+
+using namespace std;
+
+PathWriter pathout;
+uint32_t pathid = 0;
+
+MethodName const method_names[] = {
+	{"dijkstra", eDijkstra},
+	{"astar",    eAstar},
+	{"jps",      eJPS},
+	{"fringe",   eFringe},
+	{"wastar",   eWeighted},
+	{"ara",      eARA},
+	{"coarse",   eCoarse},
+	{"simd",     eSimd},
+	{"canon-dijkstra", eCanonDijkstra},
+	{"canon-astar",    eCanonAstar},
+	{"compact",  eCompact},
+	{"all",      eAllMethods}
+};
+
+unsigned const num_method_names = sizeof(method_names) / sizeof(method_names[0]);
+
+void dump_counters(PerfCounters const *perf, int reps) {
+	if (!perf) {
+		return;
+	}
+	for (int ii = 0; ii < PerfCounters::eNumEvents; ii++) {
+		PerfCounters::Event ev = static_cast<PerfCounters::Event>(ii);
+		if (perf->has(ev)) {
+			cout << ", " << PerfCounters::get_name(ev) << " = " << setw(8)
+			     << (perf->get(ev) / reps);
+		}
+	}
+}
+
+#ifdef PROFILE_PHASES
+void dump_phases(int reps) {
+	cout << "phases:";
+	uint64_t total = 0;
+	for (int ii = 0; ii < eNumPhases; ii++) {
+		Phase ph = static_cast<Phase>(ii);
+		total += Profiler::get_cycles(ph);
+		cout << " " << Profiler::get_name(ph) << " = "
+		     << Profiler::get_cycles(ph) / reps
+		     << " (" << Profiler::get_calls(ph) / reps << ");";
+	}
+	uint64_t jumps = Profiler::get_count(eCountJumpCalls);
+	uint64_t steps = Profiler::get_count(eCountJumpSteps);
+	cout << " total = " << total / reps
+	     << "; jumpcalls = " << jumps / reps
+	     << ", jumpsteps = " << steps / reps
+	     << ", avgscan = " << (jumps ? 1.0 * steps / jumps : 0.0) << endl;
+}
+#endif
+
+void dump_outside_map(char const *method) {
+	cout << method << endl << "source or destination outside the map" << endl;
+}
+
+double relative_error(double dist, double mindist) {
+	return mindist > 0 ? (dist - mindist) / mindist : 0;
+}
+
+void dump_distance_info(bool found, size_t ins, size_t upd, size_t pop,
+                        double dist, double mindist, double time) {
+	cout << "insert = " << setw(6) << ins
+	     << ", update = " << setw(6) << upd
+	     << ", extract = " << setw(6) << pop;
+	if (!found) {
+		cout << endl << "destination unreachable from source" << endl;
+		return;
+	}
+	double pathlen = round(dist * DISTANCE_PRECISION) / DISTANCE_PRECISION;
+	cout << ", distance = " << setw(6) << pathlen
+	     << ", mindist = " << setw(6) << mindist
+	     << ", correct = " << setw(6) << (pathlen - mindist)
+	     << ", time = " << setw(6) << time << endl;
+}
+
+bool check_inside(ScenarioLoader const &scen, int first, int last,
+                  unsigned w, unsigned h) {
+	bool inside = true;
+	for (int jj = first; jj < last; jj++) {
+		Experiment const &exp = scen.GetNthExperiment(jj);
+		if (static_cast<unsigned>(exp.GetStartX()) >= w
+		    || static_cast<unsigned>(exp.GetStartY()) >= h
+		    || static_cast<unsigned>(exp.GetGoalX()) >= w
+		    || static_cast<unsigned>(exp.GetGoalY()) >= h) {
+			cerr << "No cenario '" << scen.GetScenarioName() << "', experimento "
+			     << jj << ": origem ou destino fora do mapa." << endl;
+			inside = false;
+		}
+	}
+	return inside;
+}
+
+bool distance_matches(Node const *dst, double mindist, double bound) {
+	if (!dst->already_done()) {
+		return false;
+	}
+	double pathlen = round(dst->get_distance() * DISTANCE_PRECISION) / DISTANCE_PRECISION;
+	double tolerance = 1.0 / DISTANCE_PRECISION;
+	return pathlen >= mindist - tolerance && pathlen <= bound * mindist + tolerance;
+}
+
+void BucketStats::add(int bucket, char const *tag, size_t ins, size_t upd, size_t pop,
+                      double time, double error, PerfCounters const *perf, int reps) {
+	Totals &tot = totals[make_pair(bucket, string(tag))];
+	tot.count++;
+	tot.ins += ins;
+	tot.upd += upd;
+	tot.pop += pop;
+	tot.time += time;
+	tot.error += error;
+	if (perf) {
+		tot.perfcount++;
+		for (int ii = 0; ii < PerfCounters::eNumEvents; ii++) {
+			PerfCounters::Event ev = static_cast<PerfCounters::Event>(ii);
+			tot.hascnt[ii] = perf->has(ev);
+			tot.counters[ii] += 1.0 * perf->get(ev) / reps;
+		}
+	}
+}
+
+void BucketStats::dump_and_clear(char const *scenname) {
+	if (totals.empty()) {
+		return;
+	}
+	cout << "#### buckets: " << scenname << " ####" << endl;
+	for (TotalsMap::const_iterator it = totals.begin(); it != totals.end(); ++it) {
+		Totals const &tot = it->second;
+		cout << "bucket = " << setw(3) << it->first.first
+		     << ", method = " << it->first.second
+		     << ", count = " << setw(5) << tot.count
+		     << ", insert = " << setw(9) << tot.ins / tot.count
+		     << ", update = " << setw(9) << tot.upd / tot.count
+		     << ", extract = " << setw(9) << tot.pop / tot.count
+		     << ", time = " << setw(9) << tot.time / tot.count
+		     << ", error = " << setw(9) << tot.error / tot.count;
+		for (int ii = 0; tot.perfcount && ii < PerfCounters::eNumEvents; ii++) {
+			if (tot.hascnt[ii]) {
+				cout << ", " << PerfCounters::get_name(static_cast<PerfCounters::Event>(ii))
+				     << " = " << setw(9) << tot.counters[ii] / tot.perfcount;
+			}
+		}
+		// Variantes de um método (-p, regiões sem saída; -b, caixas de
+		// destinos; -c, ordem canônica; -k, estado compacto) são
+		// comparadas com o método original.
+		string const &tag = it->first.second;
+		if (tag.size() > 2 && tag[tag.size() - 2] == '-') {
+			TotalsMap::const_iterator base = totals.find(
+				make_pair(it->first.first, tag.substr(0, tag.size() - 2)));
+			if (base != totals.end() && base->second.pop > 0 && base->second.time > 0) {
+				Totals const &bt = base->second;
+				cout << ", extract ratio = " << setw(6)
+				     << (tot.pop / tot.count) / (bt.pop / bt.count)
+				     << ", time ratio = " << setw(6)
+				     << (tot.time / tot.count) / (bt.time / bt.count);
+			}
+		}
+		cout << endl;
+	}
+	totals.clear();
+}
+
+void export_path(CompactSearch const &cs, char const *tag) {
+	static CompactPath path;
+	if (pathout.is_open() && cs.get_path(path)) {
+		pathout.write(tag, pathid, path);
+	}
+}
@@ -0,0 +1,323 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include "ScenarioLoader.h"
+#include "allocstats.h"
+#include "arastar.h"
+#include "compactpath.h"
+#include "graph.h"
+#include "perfcounters.h"
+#include "profiler.h"
+#include "search.h"
+
+#include <stdint.h>
+#include <sys/time.h>
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+
+/*
+ * Infraestrutura comum aos modos do programa principal (dijkstra.cc e os
+ * run*.cc, veja runners.h): medição do tempo, impressão dos resultados,
+ * estatísticas por bucket e exportação dos caminhos. Só faz parte do
+ * programa, e não da biblioteca.
+ */
+
+class CompactSearch;
+
+#define MAXCNT 5
+
+// Decremento de eps entre as iterações do ARA*.
+#define ARA_DECREMENT 0.2
+
+inline double usec2sec(timeval const &tim) {
+	return tim.tv_sec + (tim.tv_usec / 1000000.0);
+}
+
+inline double delta_t(timeval const &start, timeval const &finish) {
+	return usec2sec(finish) - usec2sec(start);
+}
+
+/*
+ * Imprime os valores dos contadores de hardware (se houver), divididos pelo
+ * número de repetições da busca.
+ */
+void dump_counters(PerfCounters const *perf, int reps);
+
+#ifdef PROFILE_PHASES
+/*
+ * Imprime o tempo (em ciclos) e o número de chamadas de cada fase da busca,
+ * divididos pelo número de repetições da busca.
+ */
+void dump_phases(int reps);
+#endif
+
+// Erro relativo do caminho encontrado em relação ao ótimo.
+template <typename N>
+double path_error(N const *dst, double mindist) {
+	if (dst->get_parent() == 0 || mindist <= 0) {
+		return 0;
+	}
+	return (dst->get_distance() - mindist) / mindist;
+}
+
+/*
+ * Imprime diversas informações relevantes do caminho encontrado. 'bound' é o
+ * limite de subotimalidade garantido pelo método (1 para os ótimos).
+ */
+template <typename N>
+void dump_path_info(N const *dst, char const *method, size_t ins,
+                    size_t upd, size_t pop, double mindist, double time,
+                    PerfCounters const *perf = 0, int reps = 1, double bound = 1.0) {
+	std::cout << method << std::endl;
+	std::cout << "insert = " << std::setw(6) << ins
+	          << ", update = " << std::setw(6) << upd
+	          << ", extract = " << std::setw(6) << pop;
+	if (dst->get_parent() == 0) {
+		std::cout << std::endl << "destination unreachable from source" << std::endl;
+		return;
+	}
+	double pathlen = round(dst->get_distance() * DISTANCE_PRECISION) / DISTANCE_PRECISION;
+	std::cout << ", distance = " << std::setw(6) << pathlen
+	          << ", mindist = " << std::setw(6) << mindist
+	          << ", correct = " << std::setw(6) << (pathlen - mindist)
+	          << ", time = " << std::setw(6) << time
+	          << ", bound = " << std::setw(6) << bound
+	          << ", error = " << std::setw(6) << path_error(dst, mindist);
+	dump_counters(perf, reps);
+	std::cout << ", openpeak = " << AllocStats::get_open_list_peak()
+	          << ", allocpeak = " << AllocStats::get_query_peak() << std::endl;
+}
+
+// Imprime o aviso de uma consulta com origem ou destino fora do mapa.
+void dump_outside_map(char const *method);
+
+// Erro relativo de uma distância em relação à ótima.
+double relative_error(double dist, double mindist);
+
+/*
+ * Como dump_path_info, para buscas que não guardam o caminho nos nós do grafo
+ * e só informam a distância encontrada.
+ */
+void dump_distance_info(bool found, size_t ins, size_t upd, size_t pop,
+                        double dist, double mindist, double time);
+
+/*
+ * Se a origem e o destino dos experimentos [first, last) do cenário estão
+ * dentro de um mapa w x h; avisa os que não estão.
+ */
+bool check_inside(ScenarioLoader const &scen, int first, int last,
+                  unsigned w, unsigned h);
+
+// Se a distância encontrada bate com a do cenário, a menos da precisão usada
+// na impressão das distâncias. Para métodos subótimos, 'bound' é o quanto a
+// distância pode exceder a ótima, em proporção.
+bool distance_matches(Node const *dst, double mindist, double bound = 1.0);
+
+/*
+ * Acumula estatísticas por "bucket" do cenário (que agrupa experimentos com
+ * caminhos de comprimento parecido) e por método, para que seja possível ver
+ * como o custo de cada algoritmo cresce com o comprimento do caminho.
+ */
+class BucketStats {
+public:
+	void add(int bucket, char const *tag, size_t ins, size_t upd, size_t pop,
+	         double time, double error, PerfCounters const *perf, int reps);
+
+	/*
+	 * Imprime as médias de cada bucket e método e esquece tudo. Métodos com
+	 * poda (sufixo "-p") também são comparados com o método sem poda.
+	 */
+	void dump_and_clear(char const *scenname);
+
+private:
+	struct Totals {
+		Totals() : count(0), ins(0), upd(0), pop(0), time(0), error(0), perfcount(0) {
+			for (int ii = 0; ii < PerfCounters::eNumEvents; ii++) {
+				hascnt[ii] = false;
+				counters[ii] = 0;
+			}
+		}
+		size_t count;
+		double ins, upd, pop, time, error;
+		size_t perfcount;
+		bool hascnt[PerfCounters::eNumEvents];
+		double counters[PerfCounters::eNumEvents];
+	};
+	typedef std::map<std::pair<int, std::string>, Totals> TotalsMap;
+	TotalsMap totals;
+};
+
+// Exportação dos caminhos achados (-O), e número do experimento atual,
+// contando todos os cenários a partir de 1.
+extern PathWriter pathout;
+extern uint32_t pathid;
+
+// Grava o caminho achado por um método, se a exportação estiver ligada.
+template <typename N>
+void export_path(N const *dst, char const *tag) {
+	// Reaproveitado entre os caminhos, para não alocar a cada um.
+	static CompactPath path;
+	if (pathout.is_open() && path.build(dst)) {
+		pathout.write(tag, pathid, path);
+	}
+}
+
+void export_path(CompactSearch const &cs, char const *tag);
+
+// Métodos de busca que podem ser executados, selecionáveis com -a.
+enum Method {
+	eDijkstra   = 1 << 0,
+	eAstar      = 1 << 1,
+	eJPS        = 1 << 2,
+	eFringe     = 1 << 3,
+	// Os métodos subótimos não fazem parte de "all" e têm que ser pedidos
+	// explicitamente.
+	eWeighted   = 1 << 4,
+	eARA        = 1 << 5,
+	// A* com a heurística da grade reduzida.
+	eCoarse     = 1 << 6,
+	// A* com a expansão vetorizada, em cada núcleo disponível.
+	eSimd       = 1 << 7,
+	// Dijkstra e A* com ordem canônica dos caminhos.
+	eCanonDijkstra = 1 << 8,
+	eCanonAstar    = 1 << 9,
+	// Dijkstra e A* com estado compacto por célula.
+	eCompact    = 1 << 10,
+	eAllMethods = eDijkstra | eAstar | eJPS | eFringe
+};
+
+struct MethodName {
+	char const *name;
+	unsigned mask;
+};
+
+extern MethodName const method_names[];
+extern unsigned const num_method_names;
+
+/*
+ * Executa um método MAXCNT vezes, medindo o tempo médio (e os contadores de
+ * hardware, se estiverem ligados), e imprime os resultados.
+ */
+template <typename G, typename Compare, typename Successors>
+void run_method(G &g, typename G::node_type *src, typename G::node_type const *dst,
+                Compare cmp, Successors succ,
+                Experiment const &exp, char const *method, char const *tag,
+                PerfCounters *perf, BucketStats &stats, double bound = 1.0) {
+	// Para estatísticas.
+	size_t ins, upd, pop;
+	timeval start, finish;
+
+#ifdef PROFILE_PHASES
+	Profiler::reset();
+#endif
+	AllocStats::begin_query();
+	if (perf) {
+		perf->start();
+	}
+	gettimeofday(&start, NULL);
+	for (int cnt = 0; cnt < MAXCNT; cnt++) {
+		ShortestPath(g, src, dst, cmp, succ, ins, upd, pop);
+	}
+	gettimeofday(&finish, NULL);
+	if (perf) {
+		perf->stop();
+	}
+
+	double time = delta_t(start, finish) / MAXCNT;
+	dump_path_info(dst, method, ins, upd, pop, exp.GetDistance(), time, perf, MAXCNT, bound);
+	export_path(dst, tag);
+#ifdef PROFILE_PHASES
+	dump_phases(MAXCNT);
+#endif
+	stats.add(exp.GetBucket(), tag, ins, upd, pop, time,
+	          path_error(dst, exp.GetDistance()), perf, MAXCNT);
+}
+
+/*
+ * Como run_method, mas para ARA*, que é executado até a solução ótima. Além
+ * do resultado final, imprime o tempo e a qualidade da primeira solução.
+ */
+template <typename G>
+void run_ara(G &g, typename G::node_type *src, typename G::node_type const *dst, double eps,
+             Experiment const &exp, PerfCounters *perf, BucketStats &stats) {
+	char const *method = "==== ARA* ========";
+	if (!src || !dst) {
+		dump_outside_map(method);
+		return;
+	}
+	timeval start, finish;
+	double firsttime = 0, firstbound = 1.0, firsterror = 0;
+	size_t firstpop = 0;
+	unsigned iterations = 0;
+	size_t ins = 0, upd = 0, pop = 0;
+
+#ifdef PROFILE_PHASES
+	Profiler::reset();
+#endif
+	AllocStats::begin_query();
+	if (perf) {
+		perf->start();
+	}
+	gettimeofday(&start, NULL);
+	for (int cnt = 0; cnt < MAXCNT; cnt++) {
+		timeval repstart, first;
+		gettimeofday(&repstart, NULL);
+		BasicARAstar<G> ara(g, src, dst, eps, ARA_DECREMENT);
+		ara.improve();
+		gettimeofday(&first, NULL);
+		firsttime += delta_t(repstart, first) / MAXCNT;
+		firstbound = ara.get_bound();
+		firsterror = path_error(dst, exp.GetDistance());
+		firstpop = ara.get_pops();
+		while (ara.improve()) {
+		}
+		iterations = ara.get_iterations();
+		ins = ara.get_inserts();
+		upd = ara.get_updates();
+		pop = ara.get_pops();
+	}
+	gettimeofday(&finish, NULL);
+	if (perf) {
+		perf->stop();
+	}
+	double time = delta_t(start, finish) / MAXCNT;
+	dump_path_info(dst, method, ins, upd, pop, exp.GetDistance(), time,
+	               perf, MAXCNT, 1.0);
+	export_path(dst, "ara");
+	std::cout << "anytime: iterations = " << iterations
+	          << ", first = " << firsttime
+	          << ", firstextract = " << firstpop
+	          << ", firstbound = " << firstbound
+	          << ", firsterror = " << firsterror << std::endl;
+#ifdef PROFILE_PHASES
+	dump_phases(MAXCNT);
+#endif
+	stats.add(exp.GetBucket(), "ara", ins, upd, pop, time,
+	          path_error(dst, exp.GetDistance()), perf, MAXCNT);
+	stats.add(exp.GetBucket(), "ara-first", 0, 0, firstpop, firsttime, firsterror, 0, 1);
+}
+
+#endif // _BENCH_H_
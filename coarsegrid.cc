@@ -0,0 +1,464 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "coarsegrid.h"
+
+#include <cstddef>
+#include <functional>
+#include <queue>
+#include <utility>
+
+using namespace std;
+
+uint8_t const CoarseGrid::NO_REGION;
+
+// "Infinito" usado pelas distâncias, o mesmo de Node.
+static double const INFINITE_DIST = 1.0E9;
+
+static Direction const ALL_DIRS[] = {eNorth, eNorthEast, eEast, eSouthEast,
+                                     eSouth, eSouthWest, eWest, eNorthWest};
+
+void CoarseGrid::build(Graph &g) {
+	w = g.get_width();
+	h = g.get_height();
+	bw = (w + BLOCK_SIDE - 1) / BLOCK_SIDE;
+	bh = (h + BLOCK_SIDE - 1) / BLOCK_SIDE;
+	label_blocks(g);
+	link_regions(g);
+	EntryGraph eg;
+	build_entries(g, eg);
+	place_landmarks(eg);
+}
+
+char const *CoarseGrid::get_state_name(State st) {
+	static char const *const names[eNumStates] = {"free", "partial", "blocked"};
+	return st < eNumStates ? names[st] : "?";
+}
+
+size_t CoarseGrid::count_blocks(State st) const {
+	return static_cast<size_t>(count(state.begin(), state.end(), static_cast<uint8_t>(st)));
+}
+
+size_t CoarseGrid::get_memory_usage() const {
+	return sizeof(*this) + local.capacity() + state.capacity()
+	     + first.capacity() * sizeof(uint32_t) + regions.capacity() * sizeof(Region);
+}
+
+/*
+ * Divide cada bloco em regiões conexas por dentro do bloco (preenchimento por
+ * inundação que não sai do bloco) e resume o bloco.
+ */
+void CoarseGrid::label_blocks(Graph &g) {
+	local.assign(static_cast<size_t>(w) * h, NO_REGION);
+	state.assign(bw * bh, eBlocked);
+	first.assign(bw * bh, 0);
+	regions.clear();
+
+	Region init;
+	init.comp = 0;
+
+	vector<Node *> stack;
+	for (unsigned by = 0; by < bh; by++) {
+		for (unsigned bx = 0; bx < bw; bx++) {
+			unsigned const block = by * bw + bx;
+			unsigned const x0 = bx * BLOCK_SIDE, y0 = by * BLOCK_SIDE;
+			unsigned const x1 = min(x0 + BLOCK_SIDE, w), y1 = min(y0 + BLOCK_SIDE, h);
+			first[block] = static_cast<uint32_t>(regions.size());
+			uint8_t nlocal = 0;
+			size_t passable = 0;
+			for (unsigned yy = y0; yy < y1; yy++) {
+				for (unsigned xx = x0; xx < x1; xx++) {
+					Node *node = g.get_node(xx, yy);
+					if (node->is_blocked()) {
+						continue;
+					}
+					passable++;
+					if (local[static_cast<size_t>(yy) * w + xx] != NO_REGION) {
+						continue;
+					}
+					// Nova região: inunda o bloco a partir deste nó.
+					uint8_t const id = nlocal++;
+					regions.push_back(init);
+					local[static_cast<size_t>(yy) * w + xx] = id;
+					stack.push_back(node);
+					while (!stack.empty()) {
+						Node *curr = stack.back();
+						stack.pop_back();
+						for (unsigned dd = 0; dd < sizeof(ALL_DIRS) / sizeof(ALL_DIRS[0]); dd++) {
+							Node *next = g.get_adjacent(curr, ALL_DIRS[dd]);
+							if (!next) {
+								continue;
+							}
+							unsigned nx = next->get_x(), ny = next->get_y();
+							size_t cell = static_cast<size_t>(ny) * w + nx;
+							if (nx < x0 || nx >= x1 || ny < y0 || ny >= y1
+							    || local[cell] != NO_REGION) {
+								continue;
+							}
+							local[cell] = id;
+							stack.push_back(next);
+						}
+					}
+				}
+			}
+			if (passable == static_cast<size_t>(x1 - x0) * (y1 - y0)) {
+				state[block] = eFree;
+			} else if (passable != 0) {
+				state[block] = ePartial;
+			}
+		}
+	}
+}
+
+// Raiz de uma região no union-find, com compressão de caminho.
+static uint32_t find_root(vector<uint32_t> &parent, uint32_t reg) {
+	uint32_t root = reg;
+	while (parent[root] != root) {
+		root = parent[root];
+	}
+	while (parent[reg] != root) {
+		uint32_t next = parent[reg];
+		parent[reg] = root;
+		reg = next;
+	}
+	return root;
+}
+
+// Liga as regiões de blocos vizinhos que se tocam e numera as componentes.
+void CoarseGrid::link_regions(Graph &g) {
+	vector<uint32_t> parent(regions.size());
+	for (uint32_t ii = 0; ii < parent.size(); ii++) {
+		parent[ii] = ii;
+	}
+	// Basta olhar metade das direções: as arestas são não-direcionadas.
+	static Direction const dirs[] = {eEast, eSouthEast, eSouth, eSouthWest};
+	for (unsigned yy = 0; yy < h; yy++) {
+		for (unsigned xx = 0; xx < w; xx++) {
+			Node *node = g.get_node(xx, yy);
+			if (node->is_blocked()) {
+				continue;
+			}
+			uint32_t reg = region_of(xx, yy);
+			for (unsigned dd = 0; dd < sizeof(dirs) / sizeof(dirs[0]); dd++) {
+				Node *next = g.get_adjacent(node, dirs[dd]);
+				if (!next) {
+					continue;
+				}
+				uint32_t nreg = region_of(next->get_x(), next->get_y());
+				uint32_t lhs = find_root(parent, reg), rhs = find_root(parent, nreg);
+				if (lhs != rhs) {
+					parent[max(lhs, rhs)] = min(lhs, rhs);
+				}
+			}
+		}
+	}
+
+	// Componentes numeradas na ordem das suas primeiras regiões.
+	ncomps = 0;
+	for (uint32_t ii = 0; ii < regions.size(); ii++) {
+		uint32_t root = find_root(parent, ii);
+		regions[ii].comp = root == ii ? static_cast<uint32_t>(ncomps++) : regions[root].comp;
+	}
+}
+
+/*
+ * Nós de uma região, por posição no bloco: vizinhos na mesma região e o custo
+ * de cada passo. Um bloco tem no máximo 64 nós, e conjuntos de nós são
+ * máscaras de 64 bits.
+ */
+struct LocalGraph {
+	enum { MAX_NODES = CoarseGrid::BLOCK_SIDE * CoarseGrid::BLOCK_SIDE };
+	uint8_t count[MAX_NODES];
+	uint8_t next[MAX_NODES][MAX_NEIGHBOURS];
+	double cost[MAX_NODES][MAX_NEIGHBOURS];
+};
+
+/*
+ * Dijkstra dentro de uma região: dist (indexado pela posição no bloco) recebe
+ * a distância de cada nó de members ao nó mais próximo de sources. Com tão
+ * poucos nós, a fronteira é uma máscara e o menor é achado por varredura.
+ */
+static void local_distances(LocalGraph const &lg, uint64_t members, uint64_t sources,
+                            double *dist) {
+	for (uint64_t mask = members; mask; mask &= mask - 1) {
+		dist[__builtin_ctzll(mask)] = INFINITE_DIST;
+	}
+	for (uint64_t mask = sources; mask; mask &= mask - 1) {
+		dist[__builtin_ctzll(mask)] = 0;
+	}
+	uint64_t open = sources;
+	while (open) {
+		unsigned curr = __builtin_ctzll(open);
+		for (uint64_t mask = open & (open - 1); mask; mask &= mask - 1) {
+			unsigned pos = __builtin_ctzll(mask);
+			if (dist[pos] < dist[curr]) {
+				curr = pos;
+			}
+		}
+		open &= ~(uint64_t(1) << curr);
+		for (unsigned ee = 0; ee < lg.count[curr]; ee++) {
+			unsigned const pos = lg.next[curr][ee];
+			double nd = dist[curr] + lg.cost[curr][ee];
+			if (nd < dist[pos]) {
+				dist[pos] = nd;
+				open |= uint64_t(1) << pos;
+			}
+		}
+	}
+}
+
+/*
+ * Monta o grafo das entradas das regiões. Para cada região, acha as vizinhas
+ * e os nós da região que as tocam (os nós em que se entra vindo de cada uma),
+ * e calcula os custos das travessias com um Dijkstra dentro da região a
+ * partir dos nós que tocam cada vizinha.
+ */
+void CoarseGrid::build_entries(Graph &g, EntryGraph &eg) {
+	// Nós da região e pares (região vizinha tocada, posição).
+	LocalGraph inner;
+	vector<pair<uint32_t, uint8_t> > touch;
+	vector<size_t> tstart;
+	double dist[BLOCK_SIDE * BLOCK_SIDE];
+
+	eg.start.assign(1, 0);
+	eg.adj.clear();
+	eg.cstart.assign(1, 0);
+	eg.low.clear();
+	eg.high.clear();
+	eg.reach.clear();
+	eg.step = 0;
+	for (unsigned by = 0; by < bh; by++) {
+		for (unsigned bx = 0; bx < bw; bx++) {
+			unsigned const block = by * bw + bx;
+			unsigned const x0 = bx * BLOCK_SIDE, y0 = by * BLOCK_SIDE;
+			unsigned const x1 = min(x0 + BLOCK_SIDE, w), y1 = min(y0 + BLOCK_SIDE, h);
+			uint32_t const end = block + 1 < first.size() ? first[block + 1]
+			                                               : static_cast<uint32_t>(regions.size());
+			for (uint32_t reg = first[block]; reg < end; reg++) {
+				uint8_t const id = static_cast<uint8_t>(reg - first[block]);
+				uint64_t members = 0;
+				touch.clear();
+				for (unsigned yy = y0; yy < y1; yy++) {
+					for (unsigned xx = x0; xx < x1; xx++) {
+						if (local[static_cast<size_t>(yy) * w + xx] != id) {
+							continue;
+						}
+						uint8_t const pos = (yy - y0) * BLOCK_SIDE + (xx - x0);
+						members |= uint64_t(1) << pos;
+						inner.count[pos] = 0;
+						Node *node = g.get_node(xx, yy);
+						for (unsigned dd = 0; dd < sizeof(ALL_DIRS) / sizeof(ALL_DIRS[0]); dd++) {
+							Node *next = g.get_adjacent(node, ALL_DIRS[dd]);
+							if (!next) {
+								continue;
+							}
+							uint32_t nreg = region_of(next->get_x(), next->get_y());
+							if (nreg == reg) {
+								uint8_t npos = (next->get_y() - y0) * BLOCK_SIDE + (next->get_x() - x0);
+								inner.next[pos][inner.count[pos]] = npos;
+								inner.cost[pos][inner.count[pos]++] = Graph::distance(node, next);
+							} else {
+								touch.push_back(make_pair(nreg, pos));
+								eg.step = max(eg.step, Graph::distance(node, next));
+							}
+						}
+					}
+				}
+				sort(touch.begin(), touch.end());
+				touch.erase(unique(touch.begin(), touch.end()), touch.end());
+
+				// Vizinhas em ordem crescente; 'tstart' marca o início dos nós
+				// que tocam cada uma em touch.
+				size_t const abase = eg.adj.size();
+				tstart.clear();
+				for (size_t ii = 0; ii < touch.size(); ii++) {
+					if (ii == 0 || touch[ii].first != touch[ii - 1].first) {
+						eg.adj.push_back(touch[ii].first);
+						tstart.push_back(ii);
+					}
+				}
+				tstart.push_back(touch.size());
+				size_t const k = eg.adj.size() - abase;
+				size_t const cbase = eg.low.size();
+				eg.low.resize(cbase + k * k);
+				eg.high.resize(cbase + k * k);
+
+				// Travessias: a partir dos nós que tocam a vizinha jj, a
+				// distância até o mais próximo dos que tocam a vizinha ii é no
+				// mínimo a menor entre eles; e todos os que tocam ii estão a no
+				// máximo a maior de um dos que tocam jj, e todos os nós da
+				// região, a no máximo reach[jj].
+				for (size_t jj = 0; jj < k; jj++) {
+					uint64_t cells = 0;
+					for (size_t tt = tstart[jj]; tt < tstart[jj + 1]; tt++) {
+						cells |= uint64_t(1) << touch[tt].second;
+					}
+					local_distances(inner, members, cells, dist);
+					for (size_t ii = 0; ii < k; ii++) {
+						double lo = INFINITE_DIST, hi = 0;
+						for (size_t tt = tstart[ii]; tt < tstart[ii + 1]; tt++) {
+							lo = min(lo, dist[touch[tt].second]);
+							hi = max(hi, dist[touch[tt].second]);
+						}
+						eg.low[cbase + ii * k + jj] = lo;
+						eg.high[cbase + jj * k + ii] = hi;
+					}
+					double reach = 0;
+					for (uint64_t mask = members; mask; mask &= mask - 1) {
+						reach = max(reach, dist[__builtin_ctzll(mask)]);
+					}
+					eg.reach.push_back(reach);
+				}
+				eg.start.push_back(static_cast<uint32_t>(eg.adj.size()));
+				eg.cstart.push_back(eg.low.size());
+			}
+		}
+	}
+
+	// Os movimentos são simétricos: cada região está na lista das vizinhas.
+	eg.back.resize(eg.adj.size());
+	eg.owner.resize(eg.adj.size());
+	for (uint32_t reg = 0; reg < regions.size(); reg++) {
+		for (uint32_t vv = eg.start[reg]; vv < eg.start[reg + 1]; vv++) {
+			uint32_t nreg = eg.adj[vv];
+			vector<uint32_t>::const_iterator it = std::lower_bound(eg.adj.begin() + eg.start[nreg],
+			                                                       eg.adj.begin() + eg.start[nreg + 1], reg);
+			eg.back[vv] = static_cast<uint32_t>(it - eg.adj.begin());
+			eg.owner[vv] = reg;
+		}
+	}
+}
+
+/*
+ * Distâncias de uma região a todas as outras no grafo das entradas; a região
+ * de partida tem distância 0. O Dijkstra usa o menor custo de cada passo e de
+ * cada travessia, e a distância de uma entrada é um limite inferior para a de
+ * algum dos seus nós; low recebe os limites inferiores para todos os nós de
+ * cada região. Se high não for nulo, o mesmo caminho é refeito com os maiores
+ * custos, o que dá um limite superior para todos os nós de cada entrada, e
+ * high recebe os limites superiores para todos os nós de cada região.
+ */
+void CoarseGrid::distances_from(EntryGraph const &eg, uint32_t reg, vector<double> &low,
+                                vector<double> *high) const {
+	typedef pair<double, uint32_t> Entry;
+	uint32_t const NONE = ~uint32_t(0);
+	priority_queue<Entry, vector<Entry>, greater<Entry> > queue;
+	vector<double> vdist(eg.adj.size(), INFINITE_DIST);
+	// Vértice anterior no caminho mínimo, e vértices na ordem em que saem do heap.
+	vector<uint32_t> pred(eg.adj.size(), NONE), order;
+	order.reserve(eg.adj.size());
+	// Saídas da região de partida: só o passo até a vizinha.
+	for (uint32_t vv = eg.start[reg]; vv < eg.start[reg + 1]; vv++) {
+		uint32_t entry = eg.back[vv];
+		vdist[entry] = 1.0;
+		queue.push(Entry(1.0, entry));
+	}
+	while (!queue.empty()) {
+		Entry top = queue.top();
+		queue.pop();
+		if (top.first > vdist[top.second]) {
+			continue;
+		}
+		order.push_back(top.second);
+		uint32_t const curr = eg.owner[top.second];
+		uint32_t const base = eg.start[curr];
+		size_t const k = eg.start[curr + 1] - base;
+		double const *cross = &eg.low[eg.cstart[curr] + (top.second - base) * k];
+		for (size_t jj = 0; jj < k; jj++) {
+			uint32_t next = eg.back[base + jj];
+			double nd = top.first + cross[jj] + 1.0;
+			if (nd < vdist[next]) {
+				vdist[next] = nd;
+				pred[next] = top.second;
+				queue.push(Entry(nd, next));
+			}
+		}
+	}
+
+	// Inferior: a entrada mais próxima.
+	low.assign(regions.size(), INFINITE_DIST);
+	for (size_t ii = 0; ii < order.size(); ii++) {
+		uint32_t const curr = eg.owner[order[ii]];
+		low[curr] = min(low[curr], vdist[order[ii]]);
+	}
+	low[reg] = 0;
+	if (!high) {
+		return;
+	}
+
+	// Superior: o mesmo caminho com os maiores custos (os anteriores já foram
+	// refeitos), e depois qualquer nó da região a partir dos nós da entrada.
+	high->assign(regions.size(), INFINITE_DIST);
+	for (size_t ii = 0; ii < order.size(); ii++) {
+		uint32_t const vv = order[ii], prev = pred[vv];
+		if (prev == NONE) {
+			vdist[vv] = eg.step;
+		} else {
+			uint32_t const base = eg.start[eg.owner[prev]];
+			size_t const k = eg.start[eg.owner[prev] + 1] - base;
+			size_t const jj = eg.back[vv] - base;
+			vdist[vv] = vdist[prev] + eg.high[eg.cstart[eg.owner[prev]] + (prev - base) * k + jj] + eg.step;
+		}
+		uint32_t const curr = eg.owner[vv];
+		(*high)[curr] = min((*high)[curr], vdist[vv] + eg.reach[vv]);
+	}
+	(*high)[reg] = 0;
+}
+
+/*
+ * Escolhe os marcos entre as regiões da maior componente, cada um o mais
+ * longe possível dos anteriores (o primeiro é a região mais distante de uma
+ * região qualquer), e guarda os limites das distâncias de cada região a cada
+ * marco.
+ */
+void CoarseGrid::place_landmarks(EntryGraph const &eg) {
+	landmarks = 0;
+	lmcomp = 0;
+	if (regions.empty()) {
+		return;
+	}
+
+	vector<size_t> sizes(ncomps, 0);
+	for (size_t reg = 0; reg < regions.size(); reg++) {
+		sizes[regions[reg].comp]++;
+	}
+	lmcomp = static_cast<uint32_t>(max_element(sizes.begin(), sizes.end()) - sizes.begin());
+	uint32_t seed = 0;
+	while (regions[seed].comp != lmcomp) {
+		seed++;
+	}
+
+	// Distância de cada região ao marco mais próximo; antes do primeiro marco,
+	// à semente.
+	vector<double> low, high, mindist;
+	distances_from(eg, seed, mindist, 0);
+	for (landmarks = 0; landmarks < NUM_LANDMARKS; landmarks++) {
+		uint32_t mark = seed;
+		for (uint32_t reg = 0; reg < regions.size(); reg++) {
+			if (mindist[reg] < INFINITE_DIST && mindist[reg] > mindist[mark]) {
+				mark = reg;
+			}
+		}
+		distances_from(eg, mark, low, &high);
+		for (size_t reg = 0; reg < regions.size(); reg++) {
+			regions[reg].lmlow[landmarks] = low[reg];
+			regions[reg].lmhigh[landmarks] = high[reg];
+			mindist[reg] = landmarks == 0 ? low[reg] : min(mindist[reg], low[reg]);
+		}
+	}
+}
@@ -0,0 +1,175 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _COARSEGRID_H_
+#define _COARSEGRID_H_
+
+#include "graph.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+/*
+ * Versão reduzida do mapa, em blocos de BLOCK_SIDE x BLOCK_SIDE nós, calculada
+ * ao carregar o mapa. Há um só nível de blocos, e não uma pirâmide inteira: a
+ * rejeição de consultas e os limites abaixo só precisam dele.
+ *
+ * Cada bloco é resumido como livre, parcial ou bloqueado, e dividido nas
+ * regiões conexas (por dentro do bloco) que ele contém. As regiões de blocos
+ * vizinhos que se tocam são ligadas, o que dá as componentes conexas do mapa
+ * inteiro: consultas entre componentes distintas podem ser rejeitadas sem
+ * busca.
+ *
+ * As distâncias também são calculadas no nível dos blocos, em um grafo cujos
+ * vértices são as entradas de cada região vinda de cada região vizinha, e
+ * cujas arestas atravessam uma região, de uma entrada a uma saída. Cada
+ * aresta tem dois custos: o menor e o maior que a travessia (por dentro da
+ * região) e o passo até a próxima região podem custar, conforme o nó por
+ * onde se entrou. O grafo tem poucos vértices por bloco.
+ *
+ * Cada região guarda limites inferior e superior, calculados nesse grafo, para
+ * a distância de todos os seus nós a alguns marcos (regiões bem espalhadas
+ * pela maior componente). Pela desigualdade triangular (ALT), o limite
+ * inferior de uma região menos o superior de outra é um limite inferior para
+ * a distância entre quaisquer nós das duas. O limite é admissível, mas
+ * constante dentro de cada região, e portanto não é consistente: A* com ele
+ * tem que reabrir nós (veja ReopeningSuccessors).
+ *
+ * A memória cresce com o número de regiões, e não de nós, a não ser pelo
+ * índice da região de cada nó (um byte por nó).
+ */
+class CoarseGrid {
+public:
+	enum {
+		BLOCK_SIDE = 8,
+		NUM_LANDMARKS = 4
+	};
+
+	// Resumo de um bloco.
+	enum State {
+		eFree,		// Todos os nós são passáveis.
+		ePartial,	// Alguns nós são passáveis.
+		eBlocked,	// Nenhum nó é passável.
+		eNumStates
+	};
+
+	CoarseGrid() : w(0), h(0), bw(0), bh(0), ncomps(0), landmarks(0), lmcomp(0) {}
+
+	void build(Graph &g);
+
+	static char const *get_state_name(State st);
+	State get_state(unsigned bx, unsigned by) const {
+		return static_cast<State>(state[by * bw + bx]);
+	}
+	size_t count_blocks(State st) const;
+
+	// Número de regiões e de componentes conexas do mapa.
+	size_t get_num_regions() const      {	return regions.size();	}
+	size_t get_num_components() const   {	return ncomps;	}
+	size_t get_memory_usage() const;
+
+	// Se o nó (x, y) está dentro do mapa e é passável.
+	bool is_passable(int x, int y) const {
+		return x >= 0 && static_cast<unsigned>(x) < w && y >= 0 && static_cast<unsigned>(y) < h
+		    && local[static_cast<size_t>(y) * w + x] != NO_REGION;
+	}
+
+	// Região de um nó passável (veja is_passable).
+	uint32_t region_of(int x, int y) const {
+		unsigned block = (y / BLOCK_SIDE) * bw + x / BLOCK_SIDE;
+		return first[block] + local[static_cast<size_t>(y) * w + x];
+	}
+
+	// Se há algum caminho entre dois nós; falso se algum deles for bloqueado.
+	template <typename N>
+	bool reachable(N const *src, N const *dst) const {
+		if (!is_passable(src->get_x(), src->get_y())
+		    || !is_passable(dst->get_x(), dst->get_y())) {
+			return false;
+		}
+		return regions[region_of(src->get_x(), src->get_y())].comp
+		    == regions[region_of(dst->get_x(), dst->get_y())].comp;
+	}
+
+	/*
+	 * Limite inferior para a distância entre quaisquer nós de duas regiões da
+	 * mesma componente.
+	 */
+	double lower_bound(uint32_t lhs, uint32_t rhs) const {
+		Region const &rl = regions[lhs], &rr = regions[rhs];
+		// Os marcos só valem para a componente em que estão.
+		if (rl.comp != lmcomp || rr.comp != lmcomp) {
+			return 0;
+		}
+		double bound = 0;
+		for (unsigned ii = 0; ii < landmarks; ii++) {
+			bound = std::max(bound, std::max(rr.lmlow[ii] - rl.lmhigh[ii],
+			                                 rl.lmlow[ii] - rr.lmhigh[ii]));
+		}
+		return bound;
+	}
+
+private:
+	// Marca de nó bloqueado em local.
+	static uint8_t const NO_REGION = 0xff;
+
+	struct Region {
+		uint32_t comp;
+		// Limites das distâncias dos nós da região aos marcos.
+		double lmlow[NUM_LANDMARKS], lmhigh[NUM_LANDMARKS];
+	};
+
+	/*
+	 * Grafo das entradas das regiões, só usado ao calcular a grade. A entrada
+	 * ii de uma região r é vinda da região adj[start[r] + ii], e é o vértice
+	 * start[r] + ii, que pertence a owner[start[r] + ii] = r; back dá o
+	 * vértice da entrada correspondente na vizinha (vinda de r). A travessia
+	 * de r da entrada ii para a saída jj custa de low a high[cstart[r] +
+	 * ii * k + jj], com k = start[r + 1] - start[r], e o passo até a próxima
+	 * região de 1 a step. Todo nó de r está a no máximo reach[start[r] + ii]
+	 * de algum nó da entrada ii.
+	 */
+	struct EntryGraph {
+		std::vector<uint32_t> start, adj, back, owner;
+		std::vector<size_t> cstart;
+		std::vector<double> low, high, reach;
+		double step;
+	};
+
+	void label_blocks(Graph &g);
+	void link_regions(Graph &g);
+	void build_entries(Graph &g, EntryGraph &eg);
+	void place_landmarks(EntryGraph const &eg);
+	void distances_from(EntryGraph const &eg, uint32_t reg, std::vector<double> &low,
+	                    std::vector<double> *high) const;
+
+	unsigned w, h, bw, bh;
+	// Região de cada nó dentro do seu bloco.
+	std::vector<uint8_t> local;
+	// Resumo e primeira região de cada bloco.
+	std::vector<uint8_t> state;
+	std::vector<uint32_t> first;
+	std::vector<Region> regions;
+	size_t ncomps;
+	unsigned landmarks;
+	uint32_t lmcomp;
+};
+
+#endif // _COARSEGRID_H_
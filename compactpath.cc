@@ -0,0 +1,156 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "compactpath.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+// Versão do formato dos arquivos de caminhos.
+static unsigned const PATHS_VERSION = 1;
+
+void CompactPath::finish(int x, int y) {
+	reverse(runs.begin(), runs.end());
+	sx = x;
+	sy = y;
+}
+
+size_t CompactPath::get_num_steps() const {
+	size_t steps = 0;
+	for (size_t ii = 0; ii < runs.size(); ii++) {
+		steps += get_run_length(ii);
+	}
+	return steps;
+}
+
+void CompactPath::get_waypoints(vector<pair<int, int> > &points) const {
+	points.clear();
+	int x = sx, y = sy;
+	points.push_back(make_pair(x, y));
+	for (size_t ii = 0; ii < runs.size(); ii++) {
+		Direction dir = get_dir(ii);
+		int len = get_run_length(ii);
+		x += DIR_DX[dir] * len;
+		y += DIR_DY[dir] * len;
+		points.push_back(make_pair(x, y));
+	}
+}
+
+bool PathWriter::open(char const *fname, Format _fmt) {
+	close();
+	fout.open(fname, ios::out | ios::binary);
+	if (!fout.good()) {
+		return false;
+	}
+	fmt = _fmt;
+	buf.resize(BUFFER_SIZE);
+	used = paths = bytes = 0;
+	fout << "type paths\n"
+	     << "version " << PATHS_VERSION << '\n'
+	     << "format " << (fmt == eBinary ? "binary" : "text") << '\n'
+	     << "data\n";
+	return fout.good();
+}
+
+bool PathWriter::close() {
+	if (!fout.is_open()) {
+		return true;
+	}
+	flush();
+	bool ok = fout.good();
+	fout.close();
+	return ok;
+}
+
+void PathWriter::flush() {
+	if (used != 0) {
+		fout.write(&buf[0], used);
+		bytes += used;
+		used = 0;
+	}
+}
+
+void PathWriter::put(void const *data, size_t len) {
+	memcpy(reserve(len), data, len);
+	used += len;
+}
+
+void PathWriter::put_uint(uint32_t val) {
+	// Dígitos de trás para a frente.
+	char digits[10];
+	int len = 0;
+	do {
+		digits[len++] = '0' + val % 10;
+		val /= 10;
+	} while (val != 0);
+	char *out = reserve(len);
+	for (int ii = 0; ii < len; ii++) {
+		out[ii] = digits[len - 1 - ii];
+	}
+	used += len;
+}
+
+void PathWriter::put_int(int val) {
+	if (val < 0) {
+		put("-", 1);
+		put_uint(-static_cast<uint32_t>(val));
+	} else {
+		put_uint(val);
+	}
+}
+
+void PathWriter::write(char const *method, uint32_t id, CompactPath const &path) {
+	if (!fout.is_open()) {
+		return;
+	}
+	size_t namelen = strlen(method);
+	uint32_t nruns = path.get_num_runs();
+	if (fmt == eBinary) {
+		uint8_t len = static_cast<uint8_t>(min(namelen, static_cast<size_t>(255)));
+		int32_t start[2] = {path.get_start_x(), path.get_start_y()};
+		put(&len, 1);
+		put(method, len);
+		put(&id, sizeof(id));
+		put(start, sizeof(start));
+		put(&nruns, sizeof(nruns));
+		if (nruns != 0) {
+			put(path.get_runs(), nruns * sizeof(uint32_t));
+		}
+	} else {
+		static char const *const names[] = {"N", "NE", "E", "SE", "S", "SW", "W", "NW"};
+		put(method, namelen);
+		put(" ", 1);
+		put_uint(id);
+		put(" ", 1);
+		put_int(path.get_start_x());
+		put(" ", 1);
+		put_int(path.get_start_y());
+		put(" ", 1);
+		put_uint(nruns);
+		for (uint32_t ii = 0; ii < nruns; ii++) {
+			char const *name = names[path.get_dir(ii)];
+			put(" ", 1);
+			put(name, strlen(name));
+			put_uint(path.get_run_length(ii));
+		}
+		put("\n", 1);
+	}
+	paths++;
+}
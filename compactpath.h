@@ -0,0 +1,181 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _COMPACTPATH_H_
+#define _COMPACTPATH_H_
+
+#include "movement.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+/*
+ * Caminho compacto: a célula de origem e uma sequência de trechos retos, cada
+ * um com uma direção e um número de passos, guardados em 32 bits (direção nos
+ * 3 bits mais baixos). Um caminho de Dijkstra ou A* com k mudanças de direção
+ * ocupa k + 1 trechos; para JPS, cada salto entre jump points já é um trecho,
+ * e os extremos dos trechos são os próprios jump points.
+ */
+class CompactPath {
+public:
+	CompactPath() : sx(0), sy(0) {}
+
+	/*
+	 * Monta o caminho seguindo os pais a partir do destino, sem alocar nada
+	 * por nó (o vetor de trechos é reaproveitado entre chamadas). Pai e filho
+	 * têm que estar em linha reta, como nos saltos de JPS. Retorna false, com
+	 * o caminho vazio, se o destino não foi alcançado.
+	 */
+	template <typename N>
+	bool build(N const *dst) {
+		clear();
+		if (dst->get_parent() == 0) {
+			return false;
+		}
+		// Os trechos saem do destino para a origem, e são invertidos no fim.
+		N const *node = dst;
+		for (N const *prev = node->get_parent(); prev != 0;
+		     node = prev, prev = prev->get_parent()) {
+			int dx = node->get_x() - prev->get_x(), dy = node->get_y() - prev->get_y();
+			append(step_direction(sign(dx), sign(dy)), std::max(std::abs(dx), std::abs(dy)));
+		}
+		finish(node->get_x(), node->get_y());
+		return true;
+	}
+
+	void clear() {
+		runs.clear();
+		sx = sy = 0;
+	}
+
+	// Acrescenta len passos na direção dada, emendando com o último trecho se
+	// a direção for a mesma.
+	void append(Direction dir, uint32_t len) {
+		if (!runs.empty() && get_dir(runs.size() - 1) == dir) {
+			runs.back() += len << DIR_BITS;
+		} else {
+			runs.push_back((len << DIR_BITS) | dir);
+		}
+	}
+
+	/*
+	 * Termina um caminho montado de trás para a frente com append: inverte os
+	 * trechos e define a origem.
+	 */
+	void finish(int x, int y);
+
+	int get_start_x() const         {	return sx;	}
+	int get_start_y() const         {	return sy;	}
+	size_t get_num_runs() const     {	return runs.size();	}
+	Direction get_dir(size_t run) const {
+		return static_cast<Direction>(runs[run] & DIR_MASK);
+	}
+	uint32_t get_run_length(size_t run) const {
+		return runs[run] >> DIR_BITS;
+	}
+	uint32_t const *get_runs() const {
+		return runs.empty() ? 0 : &runs[0];
+	}
+
+	// Número de passos (vizinhos imediatos) do caminho inteiro.
+	size_t get_num_steps() const;
+
+	// Extremos dos trechos, da origem ao destino.
+	void get_waypoints(std::vector<std::pair<int, int> > &points) const;
+
+private:
+	enum {
+		DIR_BITS = 3,
+		DIR_MASK = (1 << DIR_BITS) - 1
+	};
+
+	static int sign(int v) {
+		return (v > 0) - (v < 0);
+	}
+
+	int sx, sy;
+	std::vector<uint32_t> runs;
+};
+
+/*
+ * Gravação em massa de caminhos compactos, com um buffer próprio grande, para
+ * exportar os caminhos de todos os experimentos sem formatação de iostream
+ * por coordenada. Em texto, cada caminho é uma linha
+ *     <método> <id> <x> <y> <trechos> <direção><passos>...
+ * com as direções como N, NE, E, ...; em binário, cada caminho é o tamanho do
+ * nome do método (1 byte), o nome, e id, x, y, o número de trechos e os
+ * trechos como inteiros de 32 bits. Os dois começam com um cabeçalho em texto.
+ */
+class PathWriter {
+public:
+	enum Format {
+		eText,
+		eBinary
+	};
+
+	PathWriter() : fmt(eText), used(0), paths(0), bytes(0) {}
+	~PathWriter() {
+		close();
+	}
+
+	bool open(char const *fname, Format _fmt);
+	// Grava o que estiver no buffer e fecha o arquivo; retorna se não houve erros.
+	bool close();
+	bool is_open() const            {	return fout.is_open();	}
+
+	void write(char const *method, uint32_t id, CompactPath const &path);
+
+	size_t get_paths_written() const    {	return paths;	}
+	size_t get_bytes_written() const    {	return bytes + used;	}
+
+private:
+	enum {
+		BUFFER_SIZE = 1 << 20
+	};
+
+	void flush();
+	// Garante espaço para pelo menos 'len' bytes no buffer.
+	char *reserve(size_t len) {
+		if (used + len > buf.size()) {
+			flush();
+			if (len > buf.size()) {
+				buf.resize(len);
+			}
+		}
+		return &buf[used];
+	}
+	void put(void const *data, size_t len);
+	void put_uint(uint32_t val);
+	void put_int(int val);
+
+	std::ofstream fout;
+	Format fmt;
+	std::vector<char> buf;
+	size_t used, paths, bytes;
+
+	// Não copiável: dono do arquivo.
+	PathWriter(PathWriter const &);
+	PathWriter &operator=(PathWriter const &);
+};
+
+#endif // _COMPACTPATH_H_
@@ -0,0 +1,248 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "compactsearch.h"
+#include "memstats.h"
+
+#include <algorithm>
+
+using namespace std;
+
+uint32_t const CompactSearch::NO_CELL;
+
+CompactSearch::CompactSearch(Graph &_g)
+	: g(_g), version(g.get_version()), w(g.get_width()), h(g.get_height()),
+	  heap((OpenCmp())), npool(0), slotbits(10), nslots(0),
+	  qsrc(0), qdst(0), tx(0), ty(0), found(false) {
+	Slot empty = {NO_CELL, 0};
+	slots.assign(static_cast<size_t>(1) << slotbits, empty);
+	moves.resize(static_cast<size_t>(w) * h);
+	state.resize(moves.size());
+	for (unsigned dir = 0; dir < 8; dir++) {
+		offs[dir] = DIR_DY[dir] * static_cast<int32_t>(w) + DIR_DX[dir];
+		step[dir] = DefaultMetric::cost(DIR_DX[dir], DIR_DY[dir]);
+	}
+	update_moves();
+}
+
+// Copia do grafo os passos permitidos a partir de cada célula.
+void CompactSearch::update_moves() {
+	for (unsigned jj = 0; jj < h; jj++) {
+		for (unsigned ii = 0; ii < w; ii++) {
+			Node const *node = g.get_node(ii, jj);
+			uint8_t mask = 0;
+			for (unsigned dir = 0; dir < 8 && !node->is_blocked(); dir++) {
+				if (g.get_adjacent(node, static_cast<Direction>(dir))) {
+					mask |= 1u << dir;
+				}
+			}
+			moves[static_cast<size_t>(jj) * w + ii] = mask;
+		}
+	}
+	version = g.get_version();
+}
+
+double CompactSearch::heuristic(uint32_t cell) const {
+	return DefaultMetric::cost(static_cast<int>(cell % w) - tx,
+	                           static_cast<int>(cell / w) - ty);
+}
+
+// Esvazia o conjunto e a tabela de abertos, mantendo a memória.
+void CompactSearch::reset_open() {
+	npool = 0;
+	freelist.clear();
+	if (nslots != 0) {
+		Slot empty = {NO_CELL, 0};
+		fill(slots.begin(), slots.end(), empty);
+		nslots = 0;
+	}
+}
+
+CompactSearch::Open *CompactSearch::find_open(uint32_t cell) {
+	size_t const mask = slots.size() - 1;
+	for (size_t pos = home_slot(cell); ; pos = (pos + 1) & mask) {
+		if (slots[pos].cell == cell) {
+			return &pool[slots[pos].index];
+		}
+		if (slots[pos].cell == NO_CELL) {
+			return 0;
+		}
+	}
+}
+
+CompactSearch::Open *CompactSearch::add_open(uint32_t cell) {
+	if (2 * (nslots + 1) > slots.size()) {
+		grow_slots();
+	}
+	uint32_t index;
+	if (!freelist.empty()) {
+		index = freelist.back();
+		freelist.pop_back();
+	} else {
+		if (npool == pool.size()) {
+			pool.push_back(Open());
+		}
+		index = static_cast<uint32_t>(npool++);
+	}
+	size_t const mask = slots.size() - 1;
+	size_t pos = home_slot(cell);
+	while (slots[pos].cell != NO_CELL) {
+		pos = (pos + 1) & mask;
+	}
+	slots[pos].cell = cell;
+	slots[pos].index = index;
+	nslots++;
+	Open *open = &pool[index];
+	open->cell = cell;
+	return open;
+}
+
+/*
+ * Tira a célula da tabela e devolve seu nó aos livres. Em vez de marcar a
+ * posição como removida, puxa para trás as posições seguintes da mesma
+ * sequência de sondagem, de modo que as buscas na tabela continuam parando
+ * na primeira posição vazia.
+ */
+void CompactSearch::remove_open(uint32_t cell) {
+	size_t const mask = slots.size() - 1;
+	size_t hole = home_slot(cell);
+	while (slots[hole].cell != cell) {
+		hole = (hole + 1) & mask;
+	}
+	freelist.push_back(slots[hole].index);
+	nslots--;
+	for (size_t pos = (hole + 1) & mask; slots[pos].cell != NO_CELL; pos = (pos + 1) & mask) {
+		// A posição pode ir para o buraco se sua origem não estiver entre o
+		// buraco (exclusive) e ela (inclusive), de forma circular.
+		size_t home = home_slot(slots[pos].cell);
+		if (((pos - home) & mask) >= ((pos - hole) & mask)) {
+			slots[hole] = slots[pos];
+			hole = pos;
+		}
+	}
+	slots[hole].cell = NO_CELL;
+}
+
+// Dobra a tabela de abertos, reinserindo as células.
+void CompactSearch::grow_slots() {
+	vector<Slot> old;
+	old.swap(slots);
+	slotbits++;
+	Slot empty = {NO_CELL, 0};
+	slots.assign(static_cast<size_t>(1) << slotbits, empty);
+	size_t const mask = slots.size() - 1;
+	for (vector<Slot>::const_iterator it = old.begin(); it != old.end(); ++it) {
+		if (it->cell == NO_CELL) {
+			continue;
+		}
+		size_t pos = home_slot(it->cell);
+		while (slots[pos].cell != NO_CELL) {
+			pos = (pos + 1) & mask;
+		}
+		slots[pos] = *it;
+	}
+}
+
+double CompactSearch::search(int sx, int sy, int _tx, int _ty, bool astar,
+                             size_t &ins, size_t &upd, size_t &pop) {
+	ins = upd = pop = 0;
+	found = false;
+	if (version != g.get_version()) {
+		update_moves();
+	}
+	if (!g.is_passable(sx, sy) || !g.is_passable(_tx, _ty)) {
+		return -1.0;
+	}
+	tx = _tx;
+	ty = _ty;
+	qsrc = static_cast<uint32_t>(sy) * w + sx;
+	qdst = static_cast<uint32_t>(ty) * w + tx;
+	fill(state.begin(), state.end(), 0);
+	reset_open();
+	heap.clear(OpenCmp());
+
+	Open *first = add_open(qsrc);
+	first->g = 0;
+	first->f = astar ? heuristic(qsrc) : 0;
+	set_state(qsrc, eOpen, 0);
+	heap.insert(first);
+	ins++;
+
+	double dist = -1.0;
+	while (!heap.empty()) {
+		Open *top = heap.extract();
+		pop++;
+		uint32_t cell = top->cell;
+		double gc = top->g;
+		// A distância de um nó expandido não é mais necessária.
+		remove_open(cell);
+		set_state(cell, eClosed, state[cell] & DIR_MASK);
+		if (cell == qdst) {
+			dist = gc;
+			found = true;
+			break;
+		}
+
+		for (unsigned dir = 0; dir < 8; dir++) {
+			if (!(moves[cell] & (1u << dir))) {
+				continue;
+			}
+			uint32_t next = cell + offs[dir];
+			Color clr = get_color(next);
+			if (clr == eClosed) {
+				continue;
+			}
+			double nd = gc + step[dir];
+			if (clr == eUnseen) {
+				Open *entry = add_open(next);
+				entry->g = nd;
+				entry->f = astar ? nd + heuristic(next) : nd;
+				set_state(next, eOpen, dir);
+				heap.insert(entry);
+				ins++;
+			} else {
+				Open *entry = find_open(next);
+				if (entry->g > nd) {
+					entry->g = nd;
+					entry->f = astar ? nd + heuristic(next) : nd;
+					set_state(next, eOpen, dir);
+					heap.update_elem(entry);
+					upd++;
+				}
+			}
+		}
+	}
+	MemStats::record_open_list(heap.get_peak_size());
+	return dist;
+}
+
+bool CompactSearch::get_path(CompactPath &path) const {
+	path.clear();
+	if (!found) {
+		return false;
+	}
+	// Cada célula aponta para o pai pela direção em que foi alcançada.
+	uint32_t cell = qdst;
+	while (cell != qsrc) {
+		unsigned dir = state[cell] & DIR_MASK;
+		path.append(static_cast<Direction>(dir), 1);
+		cell -= offs[dir];
+	}
+	path.finish(cell % w, cell / w);
+	return true;
+}
@@ -0,0 +1,165 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _COMPACTSEARCH_H_
+#define _COMPACTSEARCH_H_
+
+#include "compactpath.h"
+#include "graph.h"
+#include "heap.h"
+
+#include <stdint.h>
+
+#include <deque>
+#include <vector>
+
+/*
+ * Dijkstra e A* com estado compacto: em vez de pai, índice de heap, distância,
+ * cor e direção em cada Node (40 bytes), cada célula tem só um byte de estado
+ * da busca, com a direção em que foi alcançada (3 bits) e a cor (2 bits), e
+ * um byte com os passos permitidos a partir dela, copiados do grafo. O pai de
+ * uma célula é a vizinha na direção oposta, e o caminho é refeito seguindo as
+ * direções a partir do destino.
+ *
+ * As distâncias só existem para os nós abertos, junto com a posição no heap,
+ * em um conjunto de nós reaproveitados entre buscas (com uma lista de livres)
+ * e achados pela célula em uma tabela de endereçamento aberto; um nó volta
+ * para os livres ao ser expandido, pois com heurística consistente a
+ * distância dele não muda mais. Assim, a memória percorrida por expansão fica
+ * perto de 2 bytes por célula mais a fronteira, sem alocações por nó.
+ * Usa o modelo de movimento padrão (veja movement.h), e os passos são
+ * atualizados quando a versão do grafo muda.
+ */
+class CompactSearch {
+public:
+	explicit CompactSearch(Graph &_g);
+
+	/*
+	 * Busca o caminho mínimo de (sx, sy) a (tx, ty); sem 'astar', é Dijkstra.
+	 * Retorna a distância, ou um valor negativo se o destino for inalcançável;
+	 * os contadores são os mesmos de ShortestPath.
+	 */
+	double search(int sx, int sy, int tx, int ty, bool astar,
+	              size_t &ins, size_t &upd, size_t &pop);
+
+	/*
+	 * Caminho achado pela última busca, refeito pelas direções de chegada.
+	 * Retorna false, com o caminho vazio, se o destino não foi alcançado.
+	 */
+	bool get_path(CompactPath &path) const;
+
+	// Memória por célula e total do estado (sem contar a tabela de abertos).
+	static size_t get_bytes_per_cell() {
+		return 2;
+	}
+	size_t get_memory_usage() const {
+		return sizeof(*this) + moves.capacity() + state.capacity();
+	}
+
+private:
+	// Byte de estado: direção de chegada nos bits 0-2, cor nos bits 3-4.
+	enum {
+		DIR_MASK = 0x07,
+		COLOR_SHIFT = 3,
+		COLOR_MASK = 0x18
+	};
+	enum Color {
+		eUnseen,
+		eOpen,
+		eClosed
+	};
+
+	// Nó aberto: distância, prioridade e posição no heap.
+	struct Open {
+		double g, f;
+		uint32_t cell;
+		uint32_t heapindex;
+	};
+
+	struct OpenCmp {
+		bool operator()(Open const *lhs, Open const *rhs) const {
+			if (lhs->f != rhs->f)
+				return lhs->f < rhs->f;
+			// Mesmo desempate de AstarCmp: menor heurística, ou maior g.
+			return lhs->g > rhs->g;
+		}
+	};
+
+	struct GetIndex {
+		size_t operator()(Open const *open) const {
+			return open->heapindex;
+		}
+	};
+
+	struct SetIndex {
+		void operator()(Open *open, size_t index) const {
+			open->heapindex = static_cast<uint32_t>(index);
+		}
+	};
+
+	typedef Heap<Open, OpenCmp, GetIndex, SetIndex> OpenHeap;
+
+	// Posição da tabela de abertos: célula (NO_CELL se vazia) e índice do nó
+	// no conjunto.
+	struct Slot {
+		uint32_t cell, index;
+	};
+	static uint32_t const NO_CELL = ~static_cast<uint32_t>(0);
+
+	Color get_color(uint32_t cell) const {
+		return static_cast<Color>((state[cell] & COLOR_MASK) >> COLOR_SHIFT);
+	}
+	void set_state(uint32_t cell, Color clr, unsigned dir) {
+		state[cell] = static_cast<uint8_t>((clr << COLOR_SHIFT) | dir);
+	}
+	double heuristic(uint32_t cell) const;
+	void update_moves();
+
+	// Tabela de abertos.
+	size_t home_slot(uint32_t cell) const {
+		return (cell * 0x9e3779b1u) >> (32 - slotbits);
+	}
+	void reset_open();
+	Open *find_open(uint32_t cell);
+	Open *add_open(uint32_t cell);
+	void remove_open(uint32_t cell);
+	void grow_slots();
+
+	Graph &g;
+	unsigned version;
+	unsigned w, h;
+	int32_t offs[8];
+	double step[8];
+	std::vector<uint8_t> moves, state;
+	OpenHeap heap;
+	// Nós abertos: o deque não move os nós já criados ao crescer, e o heap
+	// pode guardar ponteiros para eles; 'npool' foram usados na busca atual.
+	std::deque<Open> pool;
+	std::vector<uint32_t> freelist;
+	size_t npool;
+	// Tabela de abertos, com 1 << slotbits posições, no máximo metade usada.
+	std::vector<Slot> slots;
+	unsigned slotbits;
+	size_t nslots;
+	// Última consulta.
+	uint32_t qsrc, qdst;
+	int tx, ty;
+	bool found;
+};
+
+#endif // _COMPACTSEARCH_H_
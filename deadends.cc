@@ -0,0 +1,435 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "deadends.h"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// Versão do formato do arquivo de regiões.
+static unsigned const DEADENDS_VERSION = 2;
+
+// Largura máxima de uma porta contraída em um único vértice.
+static unsigned const DOOR_MAX_WIDTH = 4;
+
+uint64_t DeadEnds::map_checksum(Graph &g) {
+	// FNV-1a sobre as dimensões e a passabilidade das células.
+	uint64_t hash = 14695981039346656037ULL;
+	uint64_t const prime = 1099511628211ULL;
+	unsigned const w = g.get_width(), h = g.get_height();
+	hash = (hash ^ w) * prime;
+	hash = (hash ^ h) * prime;
+	for (unsigned jj = 0; jj < h; jj++) {
+		for (unsigned ii = 0; ii < w; ii++) {
+			hash = (hash ^ (g.get_node(ii, jj)->is_blocked() ? 1 : 0)) * prime;
+		}
+	}
+	return hash;
+}
+
+namespace {
+	// Quadro da busca em profundidade iterativa; 'step' percorre as direções
+	// de cada célula do vértice.
+	struct Frame {
+		uint32_t cell, parent;
+		unsigned step;
+	};
+}
+
+/*
+ * Encontra as portas do mapa: trechos retos de 2 a DOOR_MAX_WIDTH células
+ * passáveis, horizontais ou verticais, com células bloqueadas (ou a borda)
+ * nas duas pontas. Cada porta vira um único vértice, representado pela sua
+ * primeira célula; 'rep' dá o representante de cada célula, e 'span' e
+ * 'vertical' o tamanho e a orientação de cada porta. Portas não se
+ * sobrepõem: as horizontais têm preferência.
+ *
+ * Contrair uma porta não altera os caminhos mínimos: um caminho que sai da
+ * porta e volta a ela pode ser trocado pelo trecho reto entre as duas
+ * células, que custa a distância octil entre elas e portanto não é mais
+ * longo. Assim, uma região só alcançável pela porta pode ser podada mesmo
+ * que a porta tenha mais de uma célula de largura, o que não acontece com
+ * articulações de células isoladas.
+ */
+static void find_doors(Graph &g, vector<uint32_t> &rep, vector<unsigned char> &span,
+                       vector<bool> &vertical) {
+	unsigned const w = g.get_width(), h = g.get_height();
+	size_t const ncells = static_cast<size_t>(w) * h;
+	rep.resize(ncells);
+	for (size_t ii = 0; ii < ncells; ii++) {
+		rep[ii] = static_cast<uint32_t>(ii);
+	}
+	span.assign(ncells, 1);
+	vertical.assign(ncells, false);
+
+	for (int dir = 0; dir < 2; dir++) {
+		// Linhas (dir = 0) ou colunas (dir = 1) do mapa.
+		unsigned const nlines = dir ? w : h, len = dir ? h : w;
+		size_t const stride = dir ? w : 1, linestride = dir ? 1 : w;
+		for (unsigned line = 0; line < nlines; line++) {
+			unsigned pos = 0;
+			while (pos < len) {
+				size_t const first = line * linestride + pos * stride;
+				if (g.get_node(first % w, first / w)->is_blocked()) {
+					pos++;
+					continue;
+				}
+				// Trecho maximal de células passáveis a partir de pos.
+				unsigned end = pos + 1;
+				bool free = span[first] == 1 && rep[first] == first;
+				while (end < len) {
+					size_t const cell = first + (end - pos) * stride;
+					if (g.get_node(cell % w, cell / w)->is_blocked()) {
+						break;
+					}
+					free = free && span[cell] == 1 && rep[cell] == cell;
+					end++;
+				}
+				unsigned const width = end - pos;
+				if (free && width >= 2 && width <= DOOR_MAX_WIDTH) {
+					for (unsigned ii = 1; ii < width; ii++) {
+						rep[first + ii * stride] = static_cast<uint32_t>(first);
+					}
+					span[first] = static_cast<unsigned char>(width);
+					vertical[first] = dir != 0;
+				}
+				pos = end;
+			}
+		}
+	}
+}
+
+void DeadEnds::build(Graph &g) {
+	w = g.get_width();
+	h = g.get_height();
+	checksum = map_checksum(g);
+	active = false;
+
+	size_t const ncells = static_cast<size_t>(w) * h;
+	cellnode.assign(ncells, NONE);
+	tree.clear();
+
+	// Vértices do grafo contraído (veja find_doors).
+	vector<uint32_t> rep;
+	vector<unsigned char> span;
+	vector<bool> vertical;
+	find_doors(g, rep, span, vertical);
+
+	// Tempos de descoberta (0 = não visitada) e low-links de Tarjan, por
+	// vértice (célula representante).
+	vector<uint32_t> disc(ncells, 0), low(ncells, 0);
+	// Bloco em que a célula aparece sem ser o topo (o vértice de corte pelo
+	// qual o bloco se liga ao resto da árvore).
+	vector<uint32_t> block(ncells, NONE);
+	vector<bool> cut(ncells, false);
+	// Topo de cada bloco.
+	vector<uint32_t> top;
+	vector<uint32_t> stack, compcells;
+	vector<Frame> frames;
+	uint32_t timer = 0;
+
+	for (unsigned jj = 0; jj < h; jj++) {
+		for (unsigned ii = 0; ii < w; ii++) {
+			uint32_t const root = static_cast<uint32_t>(jj * w + ii);
+			if (g.get_node(ii, jj)->is_blocked() || rep[root] != root || disc[root] != 0) {
+				continue;
+			}
+
+			uint32_t const firstblock = static_cast<uint32_t>(tree.size());
+			uint32_t rootblock = NONE;
+			unsigned rootchildren = 0;
+			compcells.clear();
+			disc[root] = low[root] = ++timer;
+			stack.push_back(root);
+			compcells.push_back(root);
+			Frame first = {root, NONE, 0};
+			frames.push_back(first);
+
+			while (!frames.empty()) {
+				Frame &fr = frames.back();
+				if (fr.step < 8u * span[fr.cell]) {
+					uint32_t const from = fr.cell + (fr.step / 8) * (vertical[fr.cell] ? w : 1);
+					Direction const dir = static_cast<Direction>(fr.step++ % 8);
+					Node *next = g.get_adjacent(g.get_node(from % w, from / w), dir);
+					if (!next) {
+						continue;
+					}
+					uint32_t cell = rep[static_cast<uint32_t>(next->get_y()) * w + next->get_x()];
+					if (cell == fr.cell) {
+						// Entre células da mesma porta.
+						continue;
+					}
+					if (disc[cell] == 0) {
+						disc[cell] = low[cell] = ++timer;
+						stack.push_back(cell);
+						compcells.push_back(cell);
+						Frame child = {cell, fr.cell, 0};
+						frames.push_back(child);
+					} else if (cell != fr.parent) {
+						low[fr.cell] = min(low[fr.cell], disc[cell]);
+					}
+					continue;
+				}
+
+				uint32_t const cell = fr.cell, parent = fr.parent;
+				frames.pop_back();
+				if (parent == NONE) {
+					continue;
+				}
+				low[parent] = min(low[parent], low[cell]);
+				if (low[cell] < disc[parent]) {
+					continue;
+				}
+				// O pai separa a subárvore de cell: fecha um bloco.
+				uint32_t const blk = static_cast<uint32_t>(tree.size());
+				Tree node = {NONE, NONE, 0, 0, 0, false};
+				tree.push_back(node);
+				top.push_back(parent);
+				uint32_t member;
+				do {
+					member = stack.back();
+					stack.pop_back();
+					block[member] = blk;
+				} while (member != cell);
+				if (parent == root) {
+					rootblock = blk;
+					rootchildren++;
+				} else {
+					cut[parent] = true;
+				}
+			}
+			stack.clear();
+
+			// A raiz da busca só é articulação se tiver mais de um filho.
+			cut[root] = rootchildren > 1;
+			if (rootchildren == 0) {
+				// Célula isolada: um bloco só para ela.
+				rootblock = static_cast<uint32_t>(tree.size());
+				Tree node = {NONE, NONE, 0, 0, 0, false};
+				tree.push_back(node);
+				top.push_back(root);
+			}
+			for (vector<uint32_t>::iterator it = compcells.begin();
+			     it != compcells.end(); ++it) {
+				if (cut[*it]) {
+					Tree node = {*it == root ? NONE : block[*it], NONE, 0, 0, 0, true};
+					cellnode[*it] = static_cast<uint32_t>(tree.size());
+					tree.push_back(node);
+				} else {
+					cellnode[*it] = *it == root ? rootblock : block[*it];
+				}
+			}
+			for (uint32_t blk = firstblock; blk < top.size(); blk++) {
+				if (cut[top[blk]]) {
+					tree[blk].parent = cellnode[top[blk]];
+				}
+			}
+			// Os nós das articulações vêm depois dos blocos em tree.
+			top.resize(tree.size(), NONE);
+		}
+	}
+	// As demais células de cada porta ficam no nó do representante.
+	for (size_t cell = 0; cell < ncells; cell++) {
+		if (rep[cell] != cell) {
+			cellnode[cell] = cellnode[rep[cell]];
+		}
+	}
+
+	number_tree();
+}
+
+/*
+ * Numera a floresta em pré-ordem (tin, tout), e calcula a profundidade e a
+ * raiz de cada nó. Depende apenas de parent.
+ */
+void DeadEnds::number_tree() {
+	uint32_t const ntree = static_cast<uint32_t>(tree.size());
+	// Filhos de cada nó, agrupados por pai.
+	vector<uint32_t> first(ntree + 1, 0), children(ntree);
+	for (uint32_t ii = 0; ii < ntree; ii++) {
+		if (tree[ii].parent != NONE) {
+			first[tree[ii].parent + 1]++;
+		}
+	}
+	for (uint32_t ii = 0; ii < ntree; ii++) {
+		first[ii + 1] += first[ii];
+	}
+	vector<uint32_t> fill(first.begin(), first.end() - 1);
+	for (uint32_t ii = 0; ii < ntree; ii++) {
+		if (tree[ii].parent != NONE) {
+			children[fill[tree[ii].parent]++] = ii;
+		}
+	}
+
+	uint32_t timer = 0;
+	// Pilha de (nó, próximo filho).
+	vector<pair<uint32_t, uint32_t> > stack;
+	for (uint32_t root = 0; root < ntree; root++) {
+		if (tree[root].parent != NONE) {
+			continue;
+		}
+		tree[root].depth = 0;
+		tree[root].root = root;
+		tree[root].tin = timer++;
+		stack.push_back(make_pair(root, first[root]));
+		while (!stack.empty()) {
+			pair<uint32_t, uint32_t> &top = stack.back();
+			if (top.second == first[top.first + 1]) {
+				tree[top.first].tout = timer - 1;
+				stack.pop_back();
+				continue;
+			}
+			uint32_t child = children[top.second++];
+			tree[child].depth = tree[top.first].depth + 1;
+			tree[child].root = root;
+			tree[child].tin = timer++;
+			stack.push_back(make_pair(child, first[child]));
+		}
+	}
+}
+
+void DeadEnds::set_query(int sx, int sy, int dx, int dy) {
+	active = false;
+	if (cellnode.empty()) {
+		return;
+	}
+	qsrc = cellnode[static_cast<size_t>(sy) * w + sx];
+	qdst = cellnode[static_cast<size_t>(dy) * w + dx];
+	if (qsrc == NONE || qdst == NONE || tree[qsrc].root != tree[qdst].root) {
+		return;
+	}
+	// Componente com um único bloco: não há o que podar.
+	Tree const &root = tree[tree[qsrc].root];
+	if (root.tin == root.tout) {
+		return;
+	}
+	// Ancestral comum mais profundo, subindo pela árvore.
+	uint32_t lhs = qsrc, rhs = qdst;
+	while (tree[lhs].depth > tree[rhs].depth) {
+		lhs = tree[lhs].parent;
+	}
+	while (tree[rhs].depth > tree[lhs].depth) {
+		rhs = tree[rhs].parent;
+	}
+	while (lhs != rhs) {
+		lhs = tree[lhs].parent;
+		rhs = tree[rhs].parent;
+	}
+	qlca = lhs;
+	active = true;
+}
+
+size_t DeadEnds::get_num_blocks() const {
+	size_t count = 0;
+	for (vector<Tree>::const_iterator it = tree.begin(); it != tree.end(); ++it) {
+		count += it->cut ? 0 : 1;
+	}
+	return count;
+}
+
+size_t DeadEnds::get_num_cuts() const {
+	return tree.size() - get_num_blocks();
+}
+
+size_t DeadEnds::count_pruned() const {
+	size_t count = 0;
+	for (unsigned jj = 0; jj < h; jj++) {
+		for (unsigned ii = 0; ii < w; ii++) {
+			count += is_pruned(ii, jj) ? 1 : 0;
+		}
+	}
+	return count;
+}
+
+/*
+ * Formato: cabeçalho em texto (como o dos mapas) seguido dos dados binários:
+ * o nó da árvore de cada célula, em ordem de linhas, e o pai e o tipo de cada
+ * nó da árvore. O resto da árvore é recalculado na leitura.
+ */
+bool DeadEnds::save(char const *fname) const {
+	ofstream fout(fname, ios::out | ios::binary);
+	if (!fout.good()) {
+		return false;
+	}
+	fout << "type deadends\n"
+	     << "version " << DEADENDS_VERSION << '\n'
+	     << "height " << h << '\n'
+	     << "width " << w << '\n'
+	     << "checksum " << checksum << '\n'
+	     << "nodes " << tree.size() << '\n'
+	     << "data\n";
+	fout.write(reinterpret_cast<char const *>(&cellnode[0]),
+	           cellnode.size() * sizeof(uint32_t));
+	for (vector<Tree>::const_iterator it = tree.begin(); it != tree.end(); ++it) {
+		char cutflag = it->cut ? 1 : 0;
+		fout.write(reinterpret_cast<char const *>(&it->parent), sizeof(uint32_t));
+		fout.write(&cutflag, 1);
+	}
+	return fout.good();
+}
+
+bool DeadEnds::load(char const *fname, Graph &g, ostream &err) {
+	ifstream fin(fname, ios::in | ios::binary);
+	if (!fin.good()) {
+		return false;
+	}
+	string hdr, sv, sh, sw, sc, sn, sd;
+	unsigned ver, lh, lw;
+	uint64_t sum;
+	size_t ntree;
+	getline(fin, hdr);
+	fin >> sv >> ver >> sh >> lh >> sw >> lw >> sc >> sum >> sn >> ntree >> sd;
+	if (!fin.good() || hdr != "type deadends" || sv != "version" || sh != "height"
+	    || sw != "width" || sc != "checksum" || sn != "nodes" || sd != "data") {
+		err << "Regioes '" << fname << "' invalidas." << endl;
+		return false;
+	}
+	if (ver != DEADENDS_VERSION || lw != g.get_width() || lh != g.get_height()
+	    || sum != map_checksum(g)) {
+		// Desatualizado: outro formato ou outro mapa.
+		return false;
+	}
+	fin.ignore(1);
+
+	w = lw;
+	h = lh;
+	checksum = sum;
+	active = false;
+	cellnode.resize(static_cast<size_t>(w) * h);
+	fin.read(reinterpret_cast<char *>(&cellnode[0]),
+	         cellnode.size() * sizeof(uint32_t));
+	Tree init = {NONE, NONE, 0, 0, 0, false};
+	tree.assign(ntree, init);
+	for (vector<Tree>::iterator it = tree.begin(); it != tree.end(); ++it) {
+		char cutflag;
+		fin.read(reinterpret_cast<char *>(&it->parent), sizeof(uint32_t));
+		fin.read(&cutflag, 1);
+		it->cut = cutflag != 0;
+	}
+	if (!fin.good()) {
+		err << "Regioes '" << fname << "' invalidas." << endl;
+		cellnode.clear();
+		tree.clear();
+		return false;
+	}
+	number_tree();
+	return true;
+}
@@ -0,0 +1,133 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _DEADENDS_H_
+#define _DEADENDS_H_
+
+#include "graph.h"
+
+#include <stdint.h>
+
+#include <iostream>
+#include <vector>
+
+/*
+ * Regiões sem saída ("dead ends") de um mapa, para podar buscas.
+ *
+ * Um caminho simples entre dois nós só passa pelos componentes biconexos
+ * (blocos) que estão no caminho entre eles na árvore de blocos e articulações
+ * do grafo. Tudo que está pendurado fora desse caminho (salas com uma única
+ * porta, becos, e salas dentro delas, em qualquer profundidade) não pode
+ * fazer parte de um caminho mínimo, a menos que contenha a origem ou o
+ * destino, e pode ser ignorado pela busca.
+ *
+ * Antes disso, as portas estreitas (trechos retos curtos entre obstáculos)
+ * são contraídas em um único vértice cada, de modo que uma porta de mais de
+ * uma célula de largura também pode separar regiões; veja find_doors em
+ * deadends.cc.
+ *
+ * A árvore é calculada uma vez por mapa (build, ou load de um arquivo gravado
+ * por save); a cada consulta, set_query prepara a poda para a origem e o
+ * destino, e is_pruned diz se um nó pode ser ignorado.
+ */
+class DeadEnds {
+public:
+	DeadEnds() : w(0), h(0), checksum(0), active(false) {}
+
+	// Calcula as regiões do mapa (algoritmo de Tarjan, iterativo).
+	void build(Graph &g);
+
+	/*
+	 * Lê as regiões gravadas por save. Falha se o arquivo não existir, estiver
+	 * em outra versão do formato ou tiver sido calculado para outro mapa (ou
+	 * para outra versão do mesmo mapa). Os erros de leitura são escritos em err.
+	 */
+	bool load(char const *fname, Graph &g, std::ostream &err = std::cerr);
+	bool save(char const *fname) const;
+
+	// Nó (da árvore) de uma célula; NONE para células bloqueadas.
+	static uint32_t const NONE = ~static_cast<uint32_t>(0);
+
+	// Prepara a poda para uma consulta. Se origem e destino estiverem em
+	// componentes distintos, nada é podado.
+	template <typename N>
+	void set_query(N const *src, N const *dst) {
+		set_query(src->get_x(), src->get_y(), dst->get_x(), dst->get_y());
+	}
+	void set_query(int sx, int sy, int dx, int dy);
+
+	// Se a célula pode ser ignorada pela consulta atual.
+	bool is_pruned(int x, int y) const {
+		if (!active) {
+			return false;
+		}
+		uint32_t node = cellnode[static_cast<size_t>(y) * w + x];
+		if (node == NONE || tree[node].root != tree[qsrc].root) {
+			return false;
+		}
+		if (on_path(node)) {
+			return false;
+		}
+		// Uma articulação também pertence ao bloco pai e aos blocos filhos,
+		// e pode ser atravessada se algum deles estiver no caminho. Um filho
+		// só pode estar no caminho sem a articulação se for o topo dele.
+		Tree const &tn = tree[node];
+		return !(tn.cut && ((tn.parent != NONE && on_path(tn.parent))
+		                    || tree[qlca].parent == node));
+	}
+
+	// Estatísticas.
+	size_t get_num_blocks() const;
+	size_t get_num_cuts() const;
+	// Células que a consulta atual ignora (percorre o mapa todo).
+	size_t count_pruned() const;
+
+	// Soma de verificação da passabilidade do mapa, usada por load.
+	static uint64_t map_checksum(Graph &g);
+
+private:
+	// Nó da árvore de blocos e articulações.
+	struct Tree {
+		uint32_t parent, root, depth;
+		// Intervalo de pré-ordem da subárvore: [tin, tout].
+		uint32_t tin, tout;
+		// Se o nó é uma articulação (ou um bloco).
+		bool cut;
+	};
+
+	bool is_ancestor(uint32_t anc, uint32_t node) const {
+		return tree[anc].tin <= tree[node].tin && tree[node].tout <= tree[anc].tout;
+	}
+	// Se o nó da árvore está no caminho entre origem e destino.
+	bool on_path(uint32_t node) const {
+		return node == qlca || is_ancestor(node, qsrc) != is_ancestor(node, qdst);
+	}
+
+	void number_tree();
+
+	unsigned w, h;
+	uint64_t checksum;
+	std::vector<uint32_t> cellnode;
+	std::vector<Tree> tree;
+
+	// Consulta atual.
+	bool active;
+	uint32_t qsrc, qdst, qlca;
+};
+
+#endif // _DEADENDS_H_
@@ -17,500 +17,765 @@
  */
 
 #include "ScenarioLoader.h"
+#include "allocstats.h"
+#include "bench.h"
+#include "coarsegrid.h"
+#include "compactsearch.h"
+#include "deadends.h"
+#include "fringe.h"
+#include "goalbounds.h"
 #include "graph.h"
-#include "heap.h"
-
+#include "memstats.h"
+#include "pathengine.h"
+#include "perfcounters.h"
+#include "querycache.h"
+#include "runners.h"
+#include "simdsearch.h"
+#include "tiledgraph.h"
+
+#include <sys/resource.h>
 #include <sys/time.h>
+#include <unistd.h>
 
-#include <cmath>
-#include <iostream>
+#include <cstdlib>
 #include <iomanip>
-#include <list>
+#include <iostream>
 #include <string>
 
 using namespace std;
 
-#if defined(__GNUC__) 
-# define UNUSED(x) UNUSED_ ## x __attribute__((unused))
-#else
-# define UNUSED(x) x 
-#endif
+/*
+ * Imprime as características de um mapa em blocos recém aberto.
+ */
+void dump_map_info(TiledGraph const &g, string const &mapname) {
+	cout << "#### map = " << mapname
+	     << ", size = " << g.get_width() << "x" << g.get_height()
+	     << ", cells = " << 1.0 * g.get_width() * g.get_height()
+	     << ", tile = " << g.get_tile_side() << "x" << g.get_tile_side()
+	     << ", tilebytes = " << g.get_tile_bytes()
+	     << ", tilebudget = " << g.get_tile_budget() / 1024 << " kB"
+	     << ", nodebudget = " << g.get_node_budget() / 1024 << " kB"
+	     << ", node = " << TiledGraph::get_node_bytes() << " B ####" << endl;
+}
+
+// Nós que não puderam ser criados por falta de memória; só mapas em blocos
+// têm orçamento (veja TiledGraph).
+static size_t node_failures(Graph const &UNUSED(g)) {
+	return 0;
+}
+
+static size_t node_failures(TiledGraph const &g) {
+	return g.get_node_failures();
+}
 
-//#define PRINT_PATH 1
+// Imprime o aviso de uma consulta abandonada por exceder o orçamento.
+static void dump_budget_exceeded(char const *method, size_t budget) {
+	cout << method << endl
+	     << "memory budget exceeded (" << budget / 1024 << " kB)" << endl;
+}
 
-static inline double usec2sec(timeval const &tim) {
-	return tim.tv_sec + (tim.tv_usec / 1000000.0);
+// Imprime o uso do cache de blocos de um mapa em blocos.
+void dump_tile_stats(TiledGraph const &g) {
+	cout << "#### tiles: loads = " << g.get_tile_loads()
+	     << ", evictions = " << g.get_tile_evictions()
+	     << ", resident = " << g.get_resident_tiles() * g.get_tile_bytes() / 1024 << " kB"
+	     << ", peaknodes = " << g.get_peak_nodes()
+	     << ", rss = " << MemStats::get_resident_bytes() / 1024 << " kB ####" << endl;
 }
 
-static inline double delta_t(timeval const &start, timeval const &finish) {
-	return usec2sec(finish) - usec2sec(start);
+/*
+ * Imprime o consumo de memória de um mapa recém carregado.
+ */
+void dump_map_info(Graph const &g, string const &mapname) {
+	cout << "#### map = " << mapname
+	     << ", size = " << g.get_width() << "x" << g.get_height()
+	     << ", cells = " << g.get_width() * g.get_height()
+	     << ", layout = " << Graph::get_layout_name(g.get_layout())
+	     << ", nodes = " << g.get_num_nodes() << ", ";
+	MemStats::dump_node_layout(cout);
+	cout << ", graph = " << g.get_memory_usage() / 1024 << " kB"
+	     << ", heapalloc = " << AllocStats::get_live_bytes() / 1024 << " kB"
+	     << ", rss = " << MemStats::get_resident_bytes() / 1024 << " kB ####" << endl;
 }
 
-// Functor de comparação para algoritmo de Dijkstra.
-struct DijkstraCmp {
-	bool operator()(Node const *lhs, Node const *rhs) {
-		return lhs->get_distance() < rhs->get_distance();
-	}
-};
-
-// Functor de comparação para A* e derivados (inclusive JPS).
-struct AstarCmp {
-	AstarCmp(Node const *dest) : target(dest) {		}
-
-	bool operator()(Node const *lhs, Node const *rhs) {
-		double dlhs = lhs->distance_to(target), drhs = rhs->distance_to(target);
-#if 0
-		return lhs->get_distance() + dlhs < rhs->get_distance() + drhs;
-#else
-		double dl = lhs->get_distance() + dlhs, dr = rhs->get_distance() + drhs;
-		// Se os nós não empataram, retorne o resultado da comparação.
-		if (dl != dr)
-			return dl < dr;
-		// Caso contrário, vamos desempatar para tornar a busca mais eficiente.
-		// O critério de desempate é o nó com menor custo heurístico.
-		return dlhs < drhs;
+// Ordem dos nós na memória dos grafos carregados, selecionável com -l.
+static Graph::Layout layout = Graph::eRowMajor;
+
+// Memória para os blocos e para os nós de mapas em blocos (.tmap),
+// selecionáveis com -B e -N.
+static size_t tilebudget = 64 * 1024 * 1024;
+static size_t nodebudget = 256 * 1024 * 1024;
+
+// Se as regiões sem saída devem ser podadas (-P).
+static bool prune = false;
+
+// Se os passos devem ser podados com goal bounding (-G).
+static bool bounding = false;
+
+// Cache de consultas (-Q); 0 se desligado.
+static QueryCache *cache = 0;
+
+// Consultas derivadas de cada experimento respondidas pelo cache (-q).
+static unsigned derived = 0;
+
+// Se o mapa dado está no formato em blocos (veja TiledGraph).
+static bool is_tiled_map(string const &mapname) {
+	string const ext = ".tmap";
+	return mapname.size() >= ext.size()
+	    && mapname.compare(mapname.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+/*
+ * Como run_method, mas com a consulta feita por um PathEngine, que reusa os
+ * heaps e só reinicia os nós alterados pela consulta anterior.
+ */
+template <typename G>
+void run_query(BasicPathEngine<G> &engine, typename G::node_type *src,
+               typename G::node_type const *dst, typename BasicPathEngine<G>::Algorithm alg,
+               typename BasicPathEngine<G>::Options const &opts,
+               Experiment const &exp, char const *method, char const *tag,
+               PerfCounters *perf, BucketStats &stats, double bound = 1.0) {
+	timeval start, finish;
+
+#ifdef PROFILE_PHASES
+	Profiler::reset();
 #endif
+	AllocStats::begin_query();
+	if (perf) {
+		perf->start();
 	}
-private:
-	Node const *target;
-};
-
-// Functor para obter índice dos vértices.
-struct GetIndex {
-	size_t operator() (Node const *node) {
-		return node->get_heapindex();
+	size_t failures = node_failures(engine.get_graph());
+	gettimeofday(&start, NULL);
+	for (int cnt = 0; cnt < MAXCNT; cnt++) {
+		engine.find_path(src, dst, alg, opts);
 	}
-};
-
-// Functor para modificar índice dos vértices.
-struct SetIndex {
-	void operator() (Node *node, size_t index) {
-		node->set_heapindex(index);
+	gettimeofday(&finish, NULL);
+	if (perf) {
+		perf->stop();
+	}
+	if (node_failures(engine.get_graph()) != failures) {
+		// Faltaram nós: o resultado não é confiável.
+		dump_budget_exceeded(method, nodebudget);
+		return;
 	}
-};
+
+	size_t ins = engine.get_inserts(), upd = engine.get_updates(), pop = engine.get_pops();
+	double time = delta_t(start, finish) / MAXCNT;
+	dump_path_info(dst, method, ins, upd, pop, exp.GetDistance(), time, perf, MAXCNT, bound);
+	export_path(dst, tag);
+#ifdef PROFILE_PHASES
+	dump_phases(MAXCNT);
+#endif
+	stats.add(exp.GetBucket(), tag, ins, upd, pop, time,
+	          path_error(dst, exp.GetDistance()), perf, MAXCNT);
+}
 
 /*
- * Functor que insere os vizinhos no heap para Dijkstra e A*.
+ * Como run_method, para Fringe Search. Imprime também os nós examinados em
+ * todas as passadas, que correspondem às extrações do heap em A*.
  */
-struct DijkstraSuccessors {
-	template <typename H>
-	void operator()(Node *node, Node *UNUSED(src), Node const *UNUSED(dst), Graph &g, H &heap,
-	                size_t &ins, size_t &upd) {
-		// Todos nós adjacentes não-bloqueados são sucessores.
-		vector<Node *> adj = g.get_adjacent_list(node);
-		for (vector<Node *>::iterator it = adj.begin(); it != adj.end(); ++it) {
-			Node *next = *it;
-			if (next->already_done()) {
-				continue;
-			}
-			// "Relax" no Cormen.
-			double dst = node->get_distance() + node->distance_to(next);
-			if (next->get_distance() > dst) {
-				next->set_distance(dst);
-				next->set_parent(node);
-				if (next->still_unseen()) {
-					// Nó não foi visto ainda, então não está no heap.
-					next->mark_seen();
-					heap.insert(next);
-					ins++;
-				} else {
-					heap.update_elem(next);
-					upd++;
-				}
+template <typename G>
+void run_fringe(G &g, typename G::node_type *src, typename G::node_type const *dst,
+                Experiment const &exp, PerfCounters *perf, BucketStats &stats) {
+	size_t ins, upd, pop, visits, passes;
+	timeval start, finish;
+	FringeSearch<G> fringe(g);
+
+	AllocStats::begin_query();
+	if (perf) {
+		perf->start();
+	}
+	gettimeofday(&start, NULL);
+	for (int cnt = 0; cnt < MAXCNT; cnt++) {
+		fringe.search(src, dst, ins, upd, pop, visits, passes);
+	}
+	gettimeofday(&finish, NULL);
+	if (perf) {
+		perf->stop();
+	}
+
+	double time = delta_t(start, finish) / MAXCNT;
+	dump_path_info(dst, "==== Fringe ======", ins, upd, pop, exp.GetDistance(), time,
+	               perf, MAXCNT);
+	cout << "visits = " << setw(6) << visits << ", passes = " << setw(6) << passes << endl;
+	export_path(dst, "fringe");
+	stats.add(exp.GetBucket(), "fringe", ins, upd, pop, time,
+	          path_error(dst, exp.GetDistance()), perf, MAXCNT);
+}
+
+// Converte uma lista de nomes de métodos separados por vírgulas.
+static bool parse_methods(char const *list, unsigned &mask) {
+	mask = 0;
+	string names(list);
+	size_t pos = 0;
+	while (pos <= names.size()) {
+		size_t end = names.find(',', pos);
+		if (end == string::npos) {
+			end = names.size();
+		}
+		string name = names.substr(pos, end - pos);
+		bool found = false;
+		for (unsigned ii = 0; ii < num_method_names; ii++) {
+			if (name == method_names[ii].name) {
+				mask |= method_names[ii].mask;
+				found = true;
+				break;
 			}
 		}
+		if (!found) {
+			cerr << "Metodo desconhecido: '" << name << "'." << endl;
+			return false;
+		}
+		pos = end + 1;
 	}
-};
+	return mask != 0;
+}
+
+static void usage() {
+	cerr << "Uso: " << BINNAME << " [-a metodo[,metodo...]] [-c|-w referencia]"
+	     << " [-t limiar] [-n passadas] [-e peso] [-l layout] [-B kB] [-N kB] [-G] [-M modelo] [-O arquivo] [-P] [-Q kB] [-q consultas]"
+	     << " [-R mudancas] [-S expansoes|-D microssegundos] <cenario> [cenario...]" << endl
+	     << "Metodos:";
+	for (unsigned ii = 0; ii < num_method_names; ii++) {
+		cerr << " " << method_names[ii].name;
+	}
+	cerr << endl
+	     << "  -w: executa os cenarios e grava os resultados de referencia" << endl
+	     << "  -c: executa os cenarios e compara com a referencia; termina com" << endl
+	     << "      erro se alguma distancia estiver errada ou se houver regressao" << endl
+	     << "  -t: aumento relativo tolerado em expansoes e tempo (padrao 0.1)" << endl
+	     << "  -n: passadas pelos cenarios para medir o tempo (padrao 5)" << endl
+	     << "  -R: compara o replanejamento com LPA* com buscas do zero apos" << endl
+	     << "      o numero dado de mudancas aleatorias no mapa" << endl
+	     << "  -S: intercala buscas em fatias de no maximo o numero dado de" << endl
+	     << "      expansoes e compara a latencia com a de buscas inteiras" << endl
+	     << "  -D: como -S, mas cada fatia dura o tempo dado" << endl
+	     << "  -e: peso da heuristica em wastar e peso inicial em ara (padrao 2)" << endl
+	     << "  -l: ordem dos nos na memoria:";
+	for (int ii = 0; ii < Graph::eNumLayouts; ii++) {
+		cerr << " " << Graph::get_layout_name(static_cast<Graph::Layout>(ii));
+	}
+	cerr << " (padrao " << Graph::get_layout_name(Graph::eRowMajor) << ")" << endl
+	     << "  -B: memoria para os blocos de mapas .tmap, em kB (padrao 65536)" << endl
+	     << "  -N: memoria para os nos de mapas .tmap, em kB (padrao 262144); as" << endl
+	     << "      consultas que precisam de mais nos sao abandonadas. Esses" << endl
+	     << "      mapas so podem ser usados sem -c, -w, -R, -S e -D, e" << endl
+	     << "      sem os metodos ara, coarse, simd e compact" << endl
+	     << "  -P: executa dijkstra, astar e jps tambem podando as regioes sem" << endl
+	     << "      saida, lidas de (ou gravadas em) <mapa>.dead, e compara" << endl
+	     << "  -G: executa dijkstra, astar e jps tambem podando os passos com" << endl
+	     << "      goal bounding, com as caixas lidas de (ou calculadas em" << endl
+	     << "      paralelo e gravadas em) <mapa>.bounds, e compara" << endl
+	     << "  -Q: responde cada consulta tambem pelo cache de consultas (A* nas" << endl
+	     << "      falhas), com o limite de memoria dado em kB; o cache vale para" << endl
+	     << "      todos os cenarios" << endl
+	     << "  -q: com -Q, responde tambem o numero dado de consultas derivadas de" << endl
+	     << "      cada experimento, em rodizio: a mesma, a inversa, entre dois nos" << endl
+	     << "      do caminho achado e com as pontas deslocadas para vizinhos" << endl
+	     << "  -O: grava os caminhos achados por cada metodo no arquivo dado," << endl
+	     << "      compactados em trechos retos; em binario se o nome terminar" << endl
+	     << "      em .bin, e em texto caso contrario" << endl
+	     << "  -M: modelo de movimento e metrica, como movimento[,metrica]; so" << endl
+	     << "      dijkstra, astar, wastar e ara, e so em mapas .map. Movimentos:";
+	for (unsigned ii = 0; ii < NUM_MOVEMENTS; ii++) {
+		cerr << " " << movement_names[ii];
+	}
+	cerr << endl << "      (8 direcoes com quinas: pelo menos um lado livre, qualquer," << endl
+	     << "      nenhum bloqueado; ou 4 direcoes)" << endl
+	     << "      Metricas:";
+	for (unsigned ii = 0; ii < NUM_METRICS; ii++) {
+		cerr << " " << metric_names[ii];
+	}
+	cerr << " (padrao 8,octile)" << endl
+	     << "  simd: executa A* com cada nucleo de expansao disponivel (scalar," << endl
+	     << "      sse2, avx2); ignorado com -c, -w, -R, -S, -D e -M" << endl
+	     << "  compact: executa dijkstra e astar com estado compacto (2 bytes" << endl
+	     << "      por celula); ignorado com -c, -w, -R, -S, -D e -M" << endl;
+}
 
 /*
- * Functor que insere os vizinhos no heap para Jump Point Search.
+ * Executa os métodos selecionados que funcionam com qualquer tipo de grafo
+ * (todos menos ARA*) em um experimento.
  */
-struct JPSSuccessors {
-	template <typename H>
-	void operator()(Node *node, Node *src, Node const *dst, Graph &g, H &heap,
-	                size_t &ins, size_t &upd) {
-		vector<Node *> adj;
-		if (node == src) {
-			// Para o nó de origem, todas direções tem que ser verificadas.
-			// Como precisamos de saber a direção também, de modo que não dá
-			// para usar Graph::get_adjacent_list.
-			static Direction const dirs[] = {eNorth, eSouth, eEast, eWest,
-			                                 eNorthEast, eSouthEast,
-			                                 eSouthWest, eNorthWest};
-			for (unsigned ii = 0; ii < sizeof(dirs) / sizeof(dirs[0]); ii++) {
-				add_neighbour(g, node, dirs[ii], adj);
-			}
+template <typename G>
+static void run_experiment(BasicPathEngine<G> &engine, Experiment const &exp, unsigned methods,
+                           double eps, PerfCounters *perf, BucketStats &stats,
+                           DeadEnds *deadends = 0, GoalBounds const *bounds = 0) {
+	typedef BasicPathEngine<G> Engine;
+	typedef typename G::node_type N;
+	G &g = engine.get_graph();
+	size_t failures = node_failures(g);
+	N *src = g.get_node(exp.GetStartX(), exp.GetStartY());
+	N const *dst = g.get_node(exp.GetGoalX(), exp.GetGoalY());
+	if (!src || !dst) {
+		// Só mapas em blocos deixam de criar nós dentro do mapa.
+		if (node_failures(g) != failures) {
+			dump_budget_exceeded("==== Query =======", nodebudget);
 		} else {
-			// Caso contrário, apenas alguns vizinhos são importantes.
-			adj = get_neighbours(node, g);
+			dump_outside_map("==== Query =======");
 		}
+		return;
+	}
+	// Com regiões sem saída ou caixas de destinos, Dijkstra, A* e JPS também são
+	// executados com cada poda.
+	if (deadends) {
+		deadends->set_query(src, dst);
+	}
+	typename Engine::Options plain, pruned, bounded, weighted;
+	pruned.pruning = deadends;
+	bounded.bounds = bounds;
+	weighted.weight = eps;
+
+	if (methods & eDijkstra) {
+		// Dijkstra
+		run_query(engine, src, dst, Engine::eDijkstra, plain, exp,
+		          "==== Dijkstra ====", "dijks", perf, stats);
+		if (deadends) {
+			run_query(engine, src, dst, Engine::eDijkstra, pruned, exp,
+			          "==== Pruned Dijkstra ====", "dijks-p", perf, stats);
+		}
+		if (bounds) {
+			run_query(engine, src, dst, Engine::eDijkstra, bounded, exp,
+			          "==== Bounded Dijkstra ===", "dijks-b", perf, stats);
+		}
+	}
 
-		// Para cada nó adjacente...
-		for (vector<Node *>::iterator it = adj.begin(); it != adj.end(); ++it) {
-			Node *next = *it;
-			if (next->already_done()) {
-				continue;
-			}
-			Direction dir = next->get_dir_from();
-			// ... ache o jump point nesta direção, se houver.
-			next = jump(node, src, dst, dir, g);
-			if (!next) {
-				continue;
-			}
-			// Como houve, vamos realizar uma relaxação.
-			double dst = node->get_distance() + node->distance_to(next);
-			if (next->get_distance() > dst) {
-				next->set_dir_from(dir);
-				next->set_distance(dst);
-				next->set_parent(node);
-				// Faz diferença?
-				//if (next->still_unseen()) {
-				if (!next->already_seen()) {
-					// Nó não foi visto ainda, então não está no heap.
-					next->mark_seen();
-					heap.insert(next);
-					ins++;
-				} else {
-					heap.update_elem(next);
-					upd++;
-				}
-			}
+	if (methods & eAstar) {
+		// A*
+		run_query(engine, src, dst, Engine::eAstar, plain, exp,
+		          "==== A* ==========", "astar", perf, stats);
+		if (deadends) {
+			run_query(engine, src, dst, Engine::eAstar, pruned, exp,
+			          "==== Pruned A* ===", "astar-p", perf, stats);
+		}
+		if (bounds) {
+			run_query(engine, src, dst, Engine::eAstar, bounded, exp,
+			          "==== Bounded A* ==", "astar-b", perf, stats);
 		}
 	}
-private:
-	/*
-	 * Tenta achar um jump point na direção dada, usando as regras especificadas
-	 * no artigo original.
-	 */
-	Node *jump(Node *node, Node *src, Node const *dst, Direction dir, Graph &g) {
-		Node *next = node;
-		do {
-			next = g.get_adjacent(next, dir);
-			if (!next) {
-				// Se o nó for bloqueado, estiver fora do mapa, não há um jump point.
-				return 0;
-			} else if (next == dst) {
-				// O nó de destino é sempre um jump point.
-				return next;
-			}
-			
-			// O nó tem vizinhos forçados na sua vizinhança?
-			vector<Node *> adj;
-			forced_neighbours(g, next, dir, adj);
-			if (!adj.empty()) {
-				// Se sim, temos um jump point.
-				return next;
-			}
 
-			// Recursão nas diagonais: busque por jump points nas direções
-			// ortoginais componentes da diagonal.
-			switch (dir) {
-				case eNorthEast:
-					if (jump(next, src, dst, eNorth, g) != 0) {
-						return next;
-					}
-					if (jump(next, src, dst, eEast, g) != 0) {
-						return next;
-					}
-					break;
-				case eSouthEast:
-					if (jump(next, src, dst, eSouth, g) != 0) {
-						return next;
-					}
-					if (jump(next, src, dst, eEast, g) != 0) {
-						return next;
-					}
-					break;
-				case eSouthWest:
-					if (jump(next, src, dst, eSouth, g) != 0) {
-						return next;
-					}
-					if (jump(next, src, dst, eWest, g) != 0) {
-						return next;
-					}
-					break;
-				case eNorthWest:
-					if (jump(next, src, dst, eNorth, g) != 0) {
-						return next;
-					}
-					if (jump(next, src, dst, eWest, g) != 0) {
-						return next;
-					}
-					break;
-				default:
-					break;
-			}
-		} while (1);
+	if (methods & eJPS) {
+		// JPS
+		run_query(engine, src, dst, Engine::eJPS, plain, exp,
+		          "==== JPS =========", "jumps", perf, stats);
+		if (deadends) {
+			run_query(engine, src, dst, Engine::eJPS, pruned, exp,
+			          "==== Pruned JPS ==", "jumps-p", perf, stats);
+		}
+		if (bounds) {
+			run_query(engine, src, dst, Engine::eJPS, bounded, exp,
+			          "==== Bounded JPS =", "jumps-b", perf, stats);
+		}
+	}
+
+	if (methods & eCanonDijkstra) {
+		// Dijkstra canônico
+		run_query(engine, src, dst, Engine::eCanonDijkstra, plain, exp,
+		          "==== Canonical Dijkstra ====", "dijks-c", perf, stats);
+	}
+
+	if (methods & eCanonAstar) {
+		// A* canônico
+		run_query(engine, src, dst, Engine::eCanonAstar, plain, exp,
+		          "==== Canonical A* ===", "astar-c", perf, stats);
+	}
+
+	if (methods & eFringe) {
+		// Fringe Search, que usa os nós do grafo por conta própria.
+		run_fringe(g, src, dst, exp, perf, stats);
+	}
+
+	if (methods & eWeighted) {
+		// A* ponderado
+		run_query(engine, src, dst, Engine::eWeightedAstar, weighted, exp,
+		          "==== Weighted ====", "wastar", perf, stats, eps);
 	}
+}
 
-	// Adiciona o vizinho na direção dada se ele não estiver bloqueado, se ele
-	// estiver dentro do mapa *e* se ele for alcançável à partir do "pai".
-	void add_neighbour(Graph &g, Node *node, Direction dir, vector<Node *> &adj) {
-		Node *next = g.get_adjacent(node, dir);
-		if (next) {
-			adj.push_back(next);
-			next->set_dir_from(dir);
+/*
+ * Lê as regiões sem saída de um mapa do arquivo ao lado dele (mapa + ".dead"),
+ * ou as calcula e grava o arquivo se ele não existir ou estiver desatualizado.
+ */
+static void load_deadends(DeadEnds &deadends, Graph &g, string const &mapname) {
+	string const fname = mapname + ".dead";
+	timeval start, finish;
+	gettimeofday(&start, NULL);
+	bool loaded = deadends.load(fname.c_str(), g);
+	if (!loaded) {
+		deadends.build(g);
+		if (!deadends.save(fname.c_str())) {
+			cerr << "Nao foi possivel gravar '" << fname << "'." << endl;
 		}
 	}
+	gettimeofday(&finish, NULL);
+	cout << "#### deadends = " << fname
+	     << ", source = " << (loaded ? "loaded" : "built")
+	     << ", blocks = " << deadends.get_num_blocks()
+	     << ", cuts = " << deadends.get_num_cuts()
+	     << ", time = " << delta_t(start, finish) << " ####" << endl;
+}
 
-	// Adiciona todos vizinhos naturais de um nó alcançado à partir de uma dada
-	// direção.
-	void natural_neighbours(Graph &g, Node *node, Direction dir, vector<Node *> &adj) {
-		// Vizinhos especiais para diagonais.
-		switch (dir) {
-			case eNorthEast:
-				// Naturais:
-				add_neighbour(g, node, eNorth, adj);
-				add_neighbour(g, node, eEast, adj);
-				break;
-			case eSouthEast:
-				// Naturais:
-				add_neighbour(g, node, eSouth, adj);
-				add_neighbour(g, node, eEast, adj);
-				break;
-			case eSouthWest:
-				// Naturais:
-				add_neighbour(g, node, eSouth, adj);
-				add_neighbour(g, node, eWest, adj);
+/*
+ * Lê as caixas de destinos de um mapa do arquivo ao lado dele (mapa +
+ * ".bounds"), ou as calcula e grava o arquivo se ele não existir ou estiver
+ * desatualizado.
+ */
+static void load_bounds(GoalBounds &bounds, Graph &g, string const &mapname) {
+	string const fname = mapname + ".bounds";
+	timeval start, finish;
+	gettimeofday(&start, NULL);
+	bool loaded = bounds.load(fname.c_str(), g);
+	if (!loaded) {
+		bounds.build(g);
+		if (!bounds.save(fname.c_str())) {
+			cerr << "Nao foi possivel gravar '" << fname << "'." << endl;
+		}
+	}
+	gettimeofday(&finish, NULL);
+	cout << "#### bounds = " << fname
+	     << ", source = " << (loaded ? "loaded" : "built")
+	     << ", threads = " << bounds.get_num_threads()
+	     << ", memory = " << bounds.get_memory_usage() / 1024 << " kB"
+	     << ", time = " << delta_t(start, finish) << " ####" << endl;
+}
+
+/*
+ * Lê uma quantidade de memória em kB (positiva, com sinal para que valores
+ * negativos sejam rejeitados) e a converte para bytes; retorna 0 se for
+ * inválida.
+ */
+static size_t parse_kb(char const *arg) {
+	char *end;
+	long value = strtol(arg, &end, 10);
+	if (*arg == '\0' || *end != '\0' || value < 1) {
+		return 0;
+	}
+	return static_cast<size_t>(value) * 1024;
+}
+
+int main(int argc, char *argv[]) {
+	AllocStats::install();
+	unsigned methods = eAllMethods;
+	char const *refname = 0;
+	bool writeref = false;
+	double threshold = 0.1;
+	int passes = 5;
+	double eps = 2.0;
+	int edits = 0;
+	size_t budget = 0;
+	long usecs = 0;
+	ModelRunner model = 0;
+	string modelname;
+	int opt;
+	while ((opt = getopt(argc, argv, "a:c:w:t:n:e:l:B:N:GM:O:PQ:q:R:S:D:")) != -1) {
+		switch (opt) {
+			case 'a':
+				if (!parse_methods(optarg, methods)) {
+					usage();
+					return 1;
+				}
 				break;
-			case eNorthWest:
-				// Naturais:
-				add_neighbour(g, node, eNorth, adj);
-				add_neighbour(g, node, eWest, adj);
+			case 'c':
+			case 'w':
+				refname = optarg;
+				writeref = opt == 'w';
 				break;
-			default:
+			case 't':
+				threshold = atof(optarg);
 				break;
-		}
-		// Vizinho natural comum a todos casos. Adicionado por último para que
-		// as diagonais venham depois das direções ortogonais.
-		add_neighbour(g, node, dir, adj);
-	}
-
-	// Adiciona todos vizinhos forçados de um nó alcançado à partir de uma dada
-	// direção.
-	void forced_neighbours(Graph &g, Node *node, Direction dir, vector<Node *> &adj) {
-		switch (dir) {
-			case eEast:
-				if (!g.get_adjacent(node, eNorth)) {
-					add_neighbour(g, node, eNorthEast, adj);
-				}
-				if (!g.get_adjacent(node, eSouth)) {
-					add_neighbour(g, node, eSouthEast, adj);
+			case 'n':
+				passes = atoi(optarg);
+				if (passes < 1) {
+					usage();
+					return 1;
 				}
 				break;
-			case eWest:
-				if (!g.get_adjacent(node, eNorth)) {
-					add_neighbour(g, node, eNorthWest, adj);
-				}
-				if (!g.get_adjacent(node, eSouth)) {
-					add_neighbour(g, node, eSouthWest, adj);
+			case 'e':
+				eps = atof(optarg);
+				if (eps < 1.0) {
+					usage();
+					return 1;
 				}
 				break;
-			case eNorth:
-				if (!g.get_adjacent(node, eEast)) {
-					add_neighbour(g, node, eNorthEast, adj);
+			case 'l': {
+				int lay = 0;
+				while (lay < Graph::eNumLayouts
+				       && string(optarg) != Graph::get_layout_name(static_cast<Graph::Layout>(lay))) {
+					lay++;
 				}
-				if (!g.get_adjacent(node, eWest)) {
-					add_neighbour(g, node, eNorthWest, adj);
+				if (lay == Graph::eNumLayouts) {
+					cerr << "Layout desconhecido: '" << optarg << "'." << endl;
+					usage();
+					return 1;
 				}
+				layout = static_cast<Graph::Layout>(lay);
 				break;
-			case eSouth:
-				if (!g.get_adjacent(node, eEast)) {
-					add_neighbour(g, node, eSouthEast, adj);
-				}
-				if (!g.get_adjacent(node, eWest)) {
-					add_neighbour(g, node, eSouthWest, adj);
+			}
+			case 'B':
+				tilebudget = parse_kb(optarg);
+				if (tilebudget == 0) {
+					usage();
+					return 1;
 				}
 				break;
-			case eNorthEast:
-				if (!g.get_adjacent(node, eWest)) {
-					add_neighbour(g, node, eNorthWest, adj);
+			case 'N':
+				nodebudget = parse_kb(optarg);
+				if (nodebudget == 0) {
+					usage();
+					return 1;
 				}
-				if (!g.get_adjacent(node, eSouth)) {
-					add_neighbour(g, node, eSouthEast, adj);
+				break;
+			case 'M':
+				model = parse_model(optarg, modelname);
+				if (!model) {
+					cerr << "Modelo desconhecido: '" << optarg << "'." << endl;
+					usage();
+					return 1;
 				}
 				break;
-			case eSouthEast:
-				if (!g.get_adjacent(node, eWest)) {
-					add_neighbour(g, node, eSouthWest, adj);
+			case 'G':
+				bounding = true;
+				break;
+			case 'O': {
+				// Binário se o nome terminar em ".bin".
+				string fname(optarg);
+				bool binary = fname.size() > 4 && fname.compare(fname.size() - 4, 4, ".bin") == 0;
+				if (!pathout.open(optarg, binary ? PathWriter::eBinary : PathWriter::eText)) {
+					cerr << "Nao foi possivel criar '" << optarg << "'." << endl;
+					return 1;
 				}
-				if (!g.get_adjacent(node, eNorth)) {
-					add_neighbour(g, node, eNorthEast, adj);
+				break;
+			}
+			case 'P':
+				prune = true;
+				break;
+			case 'Q': {
+				size_t limit = parse_kb(optarg);
+				if (limit == 0) {
+					usage();
+					return 1;
 				}
+				delete cache;
+				cache = new QueryCache(limit);
 				break;
-			case eSouthWest:
-				if (!g.get_adjacent(node, eEast)) {
-					add_neighbour(g, node, eSouthEast, adj);
+			}
+			case 'q': {
+				char *end;
+				long value = strtol(optarg, &end, 10);
+				if (*optarg == '\0' || *end != '\0' || value < 1) {
+					usage();
+					return 1;
 				}
-				if (!g.get_adjacent(node, eNorth)) {
-					add_neighbour(g, node, eNorthWest, adj);
+				derived = static_cast<unsigned>(value);
+				break;
+			}
+			case 'R':
+				edits = atoi(optarg);
+				if (edits < 1) {
+					usage();
+					return 1;
 				}
 				break;
-			case eNorthWest:
-				if (!g.get_adjacent(node, eEast)) {
-					add_neighbour(g, node, eNorthEast, adj);
+			case 'S':
+				budget = atol(optarg);
+				if (budget < 1) {
+					usage();
+					return 1;
 				}
-				if (!g.get_adjacent(node, eSouth)) {
-					add_neighbour(g, node, eSouthWest, adj);
+				break;
+			case 'D':
+				usecs = atol(optarg);
+				if (usecs < 1) {
+					usage();
+					return 1;
 				}
 				break;
 			default:
-				break;
+				usage();
+				return 1;
 		}
 	}
 
-	// Obtém uma lista com todos vizinhos naturais e forçados de um nó.
-	vector<Node *> get_neighbours(Node *node, Graph &g) {
-		vector<Node *> adj;
-		adj.reserve(8);
-		Direction dir = node->get_dir_from();
-		natural_neighbours(g, node, dir, adj);
-		forced_neighbours(g, node, dir, adj);
-		return adj;
-	}
-};
-
-// Versão genérica para Dijkstra, A* e JPS usando functors ou poiteiros para
-// funções para efetuar as operações necessárias.
-template <typename Compare, typename Successors>
-void ShortestPath(Graph &g, Node *src, Node const *dst, Compare cmp, Successors succ,
-                  size_t &ins, size_t &upd, size_t &pop) {
-	g.init_single_source(src);
-	ins = upd = pop = 0;
-
-	// Heap tem apenas nó inicial.
-	Heap<Node, Compare, GetIndex, SetIndex> heap(cmp);
-	heap.insert(src);
-	ins++;
-
-	while (!heap.empty()) {
-		Node *u = heap.extract();
-		pop++;
-		u->mark_done();
-
-		// Se chegamos ao destino, podemos parar.
-		if (u == dst) {
-			break;
-		}
-
-		// Adiciona todos sucessores do nó atual ao heap.
-		succ(u, src, dst, g, heap, ins, upd);
+	if (optind >= argc) {
+		cerr << "Falta nome do cenario." << endl;
+		usage();
+		return 1;
 	}
-}
 
-/*
- * Imprime diversas informações relevantes do caminho encontrado.
- */
-void dump_path_info(Node const *dst, char const *method, size_t ins,
-                    size_t upd, size_t pop, double mindist, double time) {
-	cout << method << endl;
-	cout << "insert = " << setw(6) << ins
-	     << ", update = " << setw(6) << upd
-	     << ", extract = " << setw(6) << pop;
-	if (dst->get_parent() == 0) {
-		cout << endl << "destination unreachable from source" << endl;
-		return;
+	if (edits) {
+		return run_replan(argv + optind, argc - optind, edits, layout);
 	}
-	double pathlen = round(dst->get_distance() * DISTANCE_PRECISION) / DISTANCE_PRECISION;
-	cout << ", distance = " << setw(6) << pathlen
-	     << ", mindist = " << setw(6) << mindist
-	     << ", correct = " << setw(6) << (pathlen - mindist)
-	     << ", time = " << setw(6) << time << endl;
-
-#ifdef PRINT_PATH
-	cout << "path:" << endl;
-	list<Node const *> path;
-	Node const *prev = dst;
-	do {
-		path.push_front(prev);
-		prev = prev->get_parent();
-	} while (prev != 0);
-
-	size_t nodecnt = 10;
-	for (list<Node const *>::const_iterator it = path.begin(); it != path.end(); ++it) {
-		if (++nodecnt == 10) {
-			cout << endl << "\t";
-			nodecnt = 0;
-		}
-		Node const *curr = *it;
-		cout << "(" << setw(3) << curr->get_x() << ", " << setw(3) << curr->get_y() << "); ";
+
+	if (budget || usecs) {
+		return run_sliced(argv + optind, argc - optind, methods, budget, usecs, layout);
 	}
-	if (nodecnt != 0) {
-		cout << endl;
+
+	if (refname) {
+		return run_check(argv + optind, argc - optind, methods, passes, refname,
+		                 writeref, threshold, eps, layout);
 	}
-#endif
-}
 
-int main(int argc, char *argv[]) {
-	if (argc < 2) {
-		cerr << "Falta nome do cenario." << endl;
-		return 1;
+	PerfCounters *perf = 0;
+#ifdef PERF_COUNTERS
+	// Contadores de hardware são opcionais: se não houver nenhum disponível,
+	// seguimos em frente sem eles.
+	PerfCounters counters;
+	if (counters.is_available()) {
+		perf = &counters;
+	} else {
+		cerr << "Contadores de hardware indisponiveis; continuando sem eles." << endl;
 	}
+#endif
 
-	for (int ii = 1; ii < argc; ii++) {
+	BucketStats stats;
+	for (int ii = optind; ii < argc; ii++) {
 		ScenarioLoader const scen(argv[ii]);
 		string lastfile;
 		Graph g;
+		// As consultas de Dijkstra, A* e JPS são feitas por um PathEngine, que
+		// percebe pela marca de busca do grafo quando outra busca usou os nós.
+		PathEngine engine(g);
+		TiledPathEngine *tengine = 0;
+		CoarseGrid coarse;
+		DeadEnds deadends;
+		GoalBounds bounds;
+		SimdSearch *simd = 0;
+		CompactSearch *compact = 0;
+		TiledGraph *tg = 0;
+		// Se o mapa atual pôde ser lido; senão, seus experimentos são pulados.
+		bool valid = false;
 		for (int jj = 0; jj < scen.GetNumExperiments(); jj++) {
 			Experiment const &exp = scen.GetNthExperiment(jj);
 			string const &newfile = exp.GetMapName();
+			pathid++;
+			if (is_tiled_map(newfile)) {
+				// Mapas em blocos só são usados pelos métodos genéricos.
+				if (lastfile != newfile) {
+					lastfile = newfile;
+					if (tg) {
+						dump_tile_stats(*tg);
+						delete tengine;
+						delete tg;
+					}
+					tg = new TiledGraph(lastfile.c_str(), tilebudget, nodebudget);
+					tengine = new TiledPathEngine(*tg);
+					valid = tg->is_valid();
+					if (!valid) {
+						cerr << "No cenario '" << scen.GetScenarioName()
+						     << "', experimento " << jj << ": Grafo '" << lastfile
+						     << "' invalido ou inexistente." << endl;
+						continue;
+					}
+					dump_map_info(*tg, lastfile);
+				}
+				if (!valid) {
+					continue;
+				}
+				tg->release_nodes();
+				run_experiment(*tengine, exp, methods, eps, perf, stats);
+				continue;
+			}
 			if (lastfile != newfile) {
 				lastfile = newfile;
-				g = Graph(lastfile.c_str());
-				if (!g.is_valid()) {
+				// As buscas vetorizada e compacta têm o tamanho do mapa
+				// anterior.
+				delete simd;
+				simd = 0;
+				delete compact;
+				compact = 0;
+				g = Graph(lastfile.c_str(), layout);
+				valid = g.is_valid();
+				if (!valid) {
 					cerr << "No cenario '" << scen.GetScenarioName()
 					     << "', experimento " << jj << ": Grafo '" << lastfile
 					     << "' invalido ou inexistente." << endl;
 					continue;
 				}
+				dump_map_info(g, lastfile);
+				if (model) {
+					cout << "#### model = " << modelname << " ####" << endl;
+				}
+				if (prune) {
+					load_deadends(deadends, g, lastfile);
+				}
+				if (bounding) {
+					load_bounds(bounds, g, lastfile);
+				}
+				if (methods & eCoarse) {
+					build_coarse(coarse, g);
+				}
+				if (methods & eSimd) {
+					simd = new SimdSearch(g);
+				}
+				if (methods & eCompact) {
+					compact = new CompactSearch(g);
+					cout << "#### compact: state = " << compact->get_memory_usage() / 1024
+					     << " kB (" << CompactSearch::get_bytes_per_cell()
+					     << " B/cell) ####" << endl;
+				}
+			}
+			if (!valid || !check_inside(scen, jj, jj + 1, g.get_width(), g.get_height())) {
+				continue;
 			}
 
-			Node *src = g.get_node(exp.GetStartX(), exp.GetStartY());
-			Node const *dst = g.get_node(exp.GetGoalX(), exp.GetGoalY());
-			// Para estatísticas.
-			size_t ins, upd, pop;
-			timeval start, finish;
-
-#define DIJKSTRA
-#define A_STAR
-#define JUMP_POINT_SEARCH
-#define MAXCNT 5
-#ifdef DIJKSTRA
-			// Dijkstra
-			gettimeofday(&start, NULL);
-			for (int cnt = 0; cnt < MAXCNT; cnt++) {
-				ShortestPath(g, src, dst, DijkstraCmp(), DijkstraSuccessors(),
-					         ins, upd, pop);
+			if (model) {
+				model(g, exp, methods, eps, perf, stats);
+				continue;
 			}
-			gettimeofday(&finish, NULL);
-			dump_path_info(dst, "==== Dijkstra ====", ins, upd, pop,
-			               exp.GetDistance(), delta_t(start, finish) / MAXCNT);
-#endif
 
-#ifdef A_STAR
-			// A*
-			gettimeofday(&start, NULL);
-			for (int cnt = 0; cnt < MAXCNT; cnt++) {
-				ShortestPath(g, src, dst, AstarCmp(dst), DijkstraSuccessors(),
-			             ins, upd, pop);
+			run_experiment(engine, exp, methods, eps, perf, stats, prune ? &deadends : 0,
+			               bounding ? &bounds : 0);
+
+			if (methods & eARA) {
+				// ARA*
+				Node *src = g.get_node(exp.GetStartX(), exp.GetStartY());
+				Node const *dst = g.get_node(exp.GetGoalX(), exp.GetGoalY());
+				run_ara(g, src, dst, eps, exp, perf, stats);
 			}
-			gettimeofday(&finish, NULL);
-			dump_path_info(dst, "==== A* ==========", ins, upd, pop,
-			               exp.GetDistance(), delta_t(start, finish) / MAXCNT);
-#endif
 
-#ifdef JUMP_POINT_SEARCH
-			// JPS
-			gettimeofday(&start, NULL);
-			for (int cnt = 0; cnt < MAXCNT; cnt++) {
-				ShortestPath(g, src, dst, AstarCmp(dst), JPSSuccessors(),
-			             ins, upd, pop);
+			if (methods & eCoarse) {
+				run_coarse(g, coarse, exp, perf, stats);
 			}
-			gettimeofday(&finish, NULL);
-			dump_path_info(dst, "==== JPS =========", ins, upd, pop,
-			               exp.GetDistance(), delta_t(start, finish) / MAXCNT);
-#endif
+
+			if (cache) {
+				run_cached(engine, *cache, lastfile, exp, derived, stats);
+			}
+
+			if (simd) {
+				run_simd(*simd, exp, stats);
+			}
+
+			if (compact) {
+				run_compact(*compact, exp, stats);
+			}
+		}
+		delete simd;
+		delete compact;
+		if (tg) {
+			dump_tile_stats(*tg);
+			delete tengine;
+			delete tg;
 		}
+		stats.dump_and_clear(scen.GetScenarioName());
+		if (cache) {
+			dump_cache_stats(*cache);
+		}
+	}
+	delete cache;
+	if (pathout.is_open()) {
+		size_t npaths = pathout.get_paths_written();
+		if (!pathout.close()) {
+			cerr << "Erro ao gravar os caminhos." << endl;
+			return 1;
+		}
+		cout << "#### paths = " << npaths << ", bytes = " << pathout.get_bytes_written()
+		     << " ####" << endl;
+	}
+
+	// Pico de memória residente do processo inteiro (em kB no Linux).
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+		cout << "#### maxrss = " << usage.ru_maxrss << " kB ####" << endl;
 	}
 	return 0;
 }
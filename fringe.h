@@ -0,0 +1,181 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _FRINGE_H_
+#define _FRINGE_H_
+
+#include "memstats.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+/*
+ * Fringe Search (Björnsson, Enzenberger, Holte e Schaeffer, 2005). Em vez de
+ * uma fila de prioridade, mantém a fronteira em uma lista duplamente ligada e
+ * a percorre em passadas com limite crescente de f = g + h, como IDA*: nós
+ * com f acima do limite ficam na lista para a próxima passada ("later"), e os
+ * demais são expandidos na hora, com os sucessores entrando logo depois deles
+ * ("now"). O limite da passada seguinte é o menor f que o excedeu.
+ *
+ * Usa as mesmas adjacências, custos e heurística que A* com
+ * DijkstraSuccessors, e o estado da busca fica nos nós do grafo, como em
+ * ShortestPath: cinza é "na lista", preto é "fora da lista mas já visto", e o
+ * índice de heap guarda a posição do nó na lista. Um nó preto cuja distância
+ * melhora volta para a lista. Ao fim, o destino fica preto se foi alcançado.
+ */
+template <typename G>
+class FringeSearch {
+public:
+	typedef typename G::node_type N;
+
+	FringeSearch(G &_g) : g(_g) {
+	}
+
+	/*
+	 * Busca o caminho mínimo de src a dst; retorna se ele existe. ins conta
+	 * as entradas na lista, upd os nós já vistos cuja distância melhorou, pop
+	 * os nós expandidos, visits os nós examinados em todas as passadas e
+	 * passes o número de passadas.
+	 */
+	bool search(N *src, N const *dst, size_t &ins, size_t &upd, size_t &pop,
+	            size_t &visits, size_t &passes) {
+		ins = upd = pop = visits = passes = 0;
+		g.init_single_source(src);
+		entries.clear();
+		entries.push_back(Entry(0));
+		entries[0].prev = entries[0].next = 0;
+		freelist = 0;
+		size_t count = 0, peak = 0;
+
+		src->mark_seen();
+		src->set_heapindex(insert_after(0, src));
+		ins++;
+		count++;
+		double limit = G::distance(src, dst);
+		bool found = false;
+		while (!found && entries[0].next != 0) {
+			passes++;
+			double fmin = 1.0E9;
+			uint32_t pos = entries[0].next;
+			while (pos != 0) {
+				N *node = entries[pos].node;
+				visits++;
+				double f = node->get_distance() + G::distance(node, dst);
+				if (f > limit) {
+					// Fica para a próxima passada.
+					if (f < fmin) {
+						fmin = f;
+					}
+					pos = entries[pos].next;
+					continue;
+				}
+				if (node == dst) {
+					// Como em ShortestPath, o destino termina expandido.
+					node->mark_done();
+					found = true;
+					break;
+				}
+				pop++;
+				expand(node, pos, ins, upd, count);
+				if (count > peak) {
+					peak = count;
+				}
+				// Os sucessores foram inseridos logo depois do nó, e são os
+				// próximos a serem examinados.
+				uint32_t next = entries[pos].next;
+				remove(pos);
+				node->mark_done();
+				count--;
+				pos = next;
+			}
+			limit = fmin;
+		}
+		MemStats::record_open_list(peak);
+		return found;
+	}
+
+private:
+	// Posição na lista; a posição 0 é a sentinela da lista circular.
+	struct Entry {
+		Entry(N *_node) : node(_node) {
+		}
+		N *node;
+		uint32_t prev, next;
+	};
+
+	// Relaxa os sucessores de node, inserindo-os depois de pos na ordem de
+	// get_adjacent_nodes.
+	void expand(N *node, uint32_t pos, size_t &ins, size_t &upd, size_t &count) {
+		N *adj[MAX_NEIGHBOURS];
+		for (unsigned ii = g.get_adjacent_nodes(node, adj); ii > 0; ii--) {
+			N *next = adj[ii - 1];
+			double dst = node->get_distance() + G::distance(node, next);
+			if (next->get_distance() <= dst) {
+				continue;
+			}
+			if (next->still_unseen()) {
+				count++;
+			} else {
+				upd++;
+				if (next->already_seen()) {
+					remove(next->get_heapindex());
+				} else {
+					count++;
+				}
+			}
+			next->set_distance(dst);
+			next->set_parent(node);
+			next->mark_seen();
+			next->set_heapindex(insert_after(pos, next));
+			ins++;
+		}
+	}
+
+	uint32_t insert_after(uint32_t pos, N *node) {
+		uint32_t idx;
+		if (freelist != 0) {
+			idx = freelist;
+			freelist = entries[idx].next;
+			entries[idx].node = node;
+		} else {
+			idx = static_cast<uint32_t>(entries.size());
+			entries.push_back(Entry(node));
+		}
+		uint32_t next = entries[pos].next;
+		entries[idx].prev = pos;
+		entries[idx].next = next;
+		entries[next].prev = idx;
+		entries[pos].next = idx;
+		return idx;
+	}
+
+	void remove(uint32_t pos) {
+		entries[entries[pos].prev].next = entries[pos].next;
+		entries[entries[pos].next].prev = entries[pos].prev;
+		entries[pos].next = freelist;
+		freelist = pos;
+	}
+
+	G &g;
+	std::vector<Entry> entries;
+	// Lista de posições livres, ligadas por next.
+	uint32_t freelist;
+};
+
+#endif // _FRINGE_H_
@@ -0,0 +1,336 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "goalbounds.h"
+#include "deadends.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+// Versão do formato do arquivo de caixas.
+static unsigned const BOUNDS_VERSION = 2;
+
+// Tolerância para considerar dois caminhos igualmente curtos.
+static double const TIE_EPSILON = 1.0E-6;
+
+/*
+ * Trabalho compartilhado pelas linhas de execução: cada uma pega a próxima
+ * linha do mapa ainda não processada e faz uma busca de cada célula dela.
+ * Cada busca só escreve nas caixas da própria origem, de modo que as linhas de
+ * execução não precisam de outra sincronização.
+ */
+struct BoundsJob {
+	unsigned w, h;
+	// Passos permitidos de cada célula, um bit por direção.
+	vector<uint8_t> moves;
+	int32_t offs[8];
+	double step[8];
+	// Próxima linha do mapa; incrementada atomicamente.
+	unsigned next;
+};
+
+class BoundsWorker {
+public:
+	BoundsWorker(GoalBounds &_gb, BoundsJob &_job)
+		: gb(_gb), job(_job) {
+	}
+
+	void run() {
+		size_t const ncells = static_cast<size_t>(job.w) * job.h;
+		dist.resize(ncells);
+		first.resize(ncells);
+		for (;;) {
+			unsigned row = __sync_fetch_and_add(&job.next, 1);
+			if (row >= job.h) {
+				break;
+			}
+			for (unsigned ii = 0; ii < job.w; ii++) {
+				uint32_t cell = row * job.w + ii;
+				if (job.moves[cell] != 0) {
+					search_from(cell);
+				}
+			}
+		}
+	}
+
+	static void *thread_main(void *arg) {
+		static_cast<BoundsWorker *>(arg)->run();
+		return 0;
+	}
+
+private:
+	typedef pair<double, uint32_t> Entry;
+
+	/*
+	 * Dijkstra a partir de src, propagando o conjunto de primeiros passos que
+	 * começam algum caminho mínimo até cada célula; cada célula expandida
+	 * entra nas caixas desses passos.
+	 */
+	void search_from(uint32_t src) {
+		GoalBounds::Box *boxes = &gb.boxes[static_cast<size_t>(src) * GoalBounds::NUM_DIRS];
+		fill(dist.begin(), dist.end(), 1.0E9);
+		fill(first.begin(), first.end(), 0);
+		priority_queue<Entry, vector<Entry>, greater<Entry> > queue;
+		dist[src] = 0;
+		queue.push(Entry(0, src));
+		while (!queue.empty()) {
+			Entry top = queue.top();
+			queue.pop();
+			uint32_t cell = top.second;
+			if (top.first > dist[cell]) {
+				// Entrada antiga; a célula já foi expandida.
+				continue;
+			}
+			uint16_t x = cell % job.w, y = cell / job.w;
+			for (unsigned mask = first[cell]; mask; mask &= mask - 1) {
+				GoalBounds::Box &box = boxes[__builtin_ctz(mask)];
+				box.minx = min(box.minx, x);
+				box.maxx = max(box.maxx, x);
+				box.miny = min(box.miny, y);
+				box.maxy = max(box.maxy, y);
+			}
+			for (unsigned dir = 0; dir < GoalBounds::NUM_DIRS; dir++) {
+				if (!(job.moves[cell] & (1u << dir))) {
+					continue;
+				}
+				uint32_t next = cell + job.offs[dir];
+				double nd = top.first + job.step[dir];
+				uint8_t moves = cell == src ? 1u << dir : first[cell];
+				if (nd < dist[next] - TIE_EPSILON) {
+					dist[next] = nd;
+					first[next] = moves;
+					queue.push(Entry(nd, next));
+				} else if (nd <= dist[next] + TIE_EPSILON) {
+					// Outro caminho mínimo; como os passos custam pelo menos
+					// 1, a célula ainda não foi expandida.
+					first[next] |= moves;
+				}
+			}
+		}
+	}
+
+	GoalBounds &gb;
+	BoundsJob &job;
+	vector<double> dist;
+	vector<uint8_t> first;
+};
+
+void GoalBounds::build(Graph &g, unsigned nthreads) {
+	w = g.get_width();
+	h = g.get_height();
+	checksum = DeadEnds::map_checksum(g);
+	Box empty = {0xffff, 0, 0xffff, 0};
+	boxes.assign(static_cast<size_t>(w) * h * NUM_DIRS, empty);
+
+	BoundsJob job;
+	job.w = w;
+	job.h = h;
+	job.next = 0;
+	job.moves.assign(static_cast<size_t>(w) * h, 0);
+	for (unsigned dir = 0; dir < NUM_DIRS; dir++) {
+		job.offs[dir] = DIR_DY[dir] * static_cast<int32_t>(w) + DIR_DX[dir];
+		job.step[dir] = DefaultMetric::cost(DIR_DX[dir], DIR_DY[dir]);
+	}
+	for (unsigned jj = 0; jj < h; jj++) {
+		for (unsigned ii = 0; ii < w; ii++) {
+			Node const *node = g.get_node(ii, jj);
+			if (node->is_blocked()) {
+				continue;
+			}
+			uint8_t mask = 0;
+			for (unsigned dir = 0; dir < NUM_DIRS; dir++) {
+				if (g.get_adjacent(node, static_cast<Direction>(dir))) {
+					mask |= 1u << dir;
+				}
+			}
+			job.moves[static_cast<size_t>(jj) * w + ii] = mask;
+		}
+	}
+
+	if (nthreads == 0) {
+		long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+		nthreads = ncpus > 0 ? ncpus : 1;
+	}
+	if (nthreads > h) {
+		nthreads = h > 0 ? h : 1;
+	}
+	vector<BoundsWorker> workers(nthreads, BoundsWorker(*this, job));
+	vector<pthread_t> tids(nthreads);
+	// A linha de execução atual também trabalha, como a última.
+	threads = 1;
+	for (unsigned ii = 0; ii + 1 < nthreads; ii++) {
+		if (pthread_create(&tids[ii], NULL, BoundsWorker::thread_main, &workers[ii]) != 0) {
+			break;
+		}
+		threads++;
+	}
+	workers.back().run();
+	for (unsigned ii = 0; ii + 1 < threads; ii++) {
+		pthread_join(tids[ii], NULL);
+	}
+}
+
+// Grava um inteiro com sinal em zigue-zague, em grupos de 7 bits (varint).
+static void put_varint(string &out, int value) {
+	uint32_t bits = (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+	while (bits >= 0x80) {
+		out += static_cast<char>((bits & 0x7f) | 0x80);
+		bits >>= 7;
+	}
+	out += static_cast<char>(bits);
+}
+
+// Lê um inteiro gravado por put_varint; falha se os dados acabarem antes.
+static bool get_varint(unsigned char const *&pos, unsigned char const *end, int &value) {
+	uint32_t bits = 0;
+	for (unsigned shift = 0; pos != end && shift < 35; shift += 7) {
+		unsigned char byte = *pos++;
+		bits |= static_cast<uint32_t>(byte & 0x7f) << shift;
+		if (!(byte & 0x80)) {
+			value = static_cast<int>(bits >> 1) ^ -static_cast<int>(bits & 1);
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+ * Formato: cabeçalho em texto (como o dos mapas) seguido dos dados binários:
+ * para cada célula, em ordem de linhas, um byte com um bit por direção cuja
+ * caixa não é vazia, e as caixas dessas direções, cada uma com minx, maxx,
+ * miny e maxy relativos à célula, em varints (veja put_varint). Células sem
+ * passos (bloqueadas ou isoladas) ocupam só o byte zerado, e as caixas, que
+ * em geral ficam perto da célula, poucos bytes.
+ */
+bool GoalBounds::save(char const *fname) const {
+	ofstream fout(fname, ios::out | ios::binary);
+	if (!fout.good()) {
+		return false;
+	}
+	fout << "type goalbounds\n"
+	     << "version " << BOUNDS_VERSION << '\n'
+	     << "height " << h << '\n'
+	     << "width " << w << '\n'
+	     << "checksum " << checksum << '\n'
+	     << "data\n";
+	string buf;
+	for (unsigned yy = 0; yy < h; yy++) {
+		for (unsigned xx = 0; xx < w; xx++) {
+			Box const *cellboxes = &boxes[(static_cast<size_t>(yy) * w + xx) * NUM_DIRS];
+			unsigned char mask = 0;
+			for (unsigned dir = 0; dir < NUM_DIRS; dir++) {
+				if (cellboxes[dir].minx <= cellboxes[dir].maxx) {
+					mask |= 1 << dir;
+				}
+			}
+			buf += static_cast<char>(mask);
+			for (unsigned dir = 0; dir < NUM_DIRS; dir++) {
+				if (mask & (1 << dir)) {
+					Box const &box = cellboxes[dir];
+					put_varint(buf, box.minx - static_cast<int>(xx));
+					put_varint(buf, box.maxx - static_cast<int>(xx));
+					put_varint(buf, box.miny - static_cast<int>(yy));
+					put_varint(buf, box.maxy - static_cast<int>(yy));
+				}
+			}
+		}
+		// Uma linha do mapa por vez no buffer.
+		fout.write(buf.data(), buf.size());
+		buf.clear();
+	}
+	return fout.good();
+}
+
+bool GoalBounds::load(char const *fname, Graph &g, ostream &err) {
+	ifstream fin(fname, ios::in | ios::binary);
+	if (!fin.good()) {
+		return false;
+	}
+	string hdr, sv, sh, sw, sc, sd;
+	unsigned ver, lh, lw;
+	uint64_t sum;
+	getline(fin, hdr);
+	fin >> sv >> ver >> sh >> lh >> sw >> lw >> sc >> sum >> sd;
+	if (!fin.good() || hdr != "type goalbounds" || sv != "version" || sh != "height"
+	    || sw != "width" || sc != "checksum" || sd != "data") {
+		err << "Caixas '" << fname << "' invalidas." << endl;
+		return false;
+	}
+	if (ver != BOUNDS_VERSION || lw != g.get_width() || lh != g.get_height()
+	    || sum != DeadEnds::map_checksum(g)) {
+		// Desatualizado: outro formato ou outro mapa.
+		return false;
+	}
+	fin.ignore(1);
+
+	// O resto do arquivo de uma vez.
+	streampos start = fin.tellg();
+	fin.seekg(0, ios::end);
+	vector<unsigned char> data(static_cast<size_t>(fin.tellg() - start));
+	fin.seekg(start);
+	if (!data.empty()) {
+		fin.read(reinterpret_cast<char *>(&data[0]), data.size());
+	}
+
+	w = lw;
+	h = lh;
+	threads = 0;
+	checksum = sum;
+	Box empty = {0xffff, 0, 0xffff, 0};
+	boxes.assign(static_cast<size_t>(w) * h * NUM_DIRS, empty);
+	unsigned char const *pos = data.empty() ? 0 : &data[0], *end = pos + data.size();
+	bool ok = fin.good();
+	for (unsigned yy = 0; yy < h && ok; yy++) {
+		for (unsigned xx = 0; xx < w && ok; xx++) {
+			if (pos == end) {
+				ok = false;
+				break;
+			}
+			unsigned char const mask = *pos++;
+			Box *cellboxes = &boxes[(static_cast<size_t>(yy) * w + xx) * NUM_DIRS];
+			for (unsigned dir = 0; dir < NUM_DIRS && ok; dir++) {
+				int minx = 0, maxx = 0, miny = 0, maxy = 0;
+				if (!(mask & (1 << dir))) {
+					continue;
+				}
+				ok = get_varint(pos, end, minx) && get_varint(pos, end, maxx)
+				  && get_varint(pos, end, miny) && get_varint(pos, end, maxy);
+				Box box = {static_cast<uint16_t>(minx + static_cast<int>(xx)),
+				           static_cast<uint16_t>(maxx + static_cast<int>(xx)),
+				           static_cast<uint16_t>(miny + static_cast<int>(yy)),
+				           static_cast<uint16_t>(maxy + static_cast<int>(yy))};
+				cellboxes[dir] = box;
+			}
+		}
+	}
+	if (!ok || pos != end) {
+		err << "Caixas '" << fname << "' invalidas." << endl;
+		boxes.clear();
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,92 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GOALBOUNDS_H_
+#define _GOALBOUNDS_H_
+
+#include "graph.h"
+
+#include <stdint.h>
+
+#include <iostream>
+#include <vector>
+
+/*
+ * Goal bounding (Rabin e Sturtevant, 2016). Para cada célula passável e cada
+ * direção, guarda a caixa que contém todos os destinos para os quais algum
+ * caminho mínimo começa com o passo naquela direção. Numa busca, um passo cuja
+ * caixa não contém o destino pode ser ignorado.
+ *
+ * Com empates, o destino entra na caixa de todas as direções que começam um
+ * caminho mínimo, e não só de uma delas; as caixas ficam um pouco maiores, mas
+ * a poda continua correta com JPS, que só segue alguns dos caminhos mínimos.
+ *
+ * O cálculo é uma busca de Dijkstra a partir de cada célula, dividida entre
+ * várias linhas de execução; o resultado pode ser gravado ao lado do mapa
+ * (save) e lido depois (load).
+ */
+class GoalBounds {
+public:
+	GoalBounds() : w(0), h(0), threads(0), checksum(0) {}
+
+	/*
+	 * Calcula as caixas usando o número dado de linhas de execução (0 para
+	 * uma por processador).
+	 */
+	void build(Graph &g, unsigned nthreads = 0);
+
+	/*
+	 * Lê as caixas gravadas por save. Falha se o arquivo não existir, estiver
+	 * em outra versão do formato ou tiver sido calculado para outro mapa (ou
+	 * para outra versão do mesmo mapa). Os erros de leitura são escritos em err.
+	 */
+	bool load(char const *fname, Graph &g, std::ostream &err = std::cerr);
+	bool save(char const *fname) const;
+
+	// Se o passo de (x, y) na direção dada não começa nenhum caminho mínimo
+	// até (tx, ty).
+	bool is_pruned(int x, int y, Direction dir, int tx, int ty) const {
+		Box const &box = boxes[(static_cast<size_t>(y) * w + x) * NUM_DIRS + dir];
+		return tx < box.minx || tx > box.maxx || ty < box.miny || ty > box.maxy;
+	}
+
+	// Linhas de execução usadas pelo último build (0 se as caixas foram lidas).
+	unsigned get_num_threads() const    {	return threads;	}
+	size_t get_memory_usage() const {
+		return sizeof(*this) + boxes.capacity() * sizeof(Box);
+	}
+
+private:
+	enum {
+		NUM_DIRS = 8
+	};
+
+	// Caixa de destinos; vazia quando minx > maxx.
+	struct Box {
+		uint16_t minx, maxx, miny, maxy;
+	};
+
+	friend class BoundsWorker;
+
+	unsigned w, h;
+	unsigned threads;
+	uint64_t checksum;
+	std::vector<Box> boxes;
+};
+
+#endif // _GOALBOUNDS_H_
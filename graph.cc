@@ -25,9 +25,36 @@
 
 using namespace std;
 
-Graph::Graph(char const *fname) {
+Graph::Graph(Graph const &other)
+	: w(other.w), h(other.h), version(other.version), stamp(new_search_stamp()),
+	  layout(other.layout), nodes(other.nodes), colidx(other.colidx),
+	  rowidx(other.rowidx) {
+}
+
+Graph &Graph::operator=(Graph const &other) {
+	w = other.w;
+	h = other.h;
+	version = other.version;
+	stamp = new_search_stamp();
+	layout = other.layout;
+	nodes = other.nodes;
+	colidx = other.colidx;
+	rowidx = other.rowidx;
+	return *this;
+}
+
+// Pode ser chamada por várias threads (preprocess cria grafos em paralelo).
+unsigned Graph::new_search_stamp() {
+	static unsigned counter = 0;
+	return __sync_add_and_fetch(&counter, 1);
+}
+
+Graph::Graph(char const *fname, Layout _layout, ostream &err) {
 	// Marca como grafo inválido.
 	w = h = 0;
+	version = 0;
+	stamp = new_search_stamp();
+	layout = _layout;
 
 	ifstream fin(fname, ios::in);
 	if (!fin.good()) {
@@ -37,7 +64,7 @@ Graph::Graph(char const *fname) {
 	string hdr;
 	getline(fin, hdr);
 	if (hdr != "type octile") {
-		cerr << "Mapa '" << fname << "' invalido." << endl;
+		err << "Mapa '" << fname << "' invalido." << endl;
 		return;
 	}
 
@@ -46,12 +73,16 @@ Graph::Graph(char const *fname) {
 
 	if (!fin.good() || sh != "height" || sw != "width" || sm != "map") {
 		w = h = 0;
-		cerr << "Mapa '" << fname << "' invalido." << endl;
+		err << "Mapa '" << fname << "' invalido." << endl;
 		return;
 	}
 
-	// Cria espaço para o grafo.
-	nodes.resize(w * h);
+	// Cria espaço para o grafo. Nós que só completam o layout ficam
+	// bloqueados e fora da grade.
+	build_index(layout);
+	for (vector<Node>::iterator it = nodes.begin(); it != nodes.end(); ++it) {
+		it->init(-1, -1, true);
+	}
 	fin >> ws;
 
 	// Vértices.
@@ -61,7 +92,7 @@ Graph::Graph(char const *fname) {
 		getline(fin, line);
 		for (unsigned ii = 0; ii < w && fin.good(); ii++) {
 			char node = line[ii];
-			Node *curr = &(nodes[w * jj + ii]);
+			Node *curr = get_node(ii, jj);
 			switch (node) {
 				case '\n':
 					// Ignore.
@@ -80,3 +111,75 @@ Graph::Graph(char const *fname) {
 		}
 	}
 }
+
+char const *Graph::get_layout_name(Layout lay) {
+	static char const *const names[eNumLayouts] = {"rowmajor", "morton", "tiled"};
+	return lay < eNumLayouts ? names[lay] : "?";
+}
+
+// Menor número de bits suficiente para representar valores em [0, n).
+static unsigned bits_for(unsigned n) {
+	unsigned bits = 0;
+	while ((1u << bits) < n) {
+		bits++;
+	}
+	return bits;
+}
+
+/*
+ * Espalha os 'common' bits mais baixos de v nas posições pares (deslocadas
+ * de 'shift'), e coloca os bits restantes em sequência acima dos 2 * common
+ * bits intercalados. Só um dos eixos tem bits restantes: o mais longo.
+ */
+static size_t morton_spread(unsigned v, unsigned common, unsigned shift) {
+	size_t idx = 0;
+	for (unsigned bit = 0; bit < common; bit++) {
+		idx |= static_cast<size_t>((v >> bit) & 1) << (2 * bit + shift);
+	}
+	return idx | (static_cast<size_t>(v >> common) << (2 * common));
+}
+
+void Graph::build_index(Layout lay) {
+	colidx.resize(w);
+	rowidx.resize(h);
+	size_t total = 0;
+	switch (lay) {
+		case eMorton: {
+			unsigned bw = bits_for(w), bh = bits_for(h);
+			unsigned common = bw < bh ? bw : bh;
+			for (unsigned ii = 0; ii < w; ii++) {
+				colidx[ii] = morton_spread(ii, common, 0);
+			}
+			for (unsigned jj = 0; jj < h; jj++) {
+				rowidx[jj] = morton_spread(jj, common, 1);
+			}
+			total = static_cast<size_t>(1) << (bw + bh);
+			break;
+		}
+		case eTiled: {
+			size_t tilesw = (w + TILE_SIDE - 1) / TILE_SIDE;
+			size_t tilesh = (h + TILE_SIDE - 1) / TILE_SIDE;
+			size_t tilesize = TILE_SIDE * TILE_SIDE;
+			for (unsigned ii = 0; ii < w; ii++) {
+				colidx[ii] = (ii / TILE_SIDE) * tilesize + ii % TILE_SIDE;
+			}
+			for (unsigned jj = 0; jj < h; jj++) {
+				rowidx[jj] = (jj / TILE_SIDE) * tilesw * tilesize
+				           + (jj % TILE_SIDE) * TILE_SIDE;
+			}
+			total = tilesw * tilesh * tilesize;
+			break;
+		}
+		case eRowMajor:
+		default:
+			for (unsigned ii = 0; ii < w; ii++) {
+				colidx[ii] = ii;
+			}
+			for (unsigned jj = 0; jj < h; jj++) {
+				rowidx[jj] = static_cast<size_t>(w) * jj;
+			}
+			total = static_cast<size_t>(w) * h;
+			break;
+	}
+	nodes.resize(total);
+}
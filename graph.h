@@ -19,35 +19,35 @@
 #ifndef _GRAPH_H_
 #define _GRAPH_H_
 
+#include "movement.h"
+
 #include <vector>
 #include <algorithm>
 #include <cmath>
 #include <cstdlib>
+#include <iostream>
 
 #define DISTANCE_PRECISION 100.0
-#define OCTILE_DISTANCE 1
-
-// Direções usadas em JPS.
-enum Direction {
-	eNorth,
-	eNorthEast,
-	eEast,
-	eSouthEast,
-	eSouth,
-	eSouthWest,
-	eWest,
-	eNorthWest
-};
+
+class Graph;
+class TiledGraph;
 
 /*
  * Nó no grafo. Guarda um mundo de informações que, em uma aplicação geral,
  * seriam melhor armazenadas em estruturas temporárias separadas usadas pelos
  * algoritmos.
+ *
+ * O tipo das coordenadas é parâmetro do template: Graph usa short, o que
+ * limita os mapas a 32767 nós por lado mas mantém o nó em 40 bytes, e
+ * TiledGraph usa int.
  */
-class Node {
+template <typename Coord>
+class BasicNode {
 public:
 	friend class Graph;
-	friend class std::vector<Node>;
+	friend class TiledGraph;
+	friend class MemStats;
+	friend class std::vector<BasicNode>;
 
 	// Uso semelhante às buscas em largura e profundidade.
 	enum Color {
@@ -56,7 +56,7 @@ public:
 		eBlack
 	};
 
-	Node(short _x, short _y, bool _blocked)
+	BasicNode(Coord _x, Coord _y, bool _blocked)
 		: parent(0), dist(1.0E9), clr(eWhite), x(_x), y(_y), blocked(_blocked) {
 	}
 
@@ -67,30 +67,20 @@ public:
 		parent = 0;
 	}
 
-	// Cálculo de distância usando métrica Euclideana padrão.
-	double distance_to(Node const *other) const {
-#ifdef OCTILE_DISTANCE
-		// "Octile distance": calcula a distância baseado nos movimentos que são
-		// permitidos: eixos ortogonais e disgonais em 45 graus.
-		int dx = std::abs(x - other->x), dy = std::abs(y - other->y);
-		static double const DIAGDIST = 1.414213562373095048801688 - 1.0;
-		return 1.0 * std::max(dx, dy) + DIAGDIST * std::min(dx, dy);
-#else
-		// Métrica Euclideana padrão.
-		int dx = x - other->x, dy = y - other->y;
-		return std::sqrt(1.0 * (dx * dx + dy * dy));
-#endif
+	// Cálculo de distância usando a métrica padrão (veja movement.h).
+	double distance_to(BasicNode const *other) const {
+		return DefaultMetric::cost(x - other->x, y - other->y);
 	}
 
 	// Getters.
-	short get_x() const             {	return x;	}
-	short get_y() const             {	return y;	}
+	Coord get_x() const             {	return x;	}
+	Coord get_y() const             {	return y;	}
 	bool is_blocked() const         {	return blocked;	}
 	double get_distance() const     {	return dist;	}
 	bool still_unseen() const       {	return clr == eWhite;	}
 	bool already_seen() const       {	return clr == eGray;	}
 	bool already_done() const       {	return clr == eBlack;	}
-	Node *get_parent() const        {	return parent;	}
+	BasicNode *get_parent() const   {	return parent;	}
 	size_t get_heapindex() const    {	return heapindex;	}
 	Direction get_dir_from() const  {	return from;	}
 
@@ -99,18 +89,18 @@ public:
 	void mark_unseen()              {	clr = eWhite;	}
 	void mark_seen()                {	clr = eGray;	}
 	void mark_done()                {	clr = eBlack;	}
-	void set_parent(Node *p)        {	parent = p;	}
+	void set_parent(BasicNode *p)   {	parent = p;	}
 	void set_heapindex(size_t v)    {	heapindex = v;	}
 	void set_dir_from(Direction f)  {	from = f;	}
 
 protected:
-	Node()
+	BasicNode()
 		: parent(0), dist(~0u), clr(eWhite) {
 	}
 
 	// Usado durante a inicialização do grafo, para que cada nó saiba sua
 	// posição na grade 2d.
-	void init(short _x, short _y, bool _blocked) {
+	void init(Coord _x, Coord _y, bool _blocked) {
 		x = _x;
 		y = _y;
 		blocked = _blocked;
@@ -118,17 +108,19 @@ protected:
 
 private:
 	// Informações para Dijkstra, A* e JPS:
-	Node *parent;
+	BasicNode *parent;
 	size_t heapindex;	
 	double dist;
 	Color clr;
 	// Informações para JPS:
 	Direction from;
 	// Informações do vértice em si.
-	short x, y;
+	Coord x, y;
 	bool blocked;
 };
 
+typedef BasicNode<short> Node;
+
 /*
  * Classe de grafo geral. Uma aplicação mais real provavelmente usaria algo mais
  * flexível, que pudesse, por exemplo, carregar apenas parte do mapa. E também
@@ -137,8 +129,35 @@ private:
  */
 class Graph {
 public:
-	Graph() : w(0), h(0) {}
-	Graph(char const *fname);
+	typedef Node node_type;
+
+	/*
+	 * Ordem dos nós na memória. Em ordem de linhas, passos verticais e
+	 * diagonais pulam uma linha inteira de nós; na ordem de Morton (curva Z) e
+	 * em blocos de TILE_SIDE x TILE_SIDE nós, vizinhos na grade tendem a ficar
+	 * próximos na memória. Os dois últimos completam a grade com nós
+	 * bloqueados inacessíveis (até potências de 2 e até múltiplos de
+	 * TILE_SIDE, respectivamente).
+	 */
+	enum Layout {
+		eRowMajor,
+		eMorton,
+		eTiled,
+		eNumLayouts
+	};
+	enum {
+		TILE_SIDE = 8
+	};
+
+	Graph() : w(0), h(0), version(0), stamp(new_search_stamp()), layout(eRowMajor) {}
+	// Os erros de leitura são escritos em err.
+	Graph(char const *fname, Layout _layout = eRowMajor, std::ostream &err = std::cerr);
+	// Cópias e atribuições recebem uma marca de busca nova.
+	Graph(Graph const &other);
+	Graph &operator=(Graph const &other);
+
+	static char const *get_layout_name(Layout lay);
+	Layout get_layout() const       {	return layout;	}
 
 	/*
 	 * Se o grafo lido é válido ou não: precisa ter pelo menos 2 nós, um dos
@@ -148,6 +167,48 @@ public:
 		return w != 0 && h != 0;
 	}
 
+	// Dimensões da grade.
+	unsigned get_width() const      {	return w;	}
+	unsigned get_height() const     {	return h;	}
+
+	/*
+	 * Torna um nó passável ou impassável. Retorna false se o nó estiver fora
+	 * da grade. Cada mudança efetiva incrementa a versão do mapa.
+	 */
+	bool set_blocked(int x, int y, bool blocked) {
+		Node *node = get_node(x, y);
+		if (!node) {
+			return false;
+		}
+		if (node->blocked != blocked) {
+			node->blocked = blocked;
+			version++;
+		}
+		return true;
+	}
+
+	// Versão do mapa: muda sempre que algum nó muda de estado.
+	unsigned get_version() const    {	return version;	}
+
+	/*
+	 * Marca de busca: muda sempre que o estado de busca de todos os nós é
+	 * reiniciado (init_single_source) ou os nós são substituídos (atribuição
+	 * de outro grafo). Quem reinicia só parte dos nós, como BasicPathEngine,
+	 * compara a marca para saber se outra busca mexeu nos nós desde então.
+	 * As marcas vêm de um contador global, e nunca se repetem entre grafos.
+	 */
+	unsigned get_search_stamp() const   {	return stamp;	}
+	static unsigned new_search_stamp();
+
+	// Memória ocupada pelo grafo, em bytes.
+	size_t get_memory_usage() const {
+		return sizeof(*this) + nodes.capacity() * sizeof(Node)
+		     + (colidx.capacity() + rowidx.capacity()) * sizeof(size_t);
+	}
+
+	// Número de nós alocados, inclusive os que completam a grade.
+	size_t get_num_nodes() const    {	return nodes.size();	}
+
 	/*
 	 * Retorna o ponteiro de um nó dado suas coordenadas, com verificação para
 	 * garantir que o nó referenciado é válido. Retorna 0 para um nó fora dos
@@ -158,16 +219,36 @@ public:
 		    || y < 0 || static_cast<unsigned>(y) >= h) {
 			return 0;
 		} else {
-			return &(nodes[w * y + x]);
+			return &(nodes[colidx[x] + rowidx[y]]);
 		}
 	}
 
+	// Se o nó (x, y) está dentro da grade e não é bloqueado.
+	bool is_passable(int x, int y) {
+		Node *node = get_node(x, y);
+		return node && !node->is_blocked();
+	}
+
+	// Distância entre nós vizinhos ou heurística, na métrica padrão.
+	static double distance(Node const *lhs, Node const *rhs) {
+		return lhs->distance_to(rhs);
+	}
+
 	/*
 	 * Retorna todos nós adjacentes ao nó dado. Os nós adjacentes são obtidos
 	 * pela função get_adjacent.
 	 */
 	std::vector<Node *> get_adjacent_list(Node const *node) {
-		return get_adjacent_list(node->get_x(), node->get_y());
+		return adjacent_list<DefaultMovement>(*this, node);
+	}
+
+	/*
+	 * Como get_adjacent_list, mas grava os nós adjacentes em adj, que tem que
+	 * ter espaço para MAX_NEIGHBOURS nós, e retorna quantos são. Não aloca
+	 * memória, e é o que as buscas usam no laço principal.
+	 */
+	unsigned get_adjacent_nodes(Node const *node, Node **adj) {
+		return adjacent_nodes<DefaultMovement>(*this, node, adj);
 	}
 
 	/*
@@ -188,99 +269,33 @@ public:
 			it->init_single_source();
 		};
 		src->set_distance(0);
+		stamp = new_search_stamp();
 	}
 
 private:
 	unsigned w, h;
+	unsigned version;
+	unsigned stamp;
+	Layout layout;
 	std::vector<Node> nodes;
+	// Índice de um nó no vetor: colidx[x] + rowidx[y]. Todos os layouts são
+	// separáveis desta forma.
+	std::vector<size_t> colidx, rowidx;
 
-	/*
-	 * Retorna todos nós adjacentes ao nó dado. Os nós adjacentes são obtidos
-	 * pela função get_adjacent.
-	 */
-	std::vector<Node *> get_adjacent_list(int x, int y) {
-		std::vector<Node *> nodes;
-		nodes.reserve(8);
-		static Direction const dirs[] = {eNorth, eNorthEast, eEast, eSouthEast,
-		                                 eSouth, eSouthWest, eWest, eNorthWest};
-
-		for (unsigned ii = 0; ii < sizeof(dirs) / sizeof(dirs[0]); ii++) {
-			Node *node = get_adjacent(x, y, dirs[ii]);
-			if (node) {
-				nodes.push_back(node);
-			}
-		}
-
-		return nodes;
-	}
+	void build_index(Layout lay);
 
 	/*
 	 * Retorna o nó adjacente ao nó dado na direção dada se o nó final:
 	 * (1) estiver dentro da grade;
 	 * (2) não for um nó bloqueado;
 	 * (3) puder ser alcançado do nó de origem (basicamente, diagonais tem que
-	 *     obedecer certas restrições).
+	 *     obedecer certas restrições; veja DefaultMovement).
 	 */
 	Node *get_adjacent(int x, int y, Direction dir) {
-		Node *adj = 0;
-		if (!can_step_to(x, y, dir)) {
-			return adj;
-		}
-
-		switch (dir) {
-			case eNorth:
-				adj = get_node(x + 0, y - 1);
-				break;
-			case eNorthEast:
-				adj = get_node(x + 1, y - 1);
-				break;
-			case eEast:
-				adj = get_node(x + 1, y + 0);
-				break;
-			case eSouthEast:
-				adj = get_node(x + 1, y + 1);
-				break;
-			case eSouth:
-				adj = get_node(x + 0, y + 1);
-				break;
-			case eSouthWest:
-				adj = get_node(x - 1, y + 1);
-				break;
-			case eWest:
-				adj = get_node(x - 1, y + 0);
-				break;
-			case eNorthWest:
-				adj = get_node(x - 1, y - 1);
-				break;
-		}
-
-		if (!adj || adj->is_blocked()) {
+		if (!DefaultMovement::can_step(*this, x, y, dir)) {
 			return 0;
-		} else {
-			return adj;
-		}
-	}
-
-	// Filtra diagonais que não tenham pelo menos uma direção adjacente que
-	// não seja bloqueada.
-	bool can_step_to(int x, int y, Direction to) {
-		switch (to) {
-			case eEast:
-			case eWest:
-			case eNorth:
-			case eSouth:
-				return true;
-			case eNorthEast:
-				return get_adjacent(x, y, eEast) || get_adjacent(x, y, eNorth);
-			case eSouthEast:
-				return get_adjacent(x, y, eEast) || get_adjacent(x, y, eSouth);
-			case eSouthWest:
-				return get_adjacent(x, y, eWest) || get_adjacent(x, y, eSouth);
-			case eNorthWest:
-				return get_adjacent(x, y, eWest) || get_adjacent(x, y, eNorth);
-			default:
-				return false;
 		}
+		return get_node(x + DIR_DX[dir], y + DIR_DY[dir]);
 	}
 };
 
@@ -19,6 +19,8 @@
 #ifndef _HEAP_H_
 #define _HEAP_H_
 
+#include "profiler.h"
+
 #include <algorithm>
 #include <vector>
 
@@ -31,10 +33,22 @@
 template <typename T, typename Compare, typename GetIndex, typename SetIndex>
 class Heap {
 public:
-	Heap(Compare const &c) : cmp(c) {
+	Heap(Compare const &c) : cmp(c), peak(0) {
 		elements.reserve(1000);
 	}
 
+	/*
+	 * Esvazia o heap, mantendo a memória já alocada para os elementos, e troca
+	 * a função de comparação (que pode depender do destino da busca). O pico
+	 * de elementos também é zerado. Permite reusar o mesmo heap em várias
+	 * buscas sem realocar o vetor.
+	 */
+	void clear(Compare const &c) {
+		elements.clear();
+		cmp = c;
+		peak = 0;
+	}
+
 	// Organiza os elementos de modo a criar um heap.
 	void heapify() {
 		for (size_t ii = (elements.size() >> 1); ii > 0; ii--)
@@ -49,6 +63,9 @@ public:
 	void insert_unsorted(T *elem) {
 		setid(elem, elements.size());
 		elements.push_back(elem);
+		if (elements.size() > peak) {
+			peak = elements.size();
+		}
 	}
 
 	// Insere um elemento no heap e o move para o local adequado.
@@ -63,6 +80,7 @@ public:
 	 * O elemento é removido do heap, que então sofre uma reorganização.
 	 */
 	T *extract() {
+		PROFILE_SCOPE(ePhaseExtract);
 		if (elements.empty()) {
 			return 0;
 		}
@@ -80,12 +98,16 @@ public:
 		}
 
 		setid(repl, 0);
-		heapify(0);
+		{
+			PROFILE_SCOPE(ePhaseSift);
+			heapify(0);
+		}
 		return elem;
 	}
 
 	// Assume que elem está no heap.
 	void update_elem(T *elem) {
+		PROFILE_SCOPE(ePhaseSift);
 		size_t elemid = getid(elem);
 		size_t parent = get_parent(elemid);
 
@@ -99,10 +121,57 @@ public:
 		}
 	}
 
+	/*
+	 * Reposiciona um elemento cuja chave pode ter aumentado ou diminuído.
+	 * Assume que elem está no heap.
+	 */
+	void reposition(T *elem) {
+		update_elem(elem);
+		PROFILE_SCOPE(ePhaseSift);
+		heapify(getid(elem));
+	}
+
+	// Remove do heap um elemento qualquer. Assume que elem está no heap.
+	void remove(T *elem) {
+		size_t elemid = getid(elem);
+		T *repl = elements.back();
+		elements.pop_back();
+		if (repl == elem) {
+			// Era o último elemento; nada mais a fazer.
+			return;
+		}
+		elements[elemid] = repl;
+		setid(repl, elemid);
+		reposition(repl);
+	}
+
+	// Retorna o elemento extremo do heap sem removê-lo.
+	T *top() const {
+		return elements.empty() ? 0 : elements[0];
+	}
+
 	bool empty() const {
 		return elements.empty();
 	}
 
+	// Acesso aos elementos, na ordem em que estão no vetor do heap.
+	size_t size() const {
+		return elements.size();
+	}
+	T *get(size_t index) const {
+		return elements[index];
+	}
+
+	// Maior número de elementos que o heap já teve.
+	size_t get_peak_size() const {
+		return peak;
+	}
+
+	// Memória alocada para os elementos, em bytes.
+	size_t get_memory_usage() const {
+		return elements.capacity() * sizeof(T *);
+	}
+
 protected:
 	// Funções auxiliares.
 	static inline size_t get_parent(size_t elem) {	return (elem - 1) >> 1;	};
@@ -135,6 +204,7 @@ private:
 	Compare cmp;
 	GetIndex getid;
 	SetIndex setid;
+	size_t peak;
 };
 
 #endif // _HEAP_H_
@@ -0,0 +1,137 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "lpastar.h"
+
+#include <algorithm>
+
+using namespace std;
+
+// "Infinito" usado pelas distâncias, o mesmo de Node.
+static double const INFINITE_DIST = 1.0E9;
+
+LPAstar::LPAstar(Graph &_g, Node const *src, Node const *dst)
+	: g(_g), start(src), goal(dst), queue(KeyCmp()), expansions(0) {
+	State init = {INFINITE_DIST, INFINITE_DIST, 0, 0, 0, false};
+	states.resize(static_cast<size_t>(g.get_width()) * g.get_height(), init);
+
+	// Apenas a origem começa localmente inconsistente.
+	State *st = &states[index_of(start)];
+	st->rhs = 0;
+	compute_key(st, start);
+	st->queued = true;
+	queue.insert(st);
+}
+
+void LPAstar::compute_key(State *st, Node const *node) {
+	double best = min(st->g, st->rhs);
+	st->k1 = best + node->distance_to(goal);
+	st->k2 = best;
+}
+
+/*
+ * Recalcula rhs do nó a partir de seus vizinhos e o coloca na fila se (e só
+ * se) ele ficar localmente inconsistente.
+ */
+void LPAstar::update_vertex(Node *node) {
+	State *st = &states[index_of(node)];
+	if (node != start) {
+		double rhs = INFINITE_DIST;
+		if (!node->is_blocked()) {
+			// O grafo é não-direcionado: os predecessores são os vizinhos.
+			Node *adj[MAX_NEIGHBOURS];
+			unsigned count = g.get_adjacent_nodes(node, adj);
+			for (unsigned ii = 0; ii < count; ii++) {
+				double dist = states[index_of(adj[ii])].g + adj[ii]->distance_to(node);
+				rhs = min(rhs, dist);
+			}
+		}
+		st->rhs = rhs;
+	}
+
+	if (st->g != st->rhs) {
+		compute_key(st, node);
+		if (st->queued) {
+			queue.reposition(st);
+		} else {
+			st->queued = true;
+			queue.insert(st);
+		}
+	} else if (st->queued) {
+		st->queued = false;
+		queue.remove(st);
+	}
+}
+
+bool LPAstar::compute() {
+	expansions = 0;
+	State *target = &states[index_of(goal)];
+	while (!queue.empty()) {
+		State *top = queue.top();
+		State goalkey = *target;
+		compute_key(&goalkey, goal);
+		if (!KeyCmp()(top, &goalkey) && target->rhs == target->g) {
+			break;
+		}
+
+		queue.extract();
+		top->queued = false;
+		expansions++;
+
+		Node *node = node_of(top);
+		Node *adj[MAX_NEIGHBOURS];
+		unsigned count = g.get_adjacent_nodes(node, adj);
+		if (top->g > top->rhs) {
+			// Sobreconsistente: a distância diminuiu.
+			top->g = top->rhs;
+		} else {
+			// Subconsistente: a distância aumentou; o próprio nó também tem que
+			// ser reavaliado.
+			top->g = INFINITE_DIST;
+			update_vertex(node);
+		}
+		for (unsigned ii = 0; ii < count; ii++) {
+			update_vertex(adj[ii]);
+		}
+	}
+	return target->g < INFINITE_DIST;
+}
+
+void LPAstar::cell_changed(int x, int y) {
+	Node *node = g.get_node(x, y);
+	if (!node) {
+		return;
+	}
+	/*
+	 * Mudam as arestas que chegam ao nó e também as diagonais entre seus
+	 * vizinhos que passam pela "quina" do nó, de modo que o nó e todos os seus
+	 * vizinhos (bloqueados ou não) têm que ser reavaliados.
+	 */
+	for (int dy = -1; dy <= 1; dy++) {
+		for (int dx = -1; dx <= 1; dx++) {
+			Node *adj = g.get_node(x + dx, y + dy);
+			if (adj) {
+				update_vertex(adj);
+			}
+		}
+	}
+}
+
+double LPAstar::get_distance() const {
+	return states[index_of(goal)].g;
+}
@@ -0,0 +1,120 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _LPASTAR_H_
+#define _LPASTAR_H_
+
+#include "graph.h"
+#include "heap.h"
+
+#include <vector>
+
+/*
+ * Lifelong Planning A* (Koenig, Likhachev e Furcy, 2004). Mantém o resultado
+ * da última busca entre uma origem e um destino fixos e, quando nós do mapa
+ * mudam de estado, repara apenas a parte afetada da solução em vez de buscar
+ * tudo de novo.
+ *
+ * O estado da busca fica em um vetor próprio, e não nos nós do grafo, de modo
+ * que buscas comuns (ShortestPath) podem ser feitas no mesmo grafo sem
+ * atrapalhar o LPA*. Do grafo são usados apenas os nós e as adjacências.
+ */
+// Tolerância na comparação das chaves de prioridade.
+#define KEY_EPSILON 1.0E-9
+
+class LPAstar {
+public:
+	LPAstar(Graph &g, Node const *src, Node const *dst);
+
+	/*
+	 * Calcula (ou, após mudanças no mapa, recalcula) o caminho mínimo.
+	 * Retorna se o destino é alcançável.
+	 */
+	bool compute();
+
+	/*
+	 * Avisa que o nó (x, y) mudou de estado (veja Graph::set_blocked). Deve ser
+	 * chamado depois da mudança; o reparo é feito na próxima chamada a
+	 * compute().
+	 */
+	void cell_changed(int x, int y);
+
+	// Distância da origem ao destino calculada pela última chamada a compute().
+	double get_distance() const;
+
+	// Nós expandidos (retirados da fila) pela última chamada a compute().
+	size_t get_expansions() const   {	return expansions;	}
+
+private:
+	struct State {
+		double g, rhs;
+		// Chave de prioridade; só tem significado enquanto está na fila.
+		double k1, k2;
+		size_t heapindex;
+		bool queued;
+	};
+
+	/*
+	 * A primeira componente da chave é g + h, e somas diferentes que deveriam
+	 * dar o mesmo valor podem diferir no último bit; sem a tolerância, o
+	 * desempate pela segunda componente falha e a busca pode parar cedo demais.
+	 */
+	struct KeyCmp {
+		bool operator()(State const *lhs, State const *rhs) const {
+			return lhs->k1 + KEY_EPSILON < rhs->k1
+			    || (lhs->k1 <= rhs->k1 + KEY_EPSILON && lhs->k2 < rhs->k2);
+		}
+	};
+
+	struct GetIndex {
+		size_t operator()(State const *st) const {
+			return st->heapindex;
+		}
+	};
+
+	struct SetIndex {
+		void operator()(State *st, size_t index) const {
+			st->heapindex = index;
+		}
+	};
+
+	typedef Heap<State, KeyCmp, GetIndex, SetIndex> Queue;
+
+	size_t index_of(Node const *node) const {
+		return static_cast<size_t>(node->get_y()) * g.get_width() + node->get_x();
+	}
+	Node *node_of(State const *st) {
+		size_t idx = st - &states[0];
+		return g.get_node(idx % g.get_width(), idx / g.get_width());
+	}
+
+	void compute_key(State *st, Node const *node);
+	void update_vertex(Node *node);
+
+	Graph &g;
+	Node const *start, *goal;
+	std::vector<State> states;
+	Queue queue;
+	size_t expansions;
+
+	// Não copiável: a fila guarda ponteiros para states.
+	LPAstar(LPAstar const &);
+	LPAstar &operator=(LPAstar const &);
+};
+
+#endif // _LPASTAR_H_
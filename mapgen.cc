@@ -0,0 +1,522 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Gerador de mapas octile sintéticos e de cenários correspondentes, para
+ * testes de escalabilidade além dos tamanhos dos mapas de benchmark.
+ */
+
+#include "ScenarioLoader.h"
+#include "graph.h"
+#include "random.h"
+#include "search.h"
+#include "tiledgraph.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Grade de caracteres no formato dos arquivos .map.
+class Grid {
+public:
+	Grid(unsigned _w, unsigned _h) : w(_w), h(_h), cells(_w * _h, '.') {
+	}
+
+	char &at(unsigned x, unsigned y)        {	return cells[w * y + x];	}
+	unsigned get_width() const              {	return w;	}
+	unsigned get_height() const             {	return h;	}
+
+	bool save(char const *fname) const {
+		ofstream fout(fname, ios::out);
+		if (!fout.good()) {
+			return false;
+		}
+		fout << "type octile" << endl
+		     << "height " << h << endl
+		     << "width " << w << endl
+		     << "map" << endl;
+		for (unsigned jj = 0; jj < h; jj++) {
+			fout.write(&cells[w * jj], w);
+			fout.put('\n');
+		}
+		return fout.good();
+	}
+
+private:
+	unsigned w, h;
+	vector<char> cells;
+};
+
+// Obstáculos aleatórios independentes, com a densidade dada.
+static void gen_random(Grid &grid, Random &rnd, double density) {
+	for (unsigned jj = 0; jj < grid.get_height(); jj++) {
+		for (unsigned ii = 0; ii < grid.get_width(); ii++) {
+			grid.at(ii, jj) = rnd.uniform() < density ? '@' : '.';
+		}
+	}
+}
+
+// Campo aberto com pilares isolados esparsos.
+static void gen_pillars(Grid &grid, Random &rnd, double density) {
+	for (unsigned jj = 0; jj < grid.get_height(); jj++) {
+		for (unsigned ii = 0; ii < grid.get_width(); ii++) {
+			grid.at(ii, jj) = rnd.uniform() < density ? 'T' : '.';
+		}
+	}
+}
+
+// Região retangular (inclusive) ainda a ser dividida pelo gerador de labirintos.
+struct Region {
+	unsigned x0, y0, x1, y1;
+};
+
+/*
+ * Labirinto por divisão recursiva: as passagens ficam nas coordenadas pares e
+ * as paredes nas ímpares. Usa uma pilha explícita, já que a recursão pode ser
+ * profunda em mapas grandes.
+ */
+static void gen_maze(Grid &grid, Random &rnd) {
+	unsigned w = grid.get_width(), h = grid.get_height();
+	// Se a última linha ou coluna for ímpar, ela vira parede.
+	for (unsigned jj = 0; jj < h; jj++) {
+		for (unsigned ii = 0; ii < w; ii++) {
+			bool edge = ((w & 1) == 0 && ii == w - 1) || ((h & 1) == 0 && jj == h - 1);
+			grid.at(ii, jj) = edge ? '@' : '.';
+		}
+	}
+
+	Region first = {0, 0, (w - 1) & ~1u, (h - 1) & ~1u};
+	vector<Region> stack;
+	stack.push_back(first);
+	while (!stack.empty()) {
+		Region reg = stack.back();
+		stack.pop_back();
+		unsigned rw = reg.x1 - reg.x0, rh = reg.y1 - reg.y0;
+		if (rw < 2 && rh < 2) {
+			continue;
+		}
+		// Divide perpendicularmente ao lado mais comprido.
+		bool horizontal = rh > rw || (rh == rw && rnd.below(2) == 0);
+		if (horizontal) {
+			unsigned wy = reg.y0 + 1 + 2 * rnd.below(rh / 2);
+			unsigned gx = reg.x0 + 2 * rnd.below(rw / 2 + 1);
+			for (unsigned ii = reg.x0; ii <= reg.x1; ii++) {
+				if (ii != gx) {
+					grid.at(ii, wy) = '@';
+				}
+			}
+			Region top = {reg.x0, reg.y0, reg.x1, wy - 1};
+			Region bottom = {reg.x0, wy + 1, reg.x1, reg.y1};
+			stack.push_back(top);
+			stack.push_back(bottom);
+		} else {
+			unsigned wx = reg.x0 + 1 + 2 * rnd.below(rw / 2);
+			unsigned gy = reg.y0 + 2 * rnd.below(rh / 2 + 1);
+			for (unsigned jj = reg.y0; jj <= reg.y1; jj++) {
+				if (jj != gy) {
+					grid.at(wx, jj) = '@';
+				}
+			}
+			Region left = {reg.x0, reg.y0, wx - 1, reg.y1};
+			Region right = {wx + 1, reg.y0, reg.x1, reg.y1};
+			stack.push_back(left);
+			stack.push_back(right);
+		}
+	}
+}
+
+// Parede entre uma sala e a sala à sua direita (vertical) ou abaixo dela.
+struct Wall {
+	unsigned room;
+	bool vertical;
+};
+
+// Union-find simples, usado para garantir que todas as salas são conectadas.
+static unsigned find_root(vector<unsigned> &parent, unsigned ii) {
+	while (parent[ii] != ii) {
+		parent[ii] = parent[parent[ii]];
+		ii = parent[ii];
+	}
+	return ii;
+}
+
+/*
+ * Salas quadradas separadas por paredes de largura 1. As portas de uma árvore
+ * geradora aleatória das salas estão sempre abertas (de modo que o mapa é
+ * conexo); as demais portas abrem com a probabilidade dada.
+ */
+static void gen_rooms(Grid &grid, Random &rnd, unsigned roomsize, double density) {
+	unsigned w = grid.get_width(), h = grid.get_height();
+	unsigned const stride = roomsize + 1;
+	for (unsigned jj = 0; jj < h; jj++) {
+		for (unsigned ii = 0; ii < w; ii++) {
+			bool wall = (ii % stride) == roomsize || (jj % stride) == roomsize;
+			grid.at(ii, jj) = wall ? '@' : '.';
+		}
+	}
+
+	unsigned nx = (w + stride - 1) / stride, ny = (h + stride - 1) / stride;
+	unsigned const doorwidth = std::max(1u, roomsize / 8);
+
+	vector<Wall> walls;
+	for (unsigned jj = 0; jj < ny; jj++) {
+		for (unsigned ii = 0; ii < nx; ii++) {
+			if (ii + 1 < nx) {
+				Wall wall = {jj * nx + ii, true};
+				walls.push_back(wall);
+			}
+			if (jj + 1 < ny) {
+				Wall wall = {jj * nx + ii, false};
+				walls.push_back(wall);
+			}
+		}
+	}
+	// Embaralha (Fisher-Yates) e aplica Kruskal.
+	for (size_t ii = walls.size(); ii > 1; ii--) {
+		std::swap(walls[ii - 1], walls[rnd.below(ii)]);
+	}
+	vector<unsigned> parent(nx * ny);
+	for (unsigned ii = 0; ii < parent.size(); ii++) {
+		parent[ii] = ii;
+	}
+
+	for (size_t kk = 0; kk < walls.size(); kk++) {
+		Wall const &wall = walls[kk];
+		unsigned rx = wall.room % nx, ry = wall.room / nx;
+		unsigned other = wall.vertical ? wall.room + 1 : wall.room + nx;
+		unsigned ra = find_root(parent, wall.room), rb = find_root(parent, other);
+		if (ra != rb) {
+			parent[ra] = rb;
+		} else if (rnd.uniform() >= density) {
+			continue;
+		}
+		// Abre a porta em uma posição aleatória ao longo da parede.
+		if (wall.vertical) {
+			unsigned wx = rx * stride + roomsize;
+			unsigned y0 = ry * stride, y1 = std::min(y0 + roomsize, h);
+			unsigned span = y1 - y0 > doorwidth ? y1 - y0 - doorwidth + 1 : 1;
+			unsigned dy = y0 + rnd.below(span);
+			for (unsigned jj = dy; jj < dy + doorwidth && jj < y1; jj++) {
+				grid.at(wx, jj) = '.';
+			}
+		} else {
+			unsigned wy = ry * stride + roomsize;
+			unsigned x0 = rx * stride, x1 = std::min(x0 + roomsize, w);
+			unsigned span = x1 - x0 > doorwidth ? x1 - x0 - doorwidth + 1 : 1;
+			unsigned dx = x0 + rnd.below(span);
+			for (unsigned ii = dx; ii < dx + doorwidth && ii < x1; ii++) {
+				grid.at(ii, wy) = '.';
+			}
+		}
+	}
+}
+
+// Ordena experimentos por bucket, como nos cenários de benchmark.
+struct CompareBucket {
+	bool operator()(Experiment const &lhs, Experiment const &rhs) const {
+		return lhs.GetBucket() < rhs.GetBucket();
+	}
+};
+
+// Grava os experimentos, ordenados por bucket, usando o mapa dado.
+static void save_scenario(vector<Experiment> exps, char const *mapname,
+                          char const *scenname) {
+	std::stable_sort(exps.begin(), exps.end(), CompareBucket());
+	ScenarioLoader scen;
+	for (size_t ii = 0; ii < exps.size(); ii++) {
+		Experiment const &exp = exps[ii];
+		scen.AddExperiment(Experiment(exp.GetStartX(), exp.GetStartY(), exp.GetGoalX(),
+		                              exp.GetGoalY(), exp.GetXScale(), exp.GetYScale(),
+		                              exp.GetBucket(), exp.GetDistance(), mapname));
+	}
+	scen.Save(scenname);
+}
+
+/*
+ * Gera experimentos entre pares aleatórios de nós passáveis e mutuamente
+ * alcançáveis, com a distância de referência calculada por Dijkstra.
+ */
+static bool gen_scenario(char const *mapname, vector<Experiment> &exps, Random &rnd,
+                         int count) {
+	Graph g(mapname);
+	if (!g.is_valid()) {
+		cerr << "Grafo '" << mapname << "' invalido ou inexistente." << endl;
+		return false;
+	}
+
+	int w = g.get_width(), h = g.get_height();
+	exps.reserve(count);
+	// Evita laço infinito em mapas quase totalmente bloqueados.
+	long tries = 100L * count + 1000;
+	while (static_cast<int>(exps.size()) < count && tries-- > 0) {
+		int sx = rnd.below(w), sy = rnd.below(h);
+		int gx = rnd.below(w), gy = rnd.below(h);
+		Node *src = g.get_node(sx, sy);
+		Node const *dst = g.get_node(gx, gy);
+		if (src == dst || src->is_blocked() || dst->is_blocked()) {
+			continue;
+		}
+
+		size_t ins, upd, pop;
+		ShortestPath(g, src, dst, DijkstraCmp(), DijkstraSuccessors(), ins, upd, pop);
+		if (dst->get_parent() == 0) {
+			continue;
+		}
+		double dist = dst->get_distance();
+		// Mesmo critério dos cenários de benchmark: buckets de 4 unidades.
+		exps.push_back(Experiment(sx, sy, gx, gy, w, h, static_cast<int>(dist / 4),
+		                          dist, mapname));
+	}
+	if (static_cast<int>(exps.size()) < count) {
+		cerr << "Apenas " << exps.size() << " de " << count
+		     << " experimentos foram gerados." << endl;
+	}
+	return true;
+}
+
+/*
+ * Gera diretamente em blocos um mapa com obstáculos aleatórios, sem nunca ter
+ * o mapa inteiro na memória; permite mapas maiores que os de Graph.
+ */
+static bool gen_tiled_random(char const *tiledname, unsigned w, unsigned h, unsigned side,
+                             Random &rnd, double density) {
+	ofstream fout(tiledname, ios::out | ios::binary);
+	if (!fout.good()) {
+		return false;
+	}
+	fout << "type tiled" << endl
+	     << "height " << h << endl
+	     << "width " << w << endl
+	     << "tile " << side << endl
+	     << "data" << endl;
+	size_t tilebytes = (static_cast<size_t>(side) * side + 7) / 8;
+	vector<unsigned char> bits(tilebytes);
+	for (unsigned ty = 0; ty < h; ty += side) {
+		for (unsigned tx = 0; tx < w; tx += side) {
+			bits.assign(tilebytes, 0);
+			for (unsigned jj = 0; jj < side; jj++) {
+				for (unsigned ii = 0; ii < side; ii++) {
+					bool outside = tx + ii >= w || ty + jj >= h;
+					if (outside || rnd.uniform() < density) {
+						unsigned bit = jj * side + ii;
+						bits[bit >> 3] |= 1 << (bit & 7);
+					}
+				}
+			}
+			fout.write(reinterpret_cast<char const *>(&bits[0]), tilebytes);
+		}
+	}
+	return fout.good();
+}
+
+// Limites para os experimentos em mapas em blocos: distância máxima entre
+// origem e destino em cada eixo e expansões antes de desistir de um par.
+#define TILED_MAX_OFFSET 2048
+#define TILED_MAX_EXPANSIONS 4000000
+
+/*
+ * Como gen_scenario, mas para mapas em blocos, que podem ser grandes demais
+ * para Dijkstra: as distâncias de referência são calculadas com A* (também
+ * ótimo), com origem e destino próximos e um limite de expansões, para que
+ * pares inalcançáveis não façam a busca varrer o mapa inteiro.
+ */
+static bool gen_tiled_scenario(char const *tiledname, vector<Experiment> &exps, Random &rnd,
+                               int count, size_t tilebudget, size_t nodebudget) {
+	TiledGraph g(tiledname, tilebudget, nodebudget);
+	if (!g.is_valid()) {
+		cerr << "Grafo '" << tiledname << "' invalido ou inexistente." << endl;
+		return false;
+	}
+
+	int w = g.get_width(), h = g.get_height();
+	exps.reserve(count);
+	long tries = 100L * count + 1000;
+	while (static_cast<int>(exps.size()) < count && tries-- > 0) {
+		int sx = rnd.below(w), sy = rnd.below(h);
+		int gx = sx + static_cast<int>(rnd.below(2 * TILED_MAX_OFFSET + 1)) - TILED_MAX_OFFSET;
+		int gy = sy + static_cast<int>(rnd.below(2 * TILED_MAX_OFFSET + 1)) - TILED_MAX_OFFSET;
+		g.release_nodes();
+		TiledNode *src = g.get_node(sx, sy);
+		TiledNode const *dst = g.get_node(gx, gy);
+		if (!src || !dst || src == dst || src->is_blocked() || dst->is_blocked()) {
+			continue;
+		}
+
+		typedef BasicAstarCmp<TiledNode> Cmp;
+		size_t failures = g.get_node_failures();
+		SearchTask<Cmp, DijkstraSuccessors, TiledGraph> task(g, src, dst, Cmp(dst),
+		                                                     DijkstraSuccessors());
+		// Se faltou memória para os nós, a distância não é confiável.
+		if (task.step(static_cast<size_t>(TILED_MAX_EXPANSIONS)) != eSearchFound
+		    || g.get_node_failures() != failures) {
+			continue;
+		}
+		double dist = dst->get_distance();
+		exps.push_back(Experiment(sx, sy, gx, gy, w, h, static_cast<int>(dist / 4),
+		                          dist, tiledname));
+	}
+	if (static_cast<int>(exps.size()) < count) {
+		cerr << "Apenas " << exps.size() << " de " << count
+		     << " experimentos foram gerados." << endl;
+	}
+	return true;
+}
+
+static void usage() {
+	cerr << "Uso: mapgen [-s seed] [-n experimentos] [-d densidade] [-r sala] [-T]"
+	     << " <random|maze|rooms|pillars> <lado|LxA> <prefixo>" << endl
+	     << "       mapgen tile <mapa> <prefixo>" << endl
+	     << "Gera <prefixo>.map e <prefixo>.map.scen. Com -T, gera tambem o mapa" << endl
+	     << "em blocos <prefixo>.tmap e <prefixo>.tmap.scen; mapas random com -T" << endl
+	     << "podem ter ate 2^31 - 1 nos por lado, e se passarem de 32767 so a" << endl
+	     << "versao em blocos e gerada. 'tile' converte um mapa existente para" << endl
+	     << "<prefixo>.tmap." << endl;
+}
+
+// Lado dos blocos dos mapas em blocos gerados.
+#define TMAP_TILE_SIDE 64
+
+// Memória para os blocos e para os nós ao gerar cenários de mapas em blocos.
+#define TMAP_TILE_BUDGET (64 * 1024 * 1024)
+#define TMAP_NODE_BUDGET (256 * 1024 * 1024)
+
+int main(int argc, char *argv[]) {
+	uint64_t seed = 1;
+	int count = 100;
+	double density = -1.0;
+	unsigned roomsize = 16;
+	bool tiled = false;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "s:n:d:r:T")) != -1) {
+		switch (opt) {
+			case 's':
+				seed = strtoull(optarg, 0, 10);
+				break;
+			case 'n':
+				count = atoi(optarg);
+				break;
+			case 'd':
+				density = atof(optarg);
+				break;
+			case 'r':
+				roomsize = atoi(optarg);
+				break;
+			case 'T':
+				tiled = true;
+				break;
+			default:
+				usage();
+				return 1;
+		}
+	}
+	if (argc - optind != 3 || count < 0 || roomsize == 0) {
+		usage();
+		return 1;
+	}
+
+	string type = argv[optind];
+	string tiledname = string(argv[optind + 2]) + ".tmap";
+	if (type == "tile") {
+		if (!TiledGraph::convert(argv[optind + 1], tiledname.c_str(), TMAP_TILE_SIDE)) {
+			cerr << "Erro ao converter '" << argv[optind + 1] << "'." << endl;
+			return 1;
+		}
+		return 0;
+	}
+
+	unsigned w, h;
+	int nread = sscanf(argv[optind + 1], "%ux%u", &w, &h);
+	if (nread == 1) {
+		h = w;
+	}
+	// Node guarda as coordenadas em shorts; TiledNode, em ints.
+	unsigned maxside = tiled && type == "random" ? 2147483647u : 32767u;
+	if (nread < 1 || w == 0 || h == 0 || w > maxside || h > maxside) {
+		cerr << "Tamanho invalido: '" << argv[optind + 1] << "'." << endl;
+		return 1;
+	}
+	string mapname = string(argv[optind + 2]) + ".map";
+	string scenname = mapname + ".scen";
+
+	Random rnd(seed);
+	if (w > 32767 || h > 32767) {
+		// Grande demais para Grid e Graph: só a versão em blocos.
+		vector<Experiment> exps;
+		string tiledscen = tiledname + ".scen";
+		if (!gen_tiled_random(tiledname.c_str(), w, h, TMAP_TILE_SIDE, rnd,
+		                      density < 0 ? 0.25 : density)) {
+			cerr << "Erro ao gravar '" << tiledname << "'." << endl;
+			return 1;
+		}
+		if (count > 0) {
+			if (!gen_tiled_scenario(tiledname.c_str(), exps, rnd, count, TMAP_TILE_BUDGET,
+			                        TMAP_NODE_BUDGET)) {
+				return 1;
+			}
+			save_scenario(exps, tiledname.c_str(), tiledscen.c_str());
+		}
+		return 0;
+	}
+
+	Grid grid(w, h);
+	if (type == "random") {
+		gen_random(grid, rnd, density < 0 ? 0.25 : density);
+	} else if (type == "maze") {
+		gen_maze(grid, rnd);
+	} else if (type == "rooms") {
+		gen_rooms(grid, rnd, roomsize, density < 0 ? 0.3 : density);
+	} else if (type == "pillars") {
+		gen_pillars(grid, rnd, density < 0 ? 0.05 : density);
+	} else {
+		cerr << "Tipo de mapa invalido: '" << type << "'." << endl;
+		usage();
+		return 1;
+	}
+
+	if (!grid.save(mapname.c_str())) {
+		cerr << "Erro ao gravar '" << mapname << "'." << endl;
+		return 1;
+	}
+	vector<Experiment> exps;
+	if (count > 0) {
+		if (!gen_scenario(mapname.c_str(), exps, rnd, count)) {
+			return 1;
+		}
+		save_scenario(exps, mapname.c_str(), scenname.c_str());
+	}
+	if (tiled) {
+		if (!TiledGraph::convert(mapname.c_str(), tiledname.c_str(), TMAP_TILE_SIDE)) {
+			cerr << "Erro ao gravar '" << tiledname << "'." << endl;
+			return 1;
+		}
+		if (count > 0) {
+			string tiledscen = tiledname + ".scen";
+			save_scenario(exps, tiledname.c_str(), tiledscen.c_str());
+		}
+	}
+	return 0;
+}
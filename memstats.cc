@@ -0,0 +1,61 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "memstats.h"
+#include "graph.h"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <iostream>
+
+using namespace std;
+
+MemStats::OpenListHook MemStats::openhook = 0;
+
+size_t MemStats::get_resident_bytes() {
+	// Segundo campo de /proc/self/statm: páginas residentes.
+	FILE *fin = fopen("/proc/self/statm", "r");
+	if (!fin) {
+		return 0;
+	}
+	unsigned long size, resident;
+	int nread = fscanf(fin, "%lu %lu", &size, &resident);
+	fclose(fin);
+	if (nread != 2) {
+		return 0;
+	}
+	return resident * sysconf(_SC_PAGESIZE);
+}
+
+void MemStats::dump_node_layout(ostream &out) {
+	Node const *node = 0;
+	size_t used = sizeof(node->parent) + sizeof(node->heapindex) + sizeof(node->dist)
+	            + sizeof(node->clr) + sizeof(node->from) + sizeof(node->x)
+	            + sizeof(node->y) + sizeof(node->blocked);
+	out << "node = " << sizeof(Node) << " B"
+	    << " (parent " << sizeof(node->parent)
+	    << ", heapindex " << sizeof(node->heapindex)
+	    << ", dist " << sizeof(node->dist)
+	    << ", clr " << sizeof(node->clr)
+	    << ", from " << sizeof(node->from)
+	    << ", x " << sizeof(node->x)
+	    << ", y " << sizeof(node->y)
+	    << ", blocked " << sizeof(node->blocked)
+	    << ", padding " << sizeof(Node) - used << ")";
+}
@@ -0,0 +1,60 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _MEMSTATS_H_
+#define _MEMSTATS_H_
+
+#include <cstddef>
+#include <iosfwd>
+
+/*
+ * Contabilidade de memória que faz parte da biblioteca: memória residente,
+ * composição dos nós e o registro do pico da lista aberta das buscas. O
+ * registro é um gancho que não faz nada até que um programa instale sua
+ * função (o driver instala a de AllocStats, em allocstats.h); a contagem das
+ * alocações em si não faz parte da biblioteca, para não trocar o alocador de
+ * quem a usa.
+ */
+class MemStats {
+public:
+	typedef void (*OpenListHook)(size_t peak);
+
+	// Instala (ou, com 0, remove) a função chamada por record_open_list.
+	static void set_open_list_hook(OpenListHook hook) {
+		openhook = hook;
+	}
+
+	// Registra o tamanho máximo atingido pela lista aberta de uma busca.
+	static void record_open_list(size_t peak) {
+		if (openhook) {
+			openhook(peak);
+		}
+	}
+
+	// Memória residente do processo, lida de /proc (0 se indisponível).
+	static size_t get_resident_bytes();
+
+	// Imprime a composição de um nó do grafo, campo a campo.
+	static void dump_node_layout(std::ostream &out);
+
+private:
+	static OpenListHook openhook;
+};
+
+#endif // _MEMSTATS_H_
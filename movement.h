@@ -0,0 +1,277 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MOVEMENT_H_
+#define _MOVEMENT_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+/*
+ * Políticas de movimento e de métrica dos grafos em grade, resolvidas em tempo
+ * de compilação: os grafos (veja GridModel), as buscas e as heurísticas são
+ * instanciados para cada combinação, sem testes do modelo nos laços internos.
+ * O modelo padrão, usado diretamente por Graph e TiledGraph (e pelos métodos
+ * que só funcionam nele, como JPS), é DefaultMovement com DefaultMetric.
+ */
+
+// Direções usadas em JPS.
+enum Direction {
+	eNorth,
+	eNorthEast,
+	eEast,
+	eSouthEast,
+	eSouth,
+	eSouthWest,
+	eWest,
+	eNorthWest
+};
+
+// Deslocamento de cada direção na grade (y cresce para o sul).
+static int const DIR_DX[] = {0, 1, 1, 1, 0, -1, -1, -1};
+static int const DIR_DY[] = {-1, -1, 0, 1, 1, 1, 0, -1};
+
+// Maior número de vizinhos de um nó, em qualquer modelo de movimento.
+enum {
+	MAX_NEIGHBOURS = 8
+};
+
+static inline bool is_diagonal(Direction dir) {
+	return (dir & 1) != 0;
+}
+
+// Direção de um passo entre nós vizinhos; dx e dy em {-1, 0, 1}, não ambos 0.
+static inline Direction step_direction(int dx, int dy) {
+	static Direction const dirs[3][3] = {
+		{eNorthWest, eWest, eSouthWest},
+		{eNorth, eNorth, eSouth},
+		{eNorthEast, eEast, eSouthEast}
+	};
+	return dirs[dx + 1][dy + 1];
+}
+
+/*
+ * Regras para passos diagonais, dadas as passabilidades dos dois nós
+ * ortogonais por onde o passo corta a quina.
+ */
+// Sempre pode, mesmo entre dois nós bloqueados.
+struct CornerCutAny {
+	static char const *name()   {	return "any";	}
+	static bool allows(bool, bool) {
+		return true;
+	}
+};
+
+// Pode se pelo menos um dos dois for passável (a regra original).
+struct CornerCutOne {
+	static char const *name()   {	return "one";	}
+	static bool allows(bool side1, bool side2) {
+		return side1 || side2;
+	}
+};
+
+// Só pode se os dois forem passáveis: nunca corta quinas.
+struct CornerCutNone {
+	static char const *name()   {	return "none";	}
+	static bool allows(bool side1, bool side2) {
+		return side1 && side2;
+	}
+};
+
+/*
+ * Movimento em 8 direções com a regra de quinas dada. A grade G tem que
+ * oferecer is_passable(x, y), falso para nós fora da grade.
+ */
+template <typename Corner>
+struct EightConnected {
+	enum {
+		NUM_DIRS = 8
+	};
+
+	static Direction get_dir(unsigned ii) {
+		return static_cast<Direction>(ii);
+	}
+
+	template <typename G>
+	static bool can_step(G &g, int x, int y, Direction dir) {
+		int nx = x + DIR_DX[dir], ny = y + DIR_DY[dir];
+		if (!g.is_passable(nx, ny)) {
+			return false;
+		}
+		return !is_diagonal(dir) || Corner::allows(g.is_passable(nx, y), g.is_passable(x, ny));
+	}
+};
+
+// Movimento apenas nas 4 direções ortogonais.
+struct FourConnected {
+	enum {
+		NUM_DIRS = 4
+	};
+
+	static Direction get_dir(unsigned ii) {
+		return static_cast<Direction>(2 * ii);
+	}
+
+	template <typename G>
+	static bool can_step(G &g, int x, int y, Direction dir) {
+		return !is_diagonal(dir) && g.is_passable(x + DIR_DX[dir], y + DIR_DY[dir]);
+	}
+};
+
+typedef EightConnected<CornerCutOne> DefaultMovement;
+
+/*
+ * Vizinhos de um nó no modelo de movimento Move, dados por
+ * g.get_adjacent(node, dir) em cada direção do modelo: é a implementação de
+ * get_adjacent_nodes e get_adjacent_list de todos os grafos em grade. adj
+ * tem que ter espaço para MAX_NEIGHBOURS nós.
+ */
+template <typename Move, typename G, typename N>
+inline unsigned adjacent_nodes(G &g, N const *node, N **adj) {
+	unsigned count = 0;
+	for (unsigned ii = 0; ii < Move::NUM_DIRS; ii++) {
+		N *next = g.get_adjacent(node, Move::get_dir(ii));
+		if (next) {
+			adj[count++] = next;
+		}
+	}
+	return count;
+}
+
+template <typename Move, typename G, typename N>
+inline std::vector<N *> adjacent_list(G &g, N const *node) {
+	N *adj[MAX_NEIGHBOURS];
+	unsigned count = adjacent_nodes<Move>(g, node, adj);
+	return std::vector<N *>(adj, adj + count);
+}
+
+/*
+ * Métricas: cost(dx, dy) é ao mesmo tempo o custo de um passo com esse
+ * deslocamento e a heurística entre nós com essa diferença de coordenadas;
+ * para todas, a heurística é consistente com os custos dos passos. cost_type
+ * é o tipo em que o custo é calculado; as distâncias acumuladas nos nós são
+ * sempre double.
+ */
+// "Octile distance": baseada nos movimentos permitidos, ortogonais e
+// diagonais em 45 graus.
+struct OctileMetric {
+	typedef double cost_type;
+	static char const *name()   {	return "octile";	}
+	// Custo a mais de um passo diagonal sobre um ortogonal: o custo é
+	// max(dx, dy) + diagonal_excess() * min(dx, dy).
+	static double diagonal_excess() {
+		return 1.414213562373095048801688 - 1.0;
+	}
+	static cost_type cost(int dx, int dy) {
+		dx = std::abs(dx);
+		dy = std::abs(dy);
+		return 1.0 * std::max(dx, dy) + diagonal_excess() * std::min(dx, dy);
+	}
+};
+
+// Métrica Euclideana padrão.
+struct EuclideanMetric {
+	typedef double cost_type;
+	static char const *name()   {	return "euclidean";	}
+	static cost_type cost(int dx, int dy) {
+		return std::sqrt(1.0 * (dx * dx + dy * dy));
+	}
+};
+
+// Métrica de Manhattan: um passo diagonal custa o mesmo que dois ortogonais.
+struct ManhattanMetric {
+	typedef int cost_type;
+	static char const *name()   {	return "manhattan";	}
+	static cost_type cost(int dx, int dy) {
+		return std::abs(dx) + std::abs(dy);
+	}
+};
+
+// Métrica de Chebyshev: um passo diagonal custa o mesmo que um ortogonal.
+struct ChebyshevMetric {
+	typedef int cost_type;
+	static char const *name()   {	return "chebyshev";	}
+	static cost_type cost(int dx, int dy) {
+		return std::max(std::abs(dx), std::abs(dy));
+	}
+};
+
+typedef OctileMetric DefaultMetric;
+
+// Distância entre dois nós na métrica dada.
+template <typename Metric, typename N>
+inline double metric_distance(N const *lhs, N const *rhs) {
+	return Metric::cost(lhs->get_x() - rhs->get_x(), lhs->get_y() - rhs->get_y());
+}
+
+/*
+ * Visão de um grafo em grade (Graph ou TiledGraph) com outro modelo de
+ * movimento e métrica. Oferece a mesma interface usada pelas buscas, e os
+ * nós, com o estado das buscas, são os do grafo original.
+ */
+template <typename G, typename Move, typename Metric>
+class GridModel {
+public:
+	typedef typename G::node_type node_type;
+
+	explicit GridModel(G &_g) : g(_g) {		}
+
+	unsigned get_width() const      {	return g.get_width();	}
+	unsigned get_height() const     {	return g.get_height();	}
+
+	bool is_passable(int x, int y) {
+		return g.is_passable(x, y);
+	}
+
+	node_type *get_node(int x, int y) {
+		return g.get_node(x, y);
+	}
+
+	static double distance(node_type const *lhs, node_type const *rhs) {
+		return metric_distance<Metric>(lhs, rhs);
+	}
+
+	node_type *get_adjacent(node_type const *node, Direction dir) {
+		int x = node->get_x(), y = node->get_y();
+		if (!Move::can_step(g, x, y, dir)) {
+			return 0;
+		}
+		return g.get_node(x + DIR_DX[dir], y + DIR_DY[dir]);
+	}
+
+	std::vector<node_type *> get_adjacent_list(node_type const *node) {
+		return adjacent_list<Move>(*this, node);
+	}
+
+	unsigned get_adjacent_nodes(node_type const *node, node_type **adj) {
+		return adjacent_nodes<Move>(*this, node, adj);
+	}
+
+	void init_single_source(node_type *src) {
+		g.init_single_source(src);
+	}
+
+	unsigned get_search_stamp() const   {	return g.get_search_stamp();	}
+
+private:
+	G &g;
+};
+
+#endif // _MOVEMENT_H_
@@ -0,0 +1,139 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _OVERLAY_H_
+#define _OVERLAY_H_
+
+#include "movement.h"
+
+#include <deque>
+#include <vector>
+
+/*
+ * Visão de um grafo em grade (Graph ou TiledGraph) com nós próprios: a
+ * passabilidade vem do grafo original, mas os nós, com o estado das buscas,
+ * só são criados quando uma busca chega até eles, como em TiledGraph. Assim,
+ * várias buscas podem usar o mesmo mapa ao mesmo tempo, cada uma com sua
+ * visão, e preparar uma nova busca custa apenas o número de nós já criados.
+ *
+ * O índice dos nós é dividido em páginas de PAGE_SIDE x PAGE_SIDE células,
+ * alocadas quando o primeiro nó delas é criado; ao contrário de uma tabela
+ * de dispersão, nunca precisa ser refeito por inteiro, e o custo de cada
+ * acesso é limitado.
+ */
+template <typename G>
+class SearchOverlay {
+public:
+	typedef typename G::node_type node_type;
+
+	explicit SearchOverlay(G &_g)
+		: g(_g), pagesw((_g.get_width() + PAGE_SIDE - 1) >> PAGE_SHIFT),
+		  pages(pagesw * ((_g.get_height() + PAGE_SIDE - 1) >> PAGE_SHIFT), static_cast<node_type **>(0)) {
+	}
+
+	~SearchOverlay() {
+		release_nodes();
+	}
+
+	unsigned get_width() const      {	return g.get_width();	}
+	unsigned get_height() const     {	return g.get_height();	}
+
+	bool is_passable(int x, int y) {
+		return g.is_passable(x, y);
+	}
+
+	static double distance(node_type const *lhs, node_type const *rhs) {
+		return G::distance(lhs, rhs);
+	}
+
+	/*
+	 * Retorna o nó nas coordenadas dadas, criando-o se ainda não existir, ou 0
+	 * para um nó fora dos limites.
+	 */
+	node_type *get_node(int x, int y) {
+		if (x < 0 || static_cast<unsigned>(x) >= g.get_width()
+		    || y < 0 || static_cast<unsigned>(y) >= g.get_height()) {
+			return 0;
+		}
+		node_type **&page = pages[(y >> PAGE_SHIFT) * pagesw + (x >> PAGE_SHIFT)];
+		if (!page) {
+			page = new node_type *[PAGE_SIDE * PAGE_SIDE]();
+		}
+		node_type *&slot = page[((y & (PAGE_SIDE - 1)) << PAGE_SHIFT) | (x & (PAGE_SIDE - 1))];
+		if (!slot) {
+			pool.push_back(node_type(x, y, !g.is_passable(x, y)));
+			slot = &pool.back();
+		}
+		return slot;
+	}
+
+	node_type *get_adjacent(node_type const *node, Direction dir) {
+		int x = node->get_x(), y = node->get_y();
+		if (!DefaultMovement::can_step(g, x, y, dir)) {
+			return 0;
+		}
+		return get_node(x + DIR_DX[dir], y + DIR_DY[dir]);
+	}
+
+	std::vector<node_type *> get_adjacent_list(node_type const *node) {
+		return adjacent_list<DefaultMovement>(*this, node);
+	}
+
+	unsigned get_adjacent_nodes(node_type const *node, node_type **adj) {
+		return adjacent_nodes<DefaultMovement>(*this, node, adj);
+	}
+
+	// Prepara os nós já criados para uma nova busca.
+	void init_single_source(node_type *src) {
+		for (typename std::deque<node_type>::iterator it = pool.begin(); it != pool.end(); ++it) {
+			it->init_single_source();
+		}
+		src->set_distance(0);
+	}
+
+	// Descarta todos os nós criados, invalidando ponteiros para eles.
+	void release_nodes() {
+		pool.clear();
+		for (size_t ii = 0; ii < pages.size(); ii++) {
+			delete [] pages[ii];
+			pages[ii] = 0;
+		}
+	}
+
+	size_t get_num_nodes() const        {	return pool.size();	}
+
+private:
+	enum {
+		PAGE_SHIFT = 6,
+		PAGE_SIDE = 1 << PAGE_SHIFT
+	};
+
+	G &g;
+	// Nós criados; o deque não move os nós já criados ao crescer.
+	std::deque<node_type> pool;
+	// Páginas do índice, pagesw por linha; 0 para páginas sem nós.
+	size_t pagesw;
+	std::vector<node_type **> pages;
+
+	// Não copiável: o índice aponta para o próprio pool.
+	SearchOverlay(SearchOverlay const &);
+	SearchOverlay &operator=(SearchOverlay const &);
+};
+
+#endif // _OVERLAY_H_
@@ -0,0 +1,127 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "pathengine.h"
+#include "memstats.h"
+#include "profiler.h"
+
+using namespace std;
+
+template <typename G>
+BasicPathEngine<G>::BasicPathEngine(G &_g)
+	: g(_g), dijkstra(DijkstraCmp()), astar(AstarCmp(0)), weighted(WeightedCmp(0, 1.0)),
+	  stamp(_g.get_search_stamp()), fullreset(true), ins(0), upd(0), pop(0) {
+}
+
+template <typename G>
+char const *BasicPathEngine<G>::get_algorithm_name(Algorithm alg) {
+	static char const *const names[eNumAlgorithms] = {
+		"dijkstra", "astar", "jps", "canon-dijkstra", "canon-astar", "weighted"
+	};
+	return alg < eNumAlgorithms ? names[alg] : "?";
+}
+
+template <typename G>
+bool BasicPathEngine<G>::find_path(Node *src, Node const *dst, Algorithm alg,
+                                   Options const &opts) {
+	switch (alg) {
+		case eDijkstra:
+			dijkstra.clear(DijkstraCmp());
+			return search(dijkstra, src, dst, DijkstraSuccessors(opts.pruning, opts.bounds));
+		case eAstar:
+			astar.clear(AstarCmp(dst));
+			return search(astar, src, dst, DijkstraSuccessors(opts.pruning, opts.bounds));
+		case eJPS:
+			astar.clear(AstarCmp(dst));
+			return search(astar, src, dst, BasicJPSSuccessors<G>(opts.pruning, opts.bounds));
+		case eCanonDijkstra:
+			dijkstra.clear(DijkstraCmp());
+			return search(dijkstra, src, dst, BasicCanonicalSuccessors<G>());
+		case eCanonAstar:
+			astar.clear(AstarCmp(dst));
+			return search(astar, src, dst, BasicCanonicalSuccessors<G>());
+		case eWeightedAstar:
+			weighted.clear(WeightedCmp(dst, opts.weight));
+			return search(weighted, src, dst, DijkstraSuccessors(opts.pruning, opts.bounds));
+		default:
+			break;
+	}
+	return false;
+}
+
+template <typename G>
+size_t BasicPathEngine<G>::get_memory_usage() const {
+	return sizeof(*this) + dijkstra.get_memory_usage() + astar.get_memory_usage()
+	     + weighted.get_memory_usage() + touched.capacity() * sizeof(Node *);
+}
+
+/*
+ * Reinicia os nós alterados pela consulta anterior e prepara a origem. Se a
+ * marca de busca do grafo mudou desde a consulta anterior, outra busca mexeu
+ * nos nós (ou eles foram recriados), e a lista de alterados não vale mais:
+ * reinicia todos.
+ */
+template <typename G>
+void BasicPathEngine<G>::prepare(Node *src) {
+	PROFILE_SCOPE(ePhaseReset);
+	if (fullreset || g.get_search_stamp() != stamp) {
+		g.init_single_source(src);
+		stamp = g.get_search_stamp();
+		fullreset = false;
+	} else {
+		for (typename vector<Node *>::iterator it = touched.begin(); it != touched.end(); ++it) {
+			(*it)->init_single_source();
+		}
+		src->set_distance(0);
+	}
+	touched.clear();
+}
+
+/*
+ * Laço principal de SearchTask (veja expand_next) sobre o heap reusado. Todo
+ * nó cujo estado muda passa pelo heap, de modo que os nós alterados são os
+ * extraídos mais os que sobraram nele no fim.
+ */
+template <typename G>
+template <typename Compare, typename Successors>
+bool BasicPathEngine<G>::search(Heap<Node, Compare, GetIndex, SetIndex> &heap,
+                                Node *src, Node const *dst, Successors succ) {
+	PROFILE_SCOPE(ePhaseSearch);
+	prepare(src);
+	ins = upd = pop = 0;
+
+	heap.insert(src);
+	ins++;
+	SearchStatus status = eSearchRunning;
+	while (status == eSearchRunning) {
+		Node *u;
+		status = expand_next(g, heap, src, dst, succ, ins, upd, pop, u);
+		if (u) {
+			touched.push_back(u);
+		}
+	}
+	for (size_t ii = 0; ii < heap.size(); ii++) {
+		touched.push_back(heap.get(ii));
+	}
+	MemStats::record_open_list(heap.get_peak_size());
+	return status == eSearchFound;
+}
+
+template class BasicPathEngine<Graph>;
+template class BasicPathEngine<TiledGraph>;
@@ -0,0 +1,133 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _PATHENGINE_H_
+#define _PATHENGINE_H_
+
+#include "deadends.h"
+#include "goalbounds.h"
+#include "graph.h"
+#include "heap.h"
+#include "search.h"
+#include "tiledgraph.h"
+
+#include <vector>
+
+/*
+ * Motor de consultas de caminho mínimo para ser embutido em outros programas
+ * (veja libtpgrafos.a no Makefile). Guarda uma referência ao grafo e os heaps
+ * das buscas, que são reusados de uma consulta para a outra sem realocação.
+ *
+ * O estado das buscas fica nos nós do grafo, como em ShortestPath, mas só os
+ * nós alterados pela consulta anterior (os que passaram pelo heap) são
+ * reiniciados, e não o grafo inteiro; o custo de preparar uma consulta é
+ * proporcional ao tamanho da anterior, e não ao do mapa. Se outra busca
+ * reiniciar os nós do grafo, ou se os nós forem recriados (um novo mapa
+ * atribuído ao mesmo Graph, ou TiledGraph::release_nodes), a marca de busca
+ * do grafo muda, e a próxima consulta reinicia o grafo inteiro.
+ *
+ * Instanciado para Graph (PathEngine) e TiledGraph (TiledPathEngine).
+ */
+template <typename G>
+class BasicPathEngine {
+public:
+	typedef typename G::node_type Node;
+
+	enum Algorithm {
+		eDijkstra,
+		eAstar,
+		eJPS,
+		eCanonDijkstra,		// Dijkstra com ordem canônica.
+		eCanonAstar,		// A* com ordem canônica.
+		eWeightedAstar,		// A* ponderado; subótimo.
+		eNumAlgorithms
+	};
+
+	/*
+	 * Opções de uma consulta. As podas valem para Dijkstra, A*, JPS e A*
+	 * ponderado; as regiões sem saída têm que já estar preparadas com
+	 * DeadEnds::set_query para a consulta.
+	 */
+	struct Options {
+		Options() : pruning(0), bounds(0), weight(2.0) {
+		}
+		DeadEnds const *pruning;
+		GoalBounds const *bounds;
+		// Peso da heurística no A* ponderado.
+		double weight;
+	};
+
+	explicit BasicPathEngine(G &_g);
+
+	static char const *get_algorithm_name(Algorithm alg);
+
+	/*
+	 * Busca o caminho mínimo de src a dst. Retorna se o destino foi
+	 * alcançado; a distância e o caminho (pelos pais) ficam nos nós, como em
+	 * ShortestPath.
+	 */
+	bool find_path(Node *src, Node const *dst, Algorithm alg,
+	               Options const &opts = Options());
+
+	/*
+	 * Faz a próxima consulta reiniciar todos os nós do grafo. Só é preciso
+	 * se os nós forem alterados sem mudar a marca de busca do grafo.
+	 */
+	void reset()                    {	fullreset = true;	}
+
+	G &get_graph() const            {	return g;	}
+
+	// Contadores de inserções, atualizações e remoções do heap na última consulta.
+	size_t get_inserts() const      {	return ins;	}
+	size_t get_updates() const      {	return upd;	}
+	size_t get_pops() const         {	return pop;	}
+
+	// Memória ocupada pelos heaps e pela lista de nós alterados, em bytes.
+	size_t get_memory_usage() const;
+
+private:
+	typedef BasicAstarCmp<Node> AstarCmp;
+	typedef BasicWeightedAstarCmp<Node> WeightedCmp;
+
+	template <typename Compare, typename Successors>
+	bool search(Heap<Node, Compare, GetIndex, SetIndex> &heap, Node *src,
+	            Node const *dst, Successors succ);
+	void prepare(Node *src);
+
+	G &g;
+	// Um heap por função de comparação; trocar o destino só troca a função.
+	Heap<Node, DijkstraCmp, GetIndex, SetIndex> dijkstra;
+	Heap<Node, AstarCmp, GetIndex, SetIndex> astar;
+	Heap<Node, WeightedCmp, GetIndex, SetIndex> weighted;
+	// Nós alterados pela última consulta.
+	std::vector<Node *> touched;
+	// Marca de busca do grafo quando a lista acima foi formada.
+	unsigned stamp;
+	bool fullreset;
+	size_t ins, upd, pop;
+
+	// Não copiável: os heaps apontam para os nós do grafo.
+	BasicPathEngine(BasicPathEngine const &);
+	BasicPathEngine &operator=(BasicPathEngine const &);
+};
+
+typedef BasicPathEngine<Graph> PathEngine;
+typedef BasicPathEngine<TiledGraph> TiledPathEngine;
+
+#endif // _PATHENGINE_H_
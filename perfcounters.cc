@@ -0,0 +1,150 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "perfcounters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+#ifdef __linux__
+// Não há wrapper na glibc para esta chamada de sistema.
+static int perf_event_open(perf_event_attr *attr) {
+	// Conta apenas este processo, em qualquer CPU, e só em modo usuário (o que
+	// funciona mesmo com perf_event_paranoid == 2).
+	return syscall(__NR_perf_event_open, attr, 0, -1, -1, 0);
+}
+
+static int open_counter(PerfCounters::Event ev) {
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	switch (ev) {
+		case PerfCounters::eCycles:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CPU_CYCLES;
+			break;
+		case PerfCounters::eInstructions:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+			break;
+		case PerfCounters::eL1DMisses:
+			attr.type = PERF_TYPE_HW_CACHE;
+			attr.config = PERF_COUNT_HW_CACHE_L1D
+			            | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+			            | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+			break;
+		case PerfCounters::eLLCMisses:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CACHE_MISSES;
+			break;
+		case PerfCounters::eBranchMisses:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+			break;
+		default:
+			return -1;
+	}
+	return perf_event_open(&attr);
+}
+#endif
+
+PerfCounters::PerfCounters() {
+	for (int ii = 0; ii < eNumEvents; ii++) {
+#ifdef __linux__
+		fds[ii] = open_counter(static_cast<Event>(ii));
+#else
+		fds[ii] = -1;
+#endif
+		values[ii] = 0;
+	}
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+	for (int ii = 0; ii < eNumEvents; ii++) {
+		if (fds[ii] >= 0) {
+			close(fds[ii]);
+		}
+	}
+#endif
+}
+
+bool PerfCounters::is_available() const {
+	for (int ii = 0; ii < eNumEvents; ii++) {
+		if (fds[ii] >= 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void PerfCounters::start() {
+#ifdef __linux__
+	for (int ii = 0; ii < eNumEvents; ii++) {
+		if (fds[ii] >= 0) {
+			ioctl(fds[ii], PERF_EVENT_IOC_RESET, 0);
+			ioctl(fds[ii], PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+#endif
+}
+
+void PerfCounters::stop() {
+#ifdef __linux__
+	// Desliga todos primeiro, para que a leitura de um não seja contada nos
+	// outros.
+	for (int ii = 0; ii < eNumEvents; ii++) {
+		if (fds[ii] >= 0) {
+			ioctl(fds[ii], PERF_EVENT_IOC_DISABLE, 0);
+		}
+	}
+	for (int ii = 0; ii < eNumEvents; ii++) {
+		values[ii] = 0;
+		if (fds[ii] < 0) {
+			continue;
+		}
+		// Valor, tempo habilitado, tempo rodando.
+		uint64_t buf[3];
+		if (read(fds[ii], buf, sizeof(buf)) != sizeof(buf)) {
+			continue;
+		}
+		if (buf[2] != 0 && buf[2] < buf[1]) {
+			// O contador foi multiplexado; faz uma extrapolação linear.
+			values[ii] = static_cast<uint64_t>(static_cast<double>(buf[0]) * buf[1] / buf[2]);
+		} else {
+			values[ii] = buf[0];
+		}
+	}
+#endif
+}
+
+char const *PerfCounters::get_name(Event ev) {
+	static char const *const names[] = {"cycles", "instr", "l1dmiss",
+	                                    "llcmiss", "brmiss"};
+	return ev < eNumEvents ? names[ev] : "?";
+}
@@ -0,0 +1,71 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _PERFCOUNTERS_H_
+#define _PERFCOUNTERS_H_
+
+#include <stdint.h>
+
+/*
+ * Contadores de desempenho do hardware, obtidos via perf_event_open (apenas
+ * Linux). Cada contador é aberto separadamente; os que não puderem ser abertos
+ * (kernel sem suporte, máquina virtual sem PMU, perf_event_paranoid muito
+ * restritivo) ficam simplesmente indisponíveis, e os demais continuam
+ * funcionando normalmente.
+ */
+class PerfCounters {
+public:
+	enum Event {
+		eCycles,
+		eInstructions,
+		eL1DMisses,
+		eLLCMisses,
+		eBranchMisses,
+		eNumEvents
+	};
+
+	PerfCounters();
+	~PerfCounters();
+
+	// Se pelo menos um contador está disponível.
+	bool is_available() const;
+	// Se o contador dado está disponível.
+	bool has(Event ev) const        {	return fds[ev] >= 0;	}
+
+	// Zera e liga todos os contadores disponíveis.
+	void start();
+	// Desliga os contadores e guarda os valores lidos.
+	void stop();
+
+	// Valor lido na última chamada a stop(), já corrigido para o caso de o
+	// kernel ter multiplexado os contadores.
+	uint64_t get(Event ev) const    {	return values[ev];	}
+
+	// Nome curto do evento, para impressão.
+	static char const *get_name(Event ev);
+
+private:
+	int fds[eNumEvents];
+	uint64_t values[eNumEvents];
+
+	// Não copiável: os descritores de arquivo pertencem a este objeto.
+	PerfCounters(PerfCounters const &);
+	PerfCounters &operator=(PerfCounters const &);
+};
+
+#endif // _PERFCOUNTERS_H_
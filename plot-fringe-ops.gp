@@ -0,0 +1,21 @@
+set term png small size 800,600
+set output "plots/fringe-ops.png"
+
+set title "Fringe: List Ops x Path Len"
+
+set xlabel "Path Len"
+set ylabel "List Ops"
+
+set xrange [0:511]
+
+set key default
+set key box
+set key samplen .2
+set key ins vert
+set key left top
+
+plot "plots/fringe.data" using 1:2 title "Average-Stdev" with lines, \
+     "plots/fringe.data" using 1:3 title "Average" with lines, \
+     "plots/fringe.data" using 1:4 title "Average+Stdev" with lines, \
+     "plots/fringe.data" using 1:5 title "Minimum" with lines, \
+     "plots/fringe.data" using 1:6 title "Maximum" with lines
@@ -0,0 +1,21 @@
+set term png small size 800,600
+set output "plots/fringe-time.png"
+
+set title "Fringe: Time x Path Len"
+
+set xlabel "Path Len"
+set ylabel "Time (s)"
+
+set xrange [0:511]
+
+set key default
+set key box
+set key samplen .2
+set key ins vert
+set key left top
+
+plot "plots/fringe.data" using 1:7 title "Average-Stdev" with lines, \
+     "plots/fringe.data" using 1:8 title "Average" with lines, \
+     "plots/fringe.data" using 1:9 title "Average+Stdev" with lines, \
+     "plots/fringe.data" using 1:10 title "Minimum" with lines, \
+     "plots/fringe.data" using 1:11 title "Maximum" with lines
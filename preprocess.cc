@@ -0,0 +1,369 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Pré-processamento em lote: calcula os arquivos auxiliares (regiões sem
+ * saída, .dead, e caixas de destinos, .bounds) de todos os mapas de um ou mais
+ * diretórios, usando todos os processadores. Os arquivos têm versão do formato
+ * e a soma de verificação do mapa (veja DeadEnds::map_checksum), e os que já
+ * estão atualizados não são recalculados.
+ */
+
+#include "deadends.h"
+#include "goalbounds.h"
+#include "graph.h"
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static inline double usec2sec(timeval const &tim) {
+	return tim.tv_sec + (tim.tv_usec / 1000000.0);
+}
+
+static inline double delta_t(timeval const &start, timeval const &finish) {
+	return usec2sec(finish) - usec2sec(start);
+}
+
+// Arquivos auxiliares que podem ser calculados, selecionáveis com -k.
+enum Kind {
+	eDeadEnds   = 1 << 0,
+	eBounds     = 1 << 1,
+	eAllKinds   = eDeadEnds | eBounds
+};
+
+// Limite de -j; mais linhas do que isso não ajudam em nenhum mapa.
+enum {
+	MAX_THREADS = 1024
+};
+
+// Estado de um arquivo auxiliar depois do processamento.
+enum Outcome {
+	eSkipped,		// Já estava atualizado.
+	eBuilt,			// Foi calculado e gravado.
+	eFailed			// Não pôde ser gravado.
+};
+
+static char const *outcome_name(Outcome res) {
+	static char const *const names[] = {"skipped", "built", "failed"};
+	return names[res];
+}
+
+/*
+ * Fila de mapas compartilhada pelas linhas de execução. Cada uma pega o
+ * próximo mapa com um incremento atômico, como as linhas de GoalBounds::build;
+ * a saída e os totais são protegidos por um mutex.
+ *
+ * As -j linhas são um orçamento só: cada linha que pega mapas ocupa uma, e
+ * 'spare' conta as que não estão com ninguém (as que sobram quando há menos
+ * mapas do que linhas, e as das linhas que saíram por falta de mapas). O
+ * cálculo das caixas de um mapa pega parte delas emprestada e as devolve no
+ * fim, de modo que nunca há mais de -j linhas trabalhando.
+ */
+struct BatchJob {
+	vector<string> maps;
+	unsigned kinds;
+	bool force;
+	unsigned threads;
+	unsigned workers;
+	size_t next;
+	// Alterados só com operações atômicas.
+	unsigned spare, active;
+
+	pthread_mutex_t lock;
+	// 'cells' só conta os mapas calculados.
+	size_t built, skipped, failed, cells;
+};
+
+/*
+ * Pega emprestada uma parte das linhas livres, dividindo-as entre as linhas
+ * que ainda pegam mapas; retorna quantas pegou, que têm que ser devolvidas
+ * com release_threads.
+ */
+static unsigned claim_threads(BatchJob &job) {
+	unsigned spare = __sync_add_and_fetch(&job.spare, 0);
+	for (;;) {
+		unsigned active = max(1u, __sync_add_and_fetch(&job.active, 0));
+		unsigned share = (spare + active - 1) / active;
+		unsigned prev = __sync_val_compare_and_swap(&job.spare, spare, spare - share);
+		if (prev == spare) {
+			return share;
+		}
+		spare = prev;
+	}
+}
+
+static void release_threads(BatchJob &job, unsigned count) {
+	__sync_fetch_and_add(&job.spare, count);
+}
+
+// Calcula (se necessário) as regiões sem saída do mapa.
+static Outcome process_deadends(Graph &g, string const &mapname, bool force,
+                                ostream &err) {
+	string const fname = mapname + ".dead";
+	DeadEnds deadends;
+	if (!force && deadends.load(fname.c_str(), g, err)) {
+		return eSkipped;
+	}
+	deadends.build(g);
+	return deadends.save(fname.c_str()) ? eBuilt : eFailed;
+}
+
+/*
+ * Calcula (se necessário) as caixas de destinos do mapa, com a linha atual e
+ * as livres que conseguir pegar; nthreads recebe o total usado.
+ */
+static Outcome process_bounds(BatchJob &job, Graph &g, string const &mapname,
+                              unsigned &nthreads, ostream &err) {
+	string const fname = mapname + ".bounds";
+	GoalBounds bounds;
+	if (!job.force && bounds.load(fname.c_str(), g, err)) {
+		return eSkipped;
+	}
+	unsigned extra = claim_threads(job);
+	nthreads = 1 + extra;
+	bounds.build(g, nthreads);
+	release_threads(job, extra);
+	return bounds.save(fname.c_str()) ? eBuilt : eFailed;
+}
+
+static void process_map(BatchJob &job, size_t index) {
+	string const &mapname = job.maps[index];
+	timeval start, finish;
+	gettimeofday(&start, NULL);
+	// Os erros de leitura também são juntados e escritos com o mutex.
+	ostringstream err;
+	Graph g(mapname.c_str(), Graph::eRowMajor, err);
+	if (!g.is_valid()) {
+		pthread_mutex_lock(&job.lock);
+		cerr << err.str() << "Grafo '" << mapname << "' invalido ou inexistente." << endl;
+		job.failed++;
+		pthread_mutex_unlock(&job.lock);
+		return;
+	}
+
+	// Monta a linha inteira antes, para não misturar a saída das linhas.
+	ostringstream line;
+	line << "map = " << mapname << ", size = " << g.get_width() << "x" << g.get_height();
+	bool built = false, failed = false;
+	if (job.kinds & eDeadEnds) {
+		Outcome res = process_deadends(g, mapname, job.force, err);
+		line << ", dead = " << outcome_name(res);
+		built |= res == eBuilt;
+		failed |= res == eFailed;
+	}
+	if (job.kinds & eBounds) {
+		unsigned nthreads = 1;
+		Outcome res = process_bounds(job, g, mapname, nthreads, err);
+		line << ", bounds = " << outcome_name(res);
+		if (res == eBuilt) {
+			line << " (" << nthreads << " threads)";
+		}
+		built |= res == eBuilt;
+		failed |= res == eFailed;
+	}
+	gettimeofday(&finish, NULL);
+	line << ", time = " << delta_t(start, finish);
+
+	pthread_mutex_lock(&job.lock);
+	cerr << err.str();
+	cout << line.str() << endl;
+	if (failed) {
+		cerr << "Nao foi possivel gravar os arquivos de '" << mapname << "'." << endl;
+		job.failed++;
+	} else if (built) {
+		job.built++;
+		job.cells += static_cast<size_t>(g.get_width()) * g.get_height();
+	} else {
+		job.skipped++;
+	}
+	pthread_mutex_unlock(&job.lock);
+}
+
+static void *worker_main(void *arg) {
+	BatchJob &job = *static_cast<BatchJob *>(arg);
+	size_t index;
+	while ((index = __sync_fetch_and_add(&job.next, 1)) < job.maps.size()) {
+		process_map(job, index);
+	}
+	// Sem mais mapas: a linha fica livre para os cálculos ainda em andamento.
+	__sync_fetch_and_sub(&job.active, 1);
+	release_threads(job, 1);
+	return 0;
+}
+
+// Se o nome termina com o sufixo dado.
+static bool ends_with(string const &name, string const &suffix) {
+	return name.size() > suffix.size()
+	    && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/*
+ * Acrescenta à lista os mapas (.map) do diretório dado, em ordem alfabética;
+ * um arquivo .map também pode ser passado diretamente.
+ */
+static bool collect_maps(char const *path, vector<string> &maps) {
+	string const dirname(path);
+	DIR *dir = opendir(path);
+	if (!dir) {
+		if (ends_with(dirname, ".map")) {
+			maps.push_back(dirname);
+			return true;
+		}
+		return false;
+	}
+	vector<string> found;
+	while (dirent *ent = readdir(dir)) {
+		string name(ent->d_name);
+		if (ends_with(name, ".map")) {
+			found.push_back(dirname + "/" + name);
+		}
+	}
+	closedir(dir);
+	sort(found.begin(), found.end());
+	maps.insert(maps.end(), found.begin(), found.end());
+	return true;
+}
+
+static bool parse_kinds(char const *list, unsigned &kinds) {
+	kinds = 0;
+	istringstream sin(list);
+	string name;
+	while (getline(sin, name, ',')) {
+		if (name == "dead") {
+			kinds |= eDeadEnds;
+		} else if (name == "bounds") {
+			kinds |= eBounds;
+		} else if (name == "all") {
+			kinds |= eAllKinds;
+		} else {
+			return false;
+		}
+	}
+	return kinds != 0;
+}
+
+static void usage() {
+	cerr << "Uso: preprocess [-j linhas] [-k tipo[,tipo...]] [-f] <diretorio|mapa> [...]" << endl
+	     << "Calcula os arquivos auxiliares de todos os mapas .map dos diretorios" << endl
+	     << "dados, gravados ao lado de cada mapa; os que ja estao atualizados" << endl
+	     << "(mesma versao do formato e mesmo mapa) sao mantidos." << endl
+	     << "  -j: linhas de execucao, de 1 a " << MAX_THREADS << " (padrao: numero de" << endl
+	     << "      processadores)" << endl
+	     << "  -k: arquivos a calcular: dead (<mapa>.dead, regioes sem saida)," << endl
+	     << "      bounds (<mapa>.bounds, caixas de destinos) ou all (padrao)" << endl
+	     << "  -f: recalcula mesmo os arquivos atualizados" << endl;
+}
+
+int main(int argc, char *argv[]) {
+	BatchJob job;
+	job.kinds = eAllKinds;
+	job.force = false;
+	job.threads = 0;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "j:k:f")) != -1) {
+		switch (opt) {
+			case 'j': {
+				// Lido com sinal, para que valores negativos sejam rejeitados.
+				char *end;
+				long value = strtol(optarg, &end, 10);
+				if (*optarg == '\0' || *end != '\0' || value < 1 || value > MAX_THREADS) {
+					usage();
+					return 1;
+				}
+				job.threads = value;
+				break;
+			}
+			case 'k':
+				if (!parse_kinds(optarg, job.kinds)) {
+					usage();
+					return 1;
+				}
+				break;
+			case 'f':
+				job.force = true;
+				break;
+			default:
+				usage();
+				return 1;
+		}
+	}
+	if (optind >= argc) {
+		usage();
+		return 1;
+	}
+
+	for (int ii = optind; ii < argc; ii++) {
+		if (!collect_maps(argv[ii], job.maps)) {
+			cerr << "Diretorio '" << argv[ii] << "' inexistente." << endl;
+			return 1;
+		}
+	}
+	if (job.threads == 0) {
+		long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+		job.threads = ncpus > 0 ? min(ncpus, static_cast<long>(MAX_THREADS)) : 1;
+	}
+	job.workers = min(static_cast<size_t>(job.threads), max(job.maps.size(), static_cast<size_t>(1)));
+	job.next = 0;
+	job.spare = job.threads - job.workers;
+	job.active = job.workers;
+	job.built = job.skipped = job.failed = job.cells = 0;
+	pthread_mutex_init(&job.lock, NULL);
+
+	timeval start, finish;
+	gettimeofday(&start, NULL);
+	vector<pthread_t> tids(job.workers);
+	// A linha de execução atual também trabalha, como a última.
+	unsigned started = 1;
+	for (unsigned ii = 0; ii + 1 < job.workers; ii++) {
+		if (pthread_create(&tids[ii], NULL, worker_main, &job) != 0) {
+			break;
+		}
+		started++;
+	}
+	// As linhas que não puderam ser criadas ficam livres.
+	__sync_fetch_and_sub(&job.active, job.workers - started);
+	release_threads(job, job.workers - started);
+	worker_main(&job);
+	for (unsigned ii = 0; ii + 1 < started; ii++) {
+		pthread_join(tids[ii], NULL);
+	}
+	gettimeofday(&finish, NULL);
+	pthread_mutex_destroy(&job.lock);
+
+	double time = delta_t(start, finish);
+	size_t nmaps = job.maps.size();
+	cout << "#### maps = " << nmaps << " (built " << job.built << ", skipped "
+	     << job.skipped << ", failed " << job.failed << "), cells = " << job.cells
+	     << ", threads = " << job.threads << ", time = " << time
+	     << ", maps/s = " << (time > 0 ? nmaps / time : 0.0)
+	     << ", cells/s = " << (time > 0 ? job.cells / time : 0.0) << " ####" << endl;
+	return job.failed ? 2 : 0;
+}
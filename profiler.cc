@@ -0,0 +1,43 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "profiler.h"
+
+#ifdef PROFILE_PHASES
+
+uint64_t Profiler::cycles[eNumPhases];
+uint64_t Profiler::calls[eNumPhases];
+uint64_t Profiler::counts[eNumCounters];
+ScopedPhaseTimer *Profiler::current = 0;
+
+void Profiler::reset() {
+	for (int ii = 0; ii < eNumPhases; ii++) {
+		cycles[ii] = calls[ii] = 0;
+	}
+	for (int ii = 0; ii < eNumCounters; ii++) {
+		counts[ii] = 0;
+	}
+}
+
+char const *Profiler::get_name(Phase ph) {
+	static char const *const names[] = {"search", "reset", "extract", "sift",
+	                                    "successors", "jump", "forced"};
+	return ph < eNumPhases ? names[ph] : "?";
+}
+
+#endif // PROFILE_PHASES
@@ -0,0 +1,135 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+/*
+ * Perfilador das fases internas das buscas. Só existe se PROFILE_PHASES for
+ * definido (veja o alvo 'profile' do Makefile); caso contrário, as macros
+ * PROFILE_SCOPE e PROFILE_COUNT não geram código algum.
+ */
+
+// Fases medidas. Fases podem estar aninhadas (por exemplo, "jump" ocorre
+// dentro de "successors"); o tempo de cada fase exclui o das fases internas.
+enum Phase {
+	ePhaseSearch,		// Resto do laço principal de ShortestPath.
+	ePhaseReset,		// Graph::init_single_source.
+	ePhaseExtract,		// Heap::extract.
+	ePhaseSift,			// Reorganização do heap (subida ou descida).
+	ePhaseSuccessors,	// Geração de sucessores e relaxações.
+	ePhaseJump,			// Chamadas de nível mais alto a JPSSuccessors::jump.
+	ePhaseForced,		// Verificação de vizinhos forçados.
+	eNumPhases
+};
+
+// Contadores que não são fases.
+enum ProfileCounter {
+	eCountJumpCalls,	// Chamadas a jump, inclusive as recursivas.
+	eCountJumpSteps,	// Nós percorridos por jump.
+	eNumCounters
+};
+
+#ifdef PROFILE_PHASES
+
+#include <stdint.h>
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+class ScopedPhaseTimer;
+
+// Contadores globais. A busca é toda feita em uma única thread.
+class Profiler {
+public:
+	static void reset();
+
+	static uint64_t get_cycles(Phase ph)        {	return cycles[ph];	}
+	static uint64_t get_calls(Phase ph)         {	return calls[ph];	}
+	static uint64_t get_count(ProfileCounter c) {	return counts[c];	}
+	static void add_count(ProfileCounter c, uint64_t n) {
+		counts[c] += n;
+	}
+
+	static char const *get_name(Phase ph);
+
+	// Contador de ciclos (TSC em x86, nanossegundos nos demais).
+	static inline uint64_t read_cycles() {
+#if defined(__i386__) || defined(__x86_64__)
+		return __rdtsc();
+#else
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+	}
+
+private:
+	friend class ScopedPhaseTimer;
+	static uint64_t cycles[eNumPhases];
+	static uint64_t calls[eNumPhases];
+	static uint64_t counts[eNumCounters];
+	static ScopedPhaseTimer *current;
+};
+
+/*
+ * Mede o tempo desde a construção até a destruição e o atribui à fase dada,
+ * descontando o tempo gasto em temporizadores aninhados.
+ */
+class ScopedPhaseTimer {
+public:
+	explicit ScopedPhaseTimer(Phase ph)
+		: phase(ph), parent(Profiler::current), inner(0) {
+		Profiler::current = this;
+		start = Profiler::read_cycles();
+	}
+
+	~ScopedPhaseTimer() {
+		uint64_t elapsed = Profiler::read_cycles() - start;
+		Profiler::cycles[phase] += elapsed - inner;
+		Profiler::calls[phase]++;
+		if (parent) {
+			parent->inner += elapsed;
+		}
+		Profiler::current = parent;
+	}
+
+private:
+	Phase phase;
+	ScopedPhaseTimer *parent;
+	uint64_t start, inner;
+
+	ScopedPhaseTimer(ScopedPhaseTimer const &);
+	ScopedPhaseTimer &operator=(ScopedPhaseTimer const &);
+};
+
+#define PROFILE_CONCAT2(a, b) a ## b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#define PROFILE_SCOPE(ph) ScopedPhaseTimer PROFILE_CONCAT(_phase_timer_, __LINE__)(ph)
+#define PROFILE_COUNT(c, n) Profiler::add_count(c, n)
+
+#else
+
+#define PROFILE_SCOPE(ph) do {} while (0)
+#define PROFILE_COUNT(c, n) do {} while (0)
+
+#endif // PROFILE_PHASES
+
+#endif // _PROFILER_H_
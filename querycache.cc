@@ -0,0 +1,261 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "querycache.h"
+
+#include <algorithm>
+
+using namespace std;
+
+QueryCache::QueryCache(size_t _limit)
+	: limit(_limit), bytes(0), nextid(0), evictions(0), invalidations(0) {
+	for (int ii = 0; ii < eNumResults; ii++) {
+		counts[ii] = 0;
+	}
+}
+
+char const *QueryCache::get_result_name(Result res) {
+	static char const *const names[eNumResults] = {"miss", "hit", "subpath"};
+	return res < eNumResults ? names[res] : "?";
+}
+
+/*
+ * Memória estimada de uma entrada com os números de trechos e de passos
+ * dados: a entrada e seus nós nas tabelas e na lista de idades, os trechos,
+ * e, para cada nó do caminho, sua passagem no índice e o nó da tabela do
+ * índice (como se cada nó estivesse em um caminho só).
+ */
+size_t QueryCache::entry_bytes(size_t nruns, size_t nsteps) {
+	size_t const fixed = sizeof(EntryMap::value_type) + sizeof(EndpointMap::value_type)
+	                   + sizeof(size_t) + 8 * sizeof(void *);
+	size_t const percell = sizeof(CellRef) + sizeof(CellIndex::value_type) + 2 * sizeof(void *);
+	return fixed + nruns * sizeof(uint32_t) + (nsteps + 1) * percell;
+}
+
+// Todos os nós de um caminho, empacotados, da origem ao destino.
+void QueryCache::get_cells(CompactPath const &path, vector<uint32_t> &cells) {
+	cells.clear();
+	int x = path.get_start_x(), y = path.get_start_y();
+	cells.push_back(pack(x, y));
+	for (size_t ii = 0; ii < path.get_num_runs(); ii++) {
+		Direction dir = path.get_dir(ii);
+		for (uint32_t len = path.get_run_length(ii); len > 0; len--) {
+			x += DIR_DX[dir];
+			y += DIR_DY[dir];
+			cells.push_back(pack(x, y));
+		}
+	}
+}
+
+/*
+ * Retorna o identificador do mapa, descartando as entradas dele se a versão
+ * mudou desde a última consulta.
+ */
+unsigned QueryCache::check_version(string const &map, unsigned version) {
+	std::map<string, MapInfo>::iterator it = maps.find(map);
+	if (it == maps.end()) {
+		MapInfo info = {static_cast<unsigned>(maps.size()), version};
+		return maps.insert(make_pair(map, info)).first->second.id;
+	}
+	MapInfo &info = it->second;
+	if (info.version != version) {
+		vector<size_t> stale;
+		for (EntryMap::const_iterator ent = entries.begin(); ent != entries.end(); ++ent) {
+			if (ent->second.mapid == info.id) {
+				stale.push_back(ent->first);
+			}
+		}
+		for (vector<size_t>::iterator id = stale.begin(); id != stale.end(); ++id) {
+			erase(*id);
+		}
+		invalidations += stale.size();
+		info.version = version;
+	}
+	return info.id;
+}
+
+void QueryCache::touch(Entry &entry) {
+	ages.splice(ages.begin(), ages, entry.age);
+}
+
+void QueryCache::erase(size_t id) {
+	EntryMap::iterator it = entries.find(id);
+	Entry &entry = it->second;
+	get_cells(entry.path, cells);
+	for (vector<uint32_t>::const_iterator cell = cells.begin(); cell != cells.end(); ++cell) {
+		CellIndex::iterator refs = index.find(cell_key(entry.mapid, *cell));
+		vector<CellRef> &vec = refs->second;
+		for (size_t ii = 0; ii < vec.size(); ) {
+			if (vec[ii].entry == id) {
+				vec[ii] = vec.back();
+				vec.pop_back();
+			} else {
+				ii++;
+			}
+		}
+		if (vec.empty()) {
+			index.erase(refs);
+		}
+	}
+	endpoints.erase(make_pair(cell_key(entry.mapid, entry.src), entry.dst));
+	ages.erase(entry.age);
+	bytes -= entry_bytes(entry.path.get_num_runs(), cells.size() - 1);
+	entries.erase(it);
+}
+
+/*
+ * Distância (e, se 'sub' não for 0, o caminho) do pedaço de um caminho
+ * guardado entre os nós dados pelo número de passos desde a origem, em
+ * qualquer sentido. Os trechos das pontas podem ser cortados no meio.
+ */
+double QueryCache::subpath_distance(CompactPath const &path, uint32_t from, uint32_t to,
+                                    CompactPath *sub) {
+	uint32_t const first = min(from, to), last = max(from, to);
+	int x = path.get_start_x(), y = path.get_start_y();
+	int fx = x, fy = y;
+	double dist = 0;
+	// Pedaço de cada trecho entre first e last, na ordem do caminho.
+	vector<pair<Direction, uint32_t> > parts;
+	uint32_t steps = 0;
+	for (size_t run = 0; run < path.get_num_runs() && steps < last; run++) {
+		Direction dir = path.get_dir(run);
+		uint32_t const len = path.get_run_length(run);
+		uint32_t const lo = max(steps, first), hi = min(steps + len, last);
+		if (lo < hi) {
+			if (parts.empty()) {
+				fx = x + DIR_DX[dir] * static_cast<int>(lo - steps);
+				fy = y + DIR_DY[dir] * static_cast<int>(lo - steps);
+			}
+			parts.push_back(make_pair(dir, hi - lo));
+			dist += DefaultMetric::cost(DIR_DX[dir] * static_cast<int>(hi - lo),
+			                            DIR_DY[dir] * static_cast<int>(hi - lo));
+		}
+		x += DIR_DX[dir] * static_cast<int>(len);
+		y += DIR_DY[dir] * static_cast<int>(len);
+		steps += len;
+	}
+	if (sub) {
+		int lx = fx, ly = fy;
+		for (size_t ii = 0; ii < parts.size(); ii++) {
+			lx += DIR_DX[parts[ii].first] * static_cast<int>(parts[ii].second);
+			ly += DIR_DY[parts[ii].first] * static_cast<int>(parts[ii].second);
+		}
+		// Os trechos entram de trás para a frente (veja CompactPath::finish).
+		sub->clear();
+		if (from < to) {
+			for (size_t ii = parts.size(); ii-- > 0; ) {
+				sub->append(parts[ii].first, parts[ii].second);
+			}
+			sub->finish(fx, fy);
+		} else {
+			// No sentido contrário, cada trecho é percorrido na direção oposta.
+			for (size_t ii = 0; ii < parts.size(); ii++) {
+				sub->append(static_cast<Direction>((parts[ii].first + 4) & 7), parts[ii].second);
+			}
+			sub->finish(lx, ly);
+		}
+	}
+	return dist;
+}
+
+QueryCache::Result QueryCache::lookup(string const &map, unsigned version,
+                                      uint32_t src, uint32_t dst,
+                                      double &dist, CompactPath *path) {
+	unsigned const mapid = check_version(map, version);
+
+	EndpointMap::const_iterator exact = endpoints.find(make_pair(cell_key(mapid, src), dst));
+	if (exact != endpoints.end()) {
+		Entry &entry = entries.find(exact->second)->second;
+		touch(entry);
+		dist = entry.dist;
+		if (path) {
+			*path = entry.path;
+		}
+		counts[eHit]++;
+		return eHit;
+	}
+
+	// Algum caminho guardado passa pelas duas pontas?
+	CellIndex::const_iterator from = index.find(cell_key(mapid, src));
+	CellIndex::const_iterator to = index.find(cell_key(mapid, dst));
+	if (from != index.end() && to != index.end()) {
+		vector<CellRef> const &rfrom = from->second, &rto = to->second;
+		for (vector<CellRef>::const_iterator rf = rfrom.begin(); rf != rfrom.end(); ++rf) {
+			for (vector<CellRef>::const_iterator rt = rto.begin(); rt != rto.end(); ++rt) {
+				if (rf->entry == rt->entry) {
+					Entry &entry = entries.find(rf->entry)->second;
+					touch(entry);
+					dist = subpath_distance(entry.path, rf->pos, rt->pos, path);
+					counts[eSubpathHit]++;
+					return eSubpathHit;
+				}
+			}
+		}
+	}
+
+	counts[eMiss]++;
+	return eMiss;
+}
+
+void QueryCache::insert(string const &map, unsigned version, CompactPath const &path,
+                        double dist) {
+	if (path.get_num_runs() == 0) {
+		return;
+	}
+	unsigned const mapid = check_version(map, version);
+	size_t const need = entry_bytes(path.get_num_runs(), path.get_num_steps());
+	if (need > limit) {
+		return;
+	}
+	get_cells(path, cells);
+	pair<uint64_t, uint32_t> key = make_pair(cell_key(mapid, cells.front()), cells.back());
+	if (endpoints.find(key) != endpoints.end()) {
+		return;
+	}
+	while (bytes + need > limit && !ages.empty()) {
+		erase(ages.back());
+		evictions++;
+	}
+	// erase reaproveita 'cells'.
+	get_cells(path, cells);
+
+	size_t const id = nextid++;
+	Entry &entry = entries[id];
+	entry.mapid = mapid;
+	entry.src = cells.front();
+	entry.dst = cells.back();
+	entry.dist = dist;
+	entry.path = path;
+	ages.push_front(id);
+	entry.age = ages.begin();
+	endpoints[key] = id;
+	for (uint32_t pos = 0; pos < cells.size(); pos++) {
+		CellRef ref = {id, pos};
+		index[cell_key(mapid, cells[pos])].push_back(ref);
+	}
+	bytes += need;
+}
+
+void QueryCache::clear() {
+	entries.clear();
+	endpoints.clear();
+	index.clear();
+	ages.clear();
+	maps.clear();
+	bytes = 0;
+}
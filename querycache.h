@@ -0,0 +1,149 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _QUERYCACHE_H_
+#define _QUERYCACHE_H_
+
+#include "compactpath.h"
+
+#include <stdint.h>
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+#include <tr1/unordered_map>
+
+/*
+ * Cache de resultados de consultas de caminho mínimo, limitado em memória.
+ *
+ * Cada entrada guarda a distância e o caminho, como trechos retos (veja
+ * CompactPath), entre dois nós de um mapa, identificado pelo nome e pela
+ * versão (veja Graph::get_version). Quando uma consulta chega com uma versão
+ * diferente da última vista para o mapa, todas as entradas dele são
+ * descartadas.
+ *
+ * Como trechos de caminhos mínimos também são mínimos, uma consulta cujas duas
+ * pontas estejam em um caminho guardado (em qualquer sentido) é respondida
+ * com o pedaço entre elas. Para isso há um índice de cada nó dos caminhos
+ * guardados, inclusive os do meio dos trechos, para as entradas que passam
+ * por ele; a memória do índice cresce com o número de passos dos caminhos, e
+ * não só com o de trechos.
+ *
+ * Quando a memória estimada passa do limite, as entradas usadas há mais tempo
+ * são descartadas.
+ */
+class QueryCache {
+public:
+	// Resultado de uma consulta ao cache.
+	enum Result {
+		eMiss,			// Não achou.
+		eHit,			// Achou a consulta exata.
+		eSubpathHit,	// Achou um caminho que passa pelas duas pontas.
+		eNumResults
+	};
+
+	explicit QueryCache(size_t _limit);
+
+	static char const *get_result_name(Result res);
+
+	// Empacota as coordenadas de um nó.
+	static uint32_t pack(int x, int y) {
+		return (static_cast<uint32_t>(x) << 16) | static_cast<uint16_t>(y);
+	}
+	static int unpack_x(uint32_t cell)  {	return static_cast<int>(cell >> 16);	}
+	static int unpack_y(uint32_t cell)  {	return static_cast<int>(cell & 0xffff);	}
+
+	/*
+	 * Procura o caminho de src a dst no mapa dado. Em caso de acerto, preenche
+	 * a distância e, se 'path' não for 0, o caminho de src a dst.
+	 */
+	Result lookup(std::string const &map, unsigned version, uint32_t src, uint32_t dst,
+	              double &dist, CompactPath *path = 0);
+
+	/*
+	 * Guarda um caminho mínimo e sua distância. Não faz nada se o caminho
+	 * estiver vazio ou sozinho não couber no limite de memória.
+	 */
+	void insert(std::string const &map, unsigned version, CompactPath const &path,
+	            double dist);
+
+	// Descarta tudo.
+	void clear();
+
+	// Estatísticas.
+	size_t get_count(Result res) const  {	return counts[res];	}
+	size_t get_evictions() const        {	return evictions;	}
+	size_t get_invalidations() const    {	return invalidations;	}
+	size_t get_num_entries() const      {	return entries.size();	}
+	size_t get_bytes() const            {	return bytes;	}
+	size_t get_limit() const            {	return limit;	}
+
+private:
+	// Passagem de uma entrada por um nó: o número de passos da origem até ele.
+	struct CellRef {
+		size_t entry;
+		uint32_t pos;
+	};
+
+	struct Entry {
+		unsigned mapid;
+		uint32_t src, dst;
+		double dist;
+		CompactPath path;
+		std::list<size_t>::iterator age;
+	};
+
+	// Mapa conhecido: identificador usado nas chaves e última versão vista.
+	struct MapInfo {
+		unsigned id, version;
+	};
+
+	typedef std::tr1::unordered_map<size_t, Entry> EntryMap;
+	typedef std::map<std::pair<uint64_t, uint32_t>, size_t> EndpointMap;
+	typedef std::tr1::unordered_map<uint64_t, std::vector<CellRef> > CellIndex;
+
+	static uint64_t cell_key(unsigned mapid, uint32_t cell) {
+		return (static_cast<uint64_t>(mapid) << 32) | cell;
+	}
+	static size_t entry_bytes(size_t nruns, size_t nsteps);
+	static void get_cells(CompactPath const &path, std::vector<uint32_t> &cells);
+
+	unsigned check_version(std::string const &map, unsigned version);
+	void touch(Entry &entry);
+	void erase(size_t id);
+	static double subpath_distance(CompactPath const &path, uint32_t from, uint32_t to,
+	                               CompactPath *sub);
+
+	size_t limit, bytes;
+	size_t nextid;
+	// Nós de um caminho, reaproveitado entre chamadas.
+	std::vector<uint32_t> cells;
+	std::map<std::string, MapInfo> maps;
+	EntryMap entries;
+	// Chave: (mapa e origem, destino).
+	EndpointMap endpoints;
+	CellIndex index;
+	// Entradas em ordem de uso; a mais recente no começo.
+	std::list<size_t> ages;
+
+	size_t counts[eNumResults];
+	size_t evictions, invalidations;
+};
+
+#endif // _QUERYCACHE_H_
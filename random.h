@@ -0,0 +1,52 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _RANDOM_H_
+#define _RANDOM_H_
+
+#include <stdint.h>
+
+// Gerador pseudo-aleatório (xorshift64*), para que um mesmo seed gere os
+// mesmos mapas em qualquer plataforma.
+class Random {
+public:
+	explicit Random(uint64_t seed) : state(seed ? seed : 0x9E3779B97F4A7C15ull) {
+	}
+
+	uint64_t next() {
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return state * 2685821657736338717ull;
+	}
+
+	// Inteiro em [0, n).
+	unsigned below(unsigned n) {
+		return static_cast<unsigned>(next() % n);
+	}
+
+	// Real em [0, 1).
+	double uniform() {
+		return (next() >> 11) * (1.0 / 9007199254740992.0);
+	}
+
+private:
+	uint64_t state;
+};
+
+#endif // _RANDOM_H_
@@ -0,0 +1,212 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "regression.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+double MethodResult::median() const {
+	if (samples.empty()) {
+		return 0.0;
+	}
+	vector<double> sorted(samples);
+	sort(sorted.begin(), sorted.end());
+	size_t mid = sorted.size() / 2;
+	if (sorted.size() & 1) {
+		return sorted[mid];
+	}
+	return (sorted[mid - 1] + sorted[mid]) / 2.0;
+}
+
+/*
+ * Formato: uma linha por método,
+ *     <método> <expansões> <tempo> [tempo...]
+ * Linhas começando com '#' são comentários.
+ */
+bool Baseline::load(char const *fname) {
+	ifstream fin(fname, ios::in);
+	if (!fin.good()) {
+		return false;
+	}
+	results.clear();
+	string line;
+	while (getline(fin, line)) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+		istringstream sin(line);
+		MethodResult res;
+		if (!(sin >> res.name >> res.expansions)) {
+			cerr << "Linha invalida em '" << fname << "': " << line << endl;
+			return false;
+		}
+		double time;
+		while (sin >> time) {
+			res.samples.push_back(time);
+		}
+		results.push_back(res);
+	}
+	return true;
+}
+
+bool Baseline::save(char const *fname) const {
+	ofstream fout(fname, ios::out);
+	if (!fout.good()) {
+		return false;
+	}
+	fout << "# metodo expansoes tempos..." << endl;
+	fout << setprecision(9);
+	for (vector<MethodResult>::const_iterator it = results.begin();
+	     it != results.end(); ++it) {
+		fout << it->name << " " << it->expansions;
+		for (size_t ii = 0; ii < it->samples.size(); ii++) {
+			fout << " " << it->samples[ii];
+		}
+		fout << endl;
+	}
+	return fout.good();
+}
+
+void Baseline::set(MethodResult const &res) {
+	for (vector<MethodResult>::iterator it = results.begin(); it != results.end(); ++it) {
+		if (it->name == res.name) {
+			*it = res;
+			return;
+		}
+	}
+	results.push_back(res);
+}
+
+MethodResult const *Baseline::find(string const &name) const {
+	for (vector<MethodResult>::const_iterator it = results.begin();
+	     it != results.end(); ++it) {
+		if (it->name == name) {
+			return &*it;
+		}
+	}
+	return 0;
+}
+
+double mann_whitney_greater(vector<double> const &fast, vector<double> const &slow) {
+	size_t n = fast.size(), m = slow.size();
+	if (n == 0 || m == 0) {
+		return 1.0;
+	}
+
+	// U = número de pares em que o valor lento é maior (empates valem 1/2).
+	double ustat = 0;
+	for (size_t ii = 0; ii < n; ii++) {
+		for (size_t jj = 0; jj < m; jj++) {
+			if (slow[jj] > fast[ii]) {
+				ustat += 1.0;
+			} else if (slow[jj] == fast[ii]) {
+				ustat += 0.5;
+			}
+		}
+	}
+
+	size_t nm = n * m;
+	if (nm > 400) {
+		// Aproximação normal, com correção de continuidade.
+		double mean = nm / 2.0;
+		double sd = sqrt(nm * (n + m + 1) / 12.0);
+		double z = (ustat - mean - 0.5) / sd;
+		return 0.5 * erfc(z / sqrt(2.0));
+	}
+
+	/*
+	 * Distribuição exata: cnt[i][j][u] é o número de ordenações de i valores
+	 * rápidos e j lentos com estatística u. Olhando para o maior valor: se for
+	 * lento, ele ganha de todos os i rápidos; se for rápido, não conta nada.
+	 */
+	vector<vector<vector<double> > > cnt(n + 1,
+		vector<vector<double> >(m + 1, vector<double>(nm + 1, 0.0)));
+	for (size_t ii = 0; ii <= n; ii++) {
+		for (size_t jj = 0; jj <= m; jj++) {
+			if (ii == 0 || jj == 0) {
+				cnt[ii][jj][0] = 1.0;
+				continue;
+			}
+			for (size_t uu = 0; uu <= ii * jj; uu++) {
+				double ways = cnt[ii - 1][jj][uu];
+				if (uu >= ii) {
+					ways += cnt[ii][jj - 1][uu - ii];
+				}
+				cnt[ii][jj][uu] = ways;
+			}
+		}
+	}
+	double total = 0, tail = 0;
+	size_t first = static_cast<size_t>(ceil(ustat));
+	for (size_t uu = 0; uu <= nm; uu++) {
+		total += cnt[n][m][uu];
+		if (uu >= first) {
+			tail += cnt[n][m][uu];
+		}
+	}
+	return tail / total;
+}
+
+int compare_results(Baseline const &base, vector<MethodResult> const &current,
+                    double threshold, ostream &out) {
+	int failures = 0;
+	for (vector<MethodResult>::const_iterator it = current.begin();
+	     it != current.end(); ++it) {
+		MethodResult const &cur = *it;
+		out << cur.name << ": ";
+		if (cur.mismatches != 0) {
+			out << "FAIL: " << cur.mismatches << " distance mismatches; ";
+			failures++;
+		}
+
+		MethodResult const *ref = base.find(cur.name);
+		if (!ref) {
+			out << "no baseline" << endl;
+			continue;
+		}
+
+		double expratio = ref->expansions
+		                ? 1.0 * cur.expansions / ref->expansions : 1.0;
+		out << "expansions = " << cur.expansions << " (" << setprecision(4)
+		    << expratio << "x)";
+		if (expratio > 1.0 + threshold) {
+			out << " FAIL";
+			failures++;
+		}
+
+		double curmed = cur.median(), refmed = ref->median();
+		double timeratio = refmed > 0 ? curmed / refmed : 1.0;
+		double pvalue = mann_whitney_greater(ref->samples, cur.samples);
+		out << ", median time = " << setprecision(6) << curmed
+		    << " (" << setprecision(4) << timeratio << "x, p = " << pvalue << ")";
+		if (timeratio > 1.0 + threshold && pvalue < REGRESSION_ALPHA) {
+			out << " FAIL";
+			failures++;
+		}
+		out << endl;
+	}
+	return failures;
+}
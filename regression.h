@@ -0,0 +1,83 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _REGRESSION_H_
+#define _REGRESSION_H_
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Nível de significância usado para decidir se uma lentidão é real.
+#define REGRESSION_ALPHA 0.05
+
+/*
+ * Resultado de um método sobre um conjunto de cenários: total de nós
+ * extraídos do heap e tempo total de cada passada completa pelo conjunto.
+ */
+struct MethodResult {
+	MethodResult() : expansions(0), mismatches(0) {
+	}
+	explicit MethodResult(std::string const &_name)
+		: name(_name), expansions(0), mismatches(0) {
+	}
+
+	double median() const;
+
+	std::string name;
+	size_t expansions;
+	// Experimentos cuja distância não bate com a do cenário (não é gravado).
+	size_t mismatches;
+	std::vector<double> samples;
+};
+
+/*
+ * Resultados de referência, gravados em um arquivo texto com uma linha por
+ * método.
+ */
+class Baseline {
+public:
+	bool load(char const *fname);
+	bool save(char const *fname) const;
+
+	void set(MethodResult const &res);
+	MethodResult const *find(std::string const &name) const;
+
+private:
+	std::vector<MethodResult> results;
+};
+
+/*
+ * p-valor unilateral do teste de Mann-Whitney para a hipótese de que os
+ * valores em 'slow' tendem a ser maiores que os em 'fast'. Usa a distribuição
+ * exata para amostras pequenas e a aproximação normal para as demais.
+ */
+double mann_whitney_greater(std::vector<double> const &fast,
+                            std::vector<double> const &slow);
+
+/*
+ * Compara os resultados atuais com os de referência, imprimindo um relatório.
+ * Uma regressão é um aumento relativo maior que 'threshold' no número de
+ * expansões ou na mediana dos tempos, neste caso desde que também seja
+ * estatisticamente significativo. Retorna o número de regressões.
+ */
+int compare_results(Baseline const &base, std::vector<MethodResult> const &current,
+                    double threshold, std::ostream &out);
+
+#endif // _REGRESSION_H_
@@ -0,0 +1,95 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "runners.h"
+
+#include <sys/time.h>
+
+#include <iostream>
+
+using namespace std;
+
+/*
+ * Executa A* na busca vetorizada com cada núcleo de expansão suportado pelo
+ * processador, para comparar com o escalar e com o A* sobre os nós do grafo.
+ */
+void run_simd(SimdSearch &ss, Experiment const &exp, BucketStats &stats) {
+	static char const *const methods[SimdSearch::eNumKernels] = {
+		"==== SIMD A* (scalar) ===", "==== SIMD A* (sse2) ===", "==== SIMD A* (avx2) ==="
+	};
+	static char const *const tags[SimdSearch::eNumKernels] = {
+		"simd-scalar", "simd-sse2", "simd-avx2"
+	};
+	for (int ii = 0; ii < SimdSearch::eNumKernels; ii++) {
+		SimdSearch::Kernel kern = static_cast<SimdSearch::Kernel>(ii);
+		if (!SimdSearch::is_supported(kern)) {
+			continue;
+		}
+		size_t ins, upd, pop;
+		double dist = -1.0;
+		timeval start, finish;
+
+		AllocStats::begin_query();
+		gettimeofday(&start, NULL);
+		for (int cnt = 0; cnt < MAXCNT; cnt++) {
+			dist = ss.search(exp.GetStartX(), exp.GetStartY(), exp.GetGoalX(), exp.GetGoalY(),
+			                 kern, true, ins, upd, pop);
+		}
+		gettimeofday(&finish, NULL);
+
+		double time = delta_t(start, finish) / MAXCNT;
+		cout << methods[ii] << endl;
+		dump_distance_info(dist >= 0, ins, upd, pop, dist, exp.GetDistance(), time);
+		if (dist >= 0) {
+			stats.add(exp.GetBucket(), tags[ii], ins, upd, pop, time,
+			          relative_error(dist, exp.GetDistance()), 0, 1);
+		}
+	}
+}
+
+/*
+ * Executa Dijkstra e A* com estado compacto, para comparar com as versões
+ * sobre os nós do grafo.
+ */
+void run_compact(CompactSearch &cs, Experiment const &exp, BucketStats &stats) {
+	static char const *const methods[] = {"==== Compact Dijkstra ====", "==== Compact A* ==="};
+	static char const *const tags[] = {"dijks-k", "astar-k"};
+	for (int ii = 0; ii < 2; ii++) {
+		size_t ins, upd, pop;
+		double dist = -1.0;
+		timeval start, finish;
+
+		AllocStats::begin_query();
+		gettimeofday(&start, NULL);
+		for (int cnt = 0; cnt < MAXCNT; cnt++) {
+			dist = cs.search(exp.GetStartX(), exp.GetStartY(), exp.GetGoalX(), exp.GetGoalY(),
+			                 ii == 1, ins, upd, pop);
+		}
+		gettimeofday(&finish, NULL);
+
+		double time = delta_t(start, finish) / MAXCNT;
+		cout << methods[ii] << endl;
+		dump_distance_info(dist >= 0, ins, upd, pop, dist, exp.GetDistance(), time);
+		if (dist < 0) {
+			continue;
+		}
+		export_path(cs, tags[ii]);
+		stats.add(exp.GetBucket(), tags[ii], ins, upd, pop, time,
+		          relative_error(dist, exp.GetDistance()), 0, 1);
+	}
+}
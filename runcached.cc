@@ -0,0 +1,200 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "runners.h"
+#include "compactpath.h"
+#include "random.h"
+
+#include <sys/time.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+/*
+ * Confere um caminho devolvido pelo cache ou pela busca: tem que ir de src a
+ * dst por passos permitidos no grafo e ter a distância informada.
+ */
+static bool check_path(Graph &g, CompactPath const &path, Node const *src, Node const *dst,
+                       double dist) {
+	Node const *node = g.get_node(path.get_start_x(), path.get_start_y());
+	if (node != src) {
+		return false;
+	}
+	double len = 0;
+	for (size_t run = 0; run < path.get_num_runs(); run++) {
+		Direction dir = path.get_dir(run);
+		for (uint32_t step = path.get_run_length(run); step > 0; step--) {
+			Node const *next = g.get_adjacent(node, dir);
+			if (!next) {
+				return false;
+			}
+			len += Graph::distance(node, next);
+			node = next;
+		}
+	}
+	return node == dst && fabs(len - dist) < 1e-6 * max(1.0, dist);
+}
+
+/*
+ * Responde uma consulta pelo cache; em caso de falha, busca com A* e guarda o
+ * caminho encontrado. O tempo inclui a consulta ao cache. O caminho, vindo
+ * do cache ou da busca, é conferido e devolvido em 'path'.
+ */
+static bool cached_query(PathEngine &engine, QueryCache &qc, string const &mapname,
+                         Node *src, Node const *dst, double mindist, char const *kind,
+                         char const *tag, int bucket, BucketStats &stats, CompactPath &path) {
+	Graph &g = engine.get_graph();
+	size_t ins = 0, upd = 0, pop = 0;
+	double dist;
+	timeval start, finish;
+
+	gettimeofday(&start, NULL);
+	QueryCache::Result res = qc.lookup(mapname, g.get_version(),
+	                                   QueryCache::pack(src->get_x(), src->get_y()),
+	                                   QueryCache::pack(dst->get_x(), dst->get_y()), dist, &path);
+	bool found = res != QueryCache::eMiss;
+	if (!found) {
+		found = engine.find_path(src, dst, PathEngine::eAstar);
+		ins = engine.get_inserts();
+		upd = engine.get_updates();
+		pop = engine.get_pops();
+		path.clear();
+		if (found) {
+			path.build(dst);
+			dist = dst->get_distance();
+			qc.insert(mapname, g.get_version(), path, dist);
+		}
+	}
+	gettimeofday(&finish, NULL);
+
+	double time = delta_t(start, finish);
+	cout << "==== Cached A* ===" << endl
+	     << "lookup = " << QueryCache::get_result_name(res) << ", query = " << kind;
+	// Origem igual ao destino: caminho vazio, que o cache não guarda.
+	if (found && src != dst) {
+		cout << ", path = " << (check_path(g, path, src, dst, dist) ? "ok" : "wrong");
+	}
+	cout << ", ";
+	dump_distance_info(found, ins, upd, pop, dist, mindist, time);
+	if (found) {
+		stats.add(bucket, tag, ins, upd, pop, time, relative_error(dist, mindist), 0, 1);
+	}
+	return found;
+}
+
+// Consultas derivadas de cada experimento com -q, em rodízio.
+enum DerivedQuery {
+	eRepeat,		// A mesma consulta.
+	eReverse,		// Origem e destino trocados.
+	eSubpath,		// Dois nós do caminho achado.
+	eShifted,		// Cada ponta deslocada para um vizinho.
+	eNumDerived
+};
+
+static char const *const derived_names[eNumDerived] = {"repeat", "reverse", "subpath", "shifted"};
+
+// Vizinho qualquer de um nó, ou o próprio nó se ele não tiver vizinhos.
+static Node *random_neighbour(Graph &g, Node *node, Random &rnd) {
+	Node *adj[MAX_NEIGHBOURS];
+	unsigned count = g.get_adjacent_nodes(node, adj);
+	return count ? adj[rnd.below(count)] : node;
+}
+
+/*
+ * Responde a consulta do experimento pelo cache e, com -q, as consultas
+ * derivadas dela; a distância de referência das derivadas é calculada com A*
+ * (fora do tempo medido).
+ */
+void run_cached(PathEngine &engine, QueryCache &qc, string const &mapname,
+                Experiment const &exp, unsigned derived, BucketStats &stats) {
+	// Mesmas consultas derivadas em todas as execuções.
+	static Random rnd(1);
+	Graph &g = engine.get_graph();
+	Node *src = g.get_node(exp.GetStartX(), exp.GetStartY());
+	Node *dst = g.get_node(exp.GetGoalX(), exp.GetGoalY());
+	CompactPath path, other;
+	if (!cached_query(engine, qc, mapname, src, dst, exp.GetDistance(), "scenario", "cached",
+	                  exp.GetBucket(), stats, path)) {
+		return;
+	}
+	for (unsigned ii = 0; ii < derived; ii++) {
+		DerivedQuery kind = static_cast<DerivedQuery>(ii % eNumDerived);
+		Node *from = src, *to = dst;
+		switch (kind) {
+			case eRepeat:
+			case eNumDerived:
+				break;
+			case eReverse:
+				swap(from, to);
+				break;
+			case eSubpath: {
+				// Nós quaisquer do caminho, inclusive no meio dos trechos.
+				size_t steps = path.get_num_steps();
+				size_t first = rnd.below(steps + 1), last = rnd.below(steps + 1);
+				int x = path.get_start_x(), y = path.get_start_y();
+				size_t pos = 0;
+				for (size_t run = 0; run < path.get_num_runs(); run++) {
+					Direction dir = path.get_dir(run);
+					for (uint32_t step = path.get_run_length(run); step > 0; step--) {
+						if (pos == first) {
+							from = g.get_node(x, y);
+						}
+						if (pos == last) {
+							to = g.get_node(x, y);
+						}
+						x += DIR_DX[dir];
+						y += DIR_DY[dir];
+						pos++;
+					}
+				}
+				if (first == steps) {
+					from = dst;
+				}
+				if (last == steps) {
+					to = dst;
+				}
+				break;
+			}
+			case eShifted:
+				from = random_neighbour(g, src, rnd);
+				to = random_neighbour(g, dst, rnd);
+				break;
+		}
+		double mindist = engine.find_path(from, to, PathEngine::eAstar) ? to->get_distance() : -1;
+		cached_query(engine, qc, mapname, from, to, mindist, derived_names[kind], "derived",
+		             exp.GetBucket(), stats, other);
+	}
+}
+
+// Imprime os contadores do cache de consultas.
+void dump_cache_stats(QueryCache const &qc) {
+	cout << "#### cache:";
+	for (int ii = 0; ii < QueryCache::eNumResults; ii++) {
+		QueryCache::Result res = static_cast<QueryCache::Result>(ii);
+		cout << " " << QueryCache::get_result_name(res) << " = " << qc.get_count(res) << ",";
+	}
+	cout << " evictions = " << qc.get_evictions()
+	     << ", invalidations = " << qc.get_invalidations()
+	     << ", entries = " << qc.get_num_entries()
+	     << ", used = " << qc.get_bytes() / 1024 << " kB"
+	     << ", limit = " << qc.get_limit() / 1024 << " kB ####" << endl;
+}
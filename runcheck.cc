@@ -0,0 +1,190 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "runners.h"
+#include "arastar.h"
+#include "coarsegrid.h"
+#include "fringe.h"
+#include "regression.h"
+#include "search.h"
+
+#include <sys/time.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Executa o método dado uma vez, sem imprimir nada; retorna o número de nós
+// extraídos do heap. ARA* é executado até a solução ótima. 'coarse' só é
+// usado (e só precisa existir) para eCoarse.
+static size_t run_once(unsigned method, PathEngine &engine, Node *src, Node const *dst,
+                       double eps, CoarseGrid *coarse = 0) {
+	Graph &g = engine.get_graph();
+	PathEngine::Options opts;
+	size_t ins, upd, pop = 0;
+	switch (method) {
+		case eDijkstra:
+			engine.find_path(src, dst, PathEngine::eDijkstra);
+			return engine.get_pops();
+		case eAstar:
+			engine.find_path(src, dst, PathEngine::eAstar);
+			return engine.get_pops();
+		case eJPS:
+			engine.find_path(src, dst, PathEngine::eJPS);
+			return engine.get_pops();
+		case eCanonDijkstra:
+			engine.find_path(src, dst, PathEngine::eCanonDijkstra);
+			return engine.get_pops();
+		case eCanonAstar:
+			engine.find_path(src, dst, PathEngine::eCanonAstar);
+			return engine.get_pops();
+		case eWeighted:
+			opts.weight = eps;
+			engine.find_path(src, dst, PathEngine::eWeightedAstar, opts);
+			return engine.get_pops();
+		case eFringe: {
+			size_t visits, passes;
+			FringeSearch<Graph>(g).search(src, dst, ins, upd, pop, visits, passes);
+			break;
+		}
+		case eARA: {
+			ARAstar ara(g, src, dst, eps, ARA_DECREMENT);
+			while (ara.improve()) {
+			}
+			pop = ara.get_pops();
+			break;
+		}
+		case eCoarse:
+			if (coarse->reachable(src, dst)) {
+				ShortestPath(g, src, dst, CoarseAstarCmp(dst, coarse), ReopeningSuccessors(),
+				             ins, upd, pop);
+			} else {
+				// Rejeitada sem busca; o destino fica inalcançado.
+				g.init_single_source(src);
+			}
+			break;
+	}
+	return pop;
+}
+
+/*
+ * Modo de verificação: executa todos os cenários, confere as distâncias e mede
+ * o total de expansões e o tempo de várias passadas completas de cada método.
+ * Os métodos são intercalados em cada passada, para que variações no estado da
+ * máquina afetem todos igualmente. Com 'write', grava a referência; caso
+ * contrário, compara com ela. Retorna o código de saída do programa.
+ */
+int run_check(char **scens, int nscens, unsigned methods, int passes, char const *refname,
+              bool write, double threshold, double eps, Graph::Layout layout) {
+	vector<MethodResult> results;
+	vector<unsigned> masks;
+	for (unsigned ii = 0; ii < num_method_names; ii++) {
+		unsigned mask = method_names[ii].mask;
+		// Ignora os nomes que correspondem a mais de um método, e as buscas
+		// vetorizada e compacta, que não usam os nós do grafo.
+		if ((methods & mask) && (mask & (mask - 1)) == 0 && mask != eSimd
+		    && mask != eCompact) {
+			masks.push_back(mask);
+			results.push_back(MethodResult(method_names[ii].name));
+			results.back().samples.resize(passes, 0.0);
+		}
+	}
+
+	int failures = 0;
+	for (int ii = 0; ii < nscens; ii++) {
+		ScenarioLoader const scen(scens[ii]);
+		int numexps = scen.GetNumExperiments();
+		// Agrupa os experimentos consecutivos de um mesmo mapa.
+		for (int first = 0, last = 0; first < numexps; first = last) {
+			string const &mapname = scen.GetNthExperiment(first).GetMapName();
+			while (last < numexps && scen.GetNthExperiment(last).GetMapName() == mapname) {
+				last++;
+			}
+			Graph g(mapname.c_str(), layout);
+			if (!g.is_valid()) {
+				cerr << "No cenario '" << scen.GetScenarioName() << "': Grafo '"
+				     << mapname << "' invalido ou inexistente." << endl;
+				failures++;
+				continue;
+			}
+			if (!check_inside(scen, first, last, g.get_width(), g.get_height())) {
+				failures++;
+				continue;
+			}
+			PathEngine engine(g);
+			CoarseGrid coarse;
+			if (methods & eCoarse) {
+				coarse.build(g);
+			}
+
+			for (int pass = 0; pass < passes; pass++) {
+				for (size_t kk = 0; kk < masks.size(); kk++) {
+					MethodResult &res = results[kk];
+					timeval start, finish;
+					gettimeofday(&start, NULL);
+					for (int jj = first; jj < last; jj++) {
+						Experiment const &exp = scen.GetNthExperiment(jj);
+						Node *src = g.get_node(exp.GetStartX(), exp.GetStartY());
+						Node const *dst = g.get_node(exp.GetGoalX(), exp.GetGoalY());
+						size_t pop = run_once(masks[kk], engine, src, dst, eps, &coarse);
+						if (pass != 0) {
+							continue;
+						}
+						res.expansions += pop;
+						double bound = masks[kk] == eWeighted ? eps : 1.0;
+						if (!distance_matches(dst, exp.GetDistance(), bound)) {
+							res.mismatches++;
+							cerr << res.name << ": distancia errada no cenario '"
+							     << scen.GetScenarioName() << "', experimento " << jj
+							     << endl;
+						}
+					}
+					gettimeofday(&finish, NULL);
+					res.samples[pass] += delta_t(start, finish);
+				}
+			}
+		}
+	}
+
+	Baseline base;
+	if (write) {
+		for (size_t kk = 0; kk < results.size(); kk++) {
+			base.set(results[kk]);
+			cout << results[kk].name << ": expansions = " << results[kk].expansions
+			     << ", median time = " << results[kk].median() << endl;
+			if (results[kk].mismatches != 0) {
+				cout << results[kk].name << ": FAIL: " << results[kk].mismatches
+				     << " distance mismatches" << endl;
+				failures++;
+			}
+		}
+		if (!base.save(refname)) {
+			cerr << "Erro ao gravar '" << refname << "'." << endl;
+			return 1;
+		}
+	} else {
+		if (!base.load(refname)) {
+			cerr << "Referencia '" << refname << "' invalida ou inexistente." << endl;
+			return 1;
+		}
+		failures += compare_results(base, results, threshold, cout);
+	}
+	return failures ? 2 : 0;
+}
@@ -0,0 +1,67 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "runners.h"
+#include "search.h"
+
+#include <sys/time.h>
+
+#include <iostream>
+
+using namespace std;
+
+/*
+ * Calcula a grade reduzida de um mapa recém carregado e imprime seu resumo.
+ */
+void build_coarse(CoarseGrid &coarse, Graph &g) {
+	timeval start, finish;
+	gettimeofday(&start, NULL);
+	coarse.build(g);
+	gettimeofday(&finish, NULL);
+	cout << "#### coarse: block = " << CoarseGrid::BLOCK_SIDE << "x" << CoarseGrid::BLOCK_SIDE;
+	for (int ii = 0; ii < CoarseGrid::eNumStates; ii++) {
+		CoarseGrid::State st = static_cast<CoarseGrid::State>(ii);
+		cout << ", " << CoarseGrid::get_state_name(st) << " = " << coarse.count_blocks(st);
+	}
+	cout << ", regions = " << coarse.get_num_regions()
+	     << ", components = " << coarse.get_num_components()
+	     << ", memory = " << coarse.get_memory_usage() / 1024 << " kB"
+	     << ", time = " << delta_t(start, finish) << " ####" << endl;
+}
+
+/*
+ * Executa A* com a heurística da grade reduzida, rejeitando antes as consultas
+ * entre componentes distintas.
+ */
+void run_coarse(Graph &g, CoarseGrid &coarse, Experiment const &exp,
+                PerfCounters *perf, BucketStats &stats) {
+	Node *src = g.get_node(exp.GetStartX(), exp.GetStartY());
+	Node const *dst = g.get_node(exp.GetGoalX(), exp.GetGoalY());
+	char const *method = "==== Coarse A* ===";
+	if (!src || !dst) {
+		dump_outside_map(method);
+		return;
+	}
+	if (!coarse.reachable(src, dst)) {
+		cout << method << endl << "destination unreachable from source (rejected)" << endl;
+		stats.add(exp.GetBucket(), "castar", 0, 0, 0, 0, 0, 0, 1);
+		return;
+	}
+	run_method(g, src, dst, CoarseAstarCmp(dst, &coarse), ReopeningSuccessors(), exp,
+	           method, "castar", perf, stats);
+}
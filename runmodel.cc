@@ -0,0 +1,116 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "runners.h"
+#include "arastar.h"
+#include "movement.h"
+#include "search.h"
+
+#include <string>
+
+using namespace std;
+
+// Modelos de movimento e métricas selecionáveis com -M (veja select_model).
+char const *const movement_names[NUM_MOVEMENTS] = {"8", "8-any", "8-none", "4"};
+char const *const metric_names[NUM_METRICS] = {"octile", "euclidean", "manhattan", "chebyshev"};
+
+/*
+ * Executa Dijkstra, A*, A* ponderado e ARA* em um experimento com o modelo de
+ * movimento e métrica dados (veja GridModel). Cada combinação é uma instância
+ * separada, escolhida uma vez com -M.
+ */
+template <typename Move, typename Metric>
+static void run_model(Graph &g, Experiment const &exp, unsigned methods, double eps,
+                      PerfCounters *perf, BucketStats &stats) {
+	typedef GridModel<Graph, Move, Metric> Model;
+	Model model(g);
+	Node *src = g.get_node(exp.GetStartX(), exp.GetStartY());
+	Node const *dst = g.get_node(exp.GetGoalX(), exp.GetGoalY());
+
+	if (methods & eDijkstra) {
+		run_method(model, src, dst, DijkstraCmp(), DijkstraSuccessors(), exp,
+		           "==== Dijkstra ====", "dijks", perf, stats);
+	}
+
+	if (methods & eAstar) {
+		run_method(model, src, dst, BasicAstarCmp<Node, Metric>(dst), DijkstraSuccessors(), exp,
+		           "==== A* ==========", "astar", perf, stats);
+	}
+
+	if (methods & eWeighted) {
+		run_method(model, src, dst, BasicWeightedAstarCmp<Node, Metric>(dst, eps),
+		           DijkstraSuccessors(), exp, "==== Weighted ====", "wastar", perf, stats, eps);
+	}
+
+	if (methods & eARA) {
+		run_ara(model, src, dst, eps, exp, perf, stats);
+	}
+}
+
+template <typename Move>
+static ModelRunner select_metric(unsigned metric) {
+	switch (metric) {
+		case 0:
+			return run_model<Move, OctileMetric>;
+		case 1:
+			return run_model<Move, EuclideanMetric>;
+		case 2:
+			return run_model<Move, ManhattanMetric>;
+		case 3:
+			return run_model<Move, ChebyshevMetric>;
+		default:
+			return 0;
+	}
+}
+
+static ModelRunner select_model(unsigned movement, unsigned metric) {
+	switch (movement) {
+		case 0:
+			return select_metric<EightConnected<CornerCutOne> >(metric);
+		case 1:
+			return select_metric<EightConnected<CornerCutAny> >(metric);
+		case 2:
+			return select_metric<EightConnected<CornerCutNone> >(metric);
+		case 3:
+			return select_metric<FourConnected>(metric);
+		default:
+			return 0;
+	}
+}
+
+// Procura um nome em uma lista; retorna o tamanho da lista se não achar.
+static unsigned find_name(char const *const *names, unsigned count, string const &name) {
+	unsigned ii = 0;
+	while (ii < count && name != names[ii]) {
+		ii++;
+	}
+	return ii;
+}
+
+ModelRunner parse_model(string const &spec, string &name) {
+	size_t comma = spec.find(',');
+	string move = spec.substr(0, comma);
+	string metric = comma == string::npos ? metric_names[0] : spec.substr(comma + 1);
+	unsigned imove = find_name(movement_names, NUM_MOVEMENTS, move);
+	unsigned imetric = find_name(metric_names, NUM_METRICS, metric);
+	if (imove == NUM_MOVEMENTS || imetric == NUM_METRICS) {
+		return 0;
+	}
+	name = move + "," + metric;
+	return select_model(imove, imetric);
+}
@@ -0,0 +1,105 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _RUNNERS_H_
+#define _RUNNERS_H_
+
+#include "bench.h"
+#include "coarsegrid.h"
+#include "compactsearch.h"
+#include "graph.h"
+#include "pathengine.h"
+#include "querycache.h"
+#include "simdsearch.h"
+
+#include <string>
+
+/*
+ * Modos e métodos do programa principal que têm implementação própria, cada
+ * grupo em seu run*.cc; dijkstra.cc lê as opções e chama estes. Os modos
+ * recebem as opções de que precisam, e retornam o código de saída do
+ * programa.
+ */
+
+/*
+ * Modo de verificação (-c e -w): executa todos os cenários, confere as
+ * distâncias e mede o total de expansões e o tempo de várias passadas
+ * completas de cada método; com 'write', grava a referência, e caso
+ * contrário compara com ela. Veja runcheck.cc.
+ */
+int run_check(char **scens, int nscens, unsigned methods, int passes, char const *refname,
+              bool write, double threshold, double eps, Graph::Layout layout);
+
+/*
+ * Modo de replanejamento (-R): compara o reparo da solução com LPA* após
+ * 'edits' mudanças aleatórias no mapa com buscas A* do zero. Veja
+ * runreplan.cc.
+ */
+int run_replan(char **scens, int nscens, int edits, Graph::Layout layout);
+
+/*
+ * Modo fatiado (-S e -D): compara a latência de chamadas monolíticas com a
+ * das fatias de buscas intercaladas, limitadas a 'budget' expansões ou a
+ * 'usecs' microssegundos. Veja runsliced.cc.
+ */
+int run_sliced(char **scens, int nscens, unsigned methods, size_t budget, long usecs,
+               Graph::Layout layout);
+
+// A* com a heurística da grade reduzida (veja runcoarse.cc): calcula a grade
+// de um mapa recém carregado e executa um experimento.
+void build_coarse(CoarseGrid &coarse, Graph &g);
+void run_coarse(Graph &g, CoarseGrid &coarse, Experiment const &exp,
+                PerfCounters *perf, BucketStats &stats);
+
+/*
+ * Responde a consulta do experimento pelo cache de consultas e 'derived'
+ * consultas derivadas dela (-Q e -q); imprime os contadores do cache. Veja
+ * runcached.cc.
+ */
+void run_cached(PathEngine &engine, QueryCache &qc, std::string const &mapname,
+                Experiment const &exp, unsigned derived, BucketStats &stats);
+void dump_cache_stats(QueryCache const &qc);
+
+// Buscas com o estado em vetores próprios, fora dos nós do grafo (veja
+// runarrays.cc): A* vetorizado com cada núcleo, e Dijkstra e A* compactos.
+void run_simd(SimdSearch &ss, Experiment const &exp, BucketStats &stats);
+void run_compact(CompactSearch &cs, Experiment const &exp, BucketStats &stats);
+
+/*
+ * Modelos de movimento e métrica selecionáveis com -M (veja runmodel.cc).
+ * Um ModelRunner executa os métodos selecionados em um experimento com o
+ * modelo escolhido.
+ */
+typedef void (*ModelRunner)(Graph &, Experiment const &, unsigned, double, PerfCounters *,
+                            BucketStats &);
+
+enum {
+	NUM_MOVEMENTS = 4,
+	NUM_METRICS = 4
+};
+
+extern char const *const movement_names[NUM_MOVEMENTS];
+extern char const *const metric_names[NUM_METRICS];
+
+/*
+ * Converte "movimento[,metrica]" no modelo correspondente; a métrica padrão é
+ * a octil. Retorna 0 para nomes desconhecidos.
+ */
+ModelRunner parse_model(std::string const &spec, std::string &name);
+
+#endif // _RUNNERS_H_
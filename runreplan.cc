@@ -0,0 +1,159 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "runners.h"
+#include "lpastar.h"
+#include "random.h"
+#include "search.h"
+
+#include <sys/time.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Se as distâncias achadas pelo LPA* e por ShortestPath são iguais.
+static bool same_distance(LPAstar const &lpa, Node const *dst) {
+	if (!dst->already_done()) {
+		return lpa.get_distance() >= 1.0E9;
+	}
+	return fabs(lpa.get_distance() - dst->get_distance()) <= 1.0 / DISTANCE_PRECISION;
+}
+
+/*
+ * Modo de replanejamento: para cada experimento, calcula o caminho com LPA* e
+ * então aplica 'edits' mudanças aleatórias no mapa, uma de cada vez (cada uma
+ * inverte o estado de um nó na região entre origem e destino), comparando o
+ * custo de reparar a solução com o de uma busca A* do zero. As mudanças são
+ * desfeitas ao fim de cada experimento. Retorna o código de saída do programa.
+ */
+int run_replan(char **scens, int nscens, int edits, Graph::Layout layout) {
+	Random rnd(1);
+	size_t mismatches = 0, totalexps = 0;
+	size_t totlpaexp = 0, totastarexp = 0;
+	double totlpa = 0, totastar = 0;
+	for (int ii = 0; ii < nscens; ii++) {
+		ScenarioLoader const scen(scens[ii]);
+		string lastfile;
+		Graph g;
+		for (int jj = 0; jj < scen.GetNumExperiments(); jj++) {
+			Experiment const &exp = scen.GetNthExperiment(jj);
+			if (lastfile != exp.GetMapName()) {
+				lastfile = exp.GetMapName();
+				g = Graph(lastfile.c_str(), layout);
+			}
+			if (!g.is_valid()) {
+				cerr << "No cenario '" << scen.GetScenarioName()
+				     << "', experimento " << jj << ": Grafo '" << lastfile
+				     << "' invalido ou inexistente." << endl;
+				continue;
+			}
+			if (!check_inside(scen, jj, jj + 1, g.get_width(), g.get_height())) {
+				continue;
+			}
+
+			int sx = exp.GetStartX(), sy = exp.GetStartY();
+			int gx = exp.GetGoalX(), gy = exp.GetGoalY();
+			Node *src = g.get_node(sx, sy);
+			Node const *dst = g.get_node(gx, gy);
+			timeval start, finish;
+
+			gettimeofday(&start, NULL);
+			LPAstar lpa(g, src, dst);
+			lpa.compute();
+			gettimeofday(&finish, NULL);
+			double initial = delta_t(start, finish);
+
+			// Região das mudanças: o retângulo envolvendo origem e destino, com
+			// uma pequena margem.
+			int const margin = 8;
+			int x0 = max(min(sx, gx) - margin, 0);
+			int x1 = min(max(sx, gx) + margin, static_cast<int>(g.get_width()) - 1);
+			int y0 = max(min(sy, gy) - margin, 0);
+			int y1 = min(max(sy, gy) + margin, static_cast<int>(g.get_height()) - 1);
+
+			vector<pair<int, int> > changed;
+			size_t lpaexp = 0, astarexp = 0, wrong = 0;
+			double lpatime = 0, astartime = 0;
+			for (int ee = 0; ee < edits; ee++) {
+				int cx = x0 + rnd.below(x1 - x0 + 1), cy = y0 + rnd.below(y1 - y0 + 1);
+				if ((cx == sx && cy == sy) || (cx == gx && cy == gy)) {
+					continue;
+				}
+				g.set_blocked(cx, cy, !g.get_node(cx, cy)->is_blocked());
+				changed.push_back(make_pair(cx, cy));
+
+				gettimeofday(&start, NULL);
+				lpa.cell_changed(cx, cy);
+				lpa.compute();
+				gettimeofday(&finish, NULL);
+				lpatime += delta_t(start, finish);
+				lpaexp += lpa.get_expansions();
+
+				gettimeofday(&start, NULL);
+				size_t ins, upd, pop;
+				ShortestPath(g, src, dst, AstarCmp(dst), DijkstraSuccessors(), ins, upd, pop);
+				gettimeofday(&finish, NULL);
+				astartime += delta_t(start, finish);
+				astarexp += pop;
+
+				if (!same_distance(lpa, dst)) {
+					wrong++;
+				}
+			}
+			// Desfaz as mudanças, na ordem inversa.
+			for (size_t kk = changed.size(); kk > 0; kk--) {
+				pair<int, int> const &cell = changed[kk - 1];
+				g.set_blocked(cell.first, cell.second, !g.get_node(cell.first, cell.second)->is_blocked());
+			}
+
+			size_t nedits = max(changed.size(), static_cast<size_t>(1));
+			cout << "==== Replan ======" << endl
+			     << "edits = " << setw(4) << changed.size()
+			     << ", initial = " << setw(9) << initial
+			     << ", lpa = " << setw(9) << lpatime / nedits
+			     << ", lpaexp = " << setw(7) << lpaexp / nedits
+			     << ", astar = " << setw(9) << astartime / nedits
+			     << ", astarexp = " << setw(7) << astarexp / nedits
+			     << ", speedup = " << setw(6) << (lpatime > 0 ? astartime / lpatime : 0)
+			     << ", mismatches = " << wrong << endl;
+			mismatches += wrong;
+			totalexps += changed.size();
+			totlpa += lpatime;
+			totastar += astartime;
+			totlpaexp += lpaexp;
+			totastarexp += astarexp;
+		}
+	}
+
+	size_t nedits = max(totalexps, static_cast<size_t>(1));
+	cout << "#### replan: edits = " << totalexps
+	     << ", lpa = " << totlpa / nedits
+	     << ", lpaexp = " << totlpaexp / nedits
+	     << ", astar = " << totastar / nedits
+	     << ", astarexp = " << totastarexp / nedits
+	     << ", speedup = " << (totlpa > 0 ? totastar / totlpa : 0)
+	     << ", mismatches = " << mismatches << " ####" << endl;
+	return mismatches ? 2 : 0;
+}
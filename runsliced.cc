@@ -0,0 +1,213 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "runners.h"
+#include "overlay.h"
+#include "search.h"
+
+#include <sys/time.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Número de buscas intercaladas no modo fatiado; todas usam o mesmo mapa,
+// cada uma com seus próprios nós (veja SearchOverlay).
+#define SLICE_TASKS 4
+
+typedef SearchOverlay<Graph> SliceGraph;
+
+// Latências de um método no modo fatiado.
+struct SliceStats {
+	SliceStats() : queries(0), mismatches(0) {
+	}
+	std::vector<double> mono, slices;
+	size_t queries, mismatches;
+};
+
+// Percentil (entre 0 e 1) de um conjunto de amostras; altera a ordem delas.
+static double percentile(vector<double> &samples, double pct) {
+	if (samples.empty()) {
+		return 0;
+	}
+	sort(samples.begin(), samples.end());
+	size_t idx = static_cast<size_t>(pct * (samples.size() - 1) + 0.5);
+	return samples[idx];
+}
+
+static DijkstraCmp make_dijkstra_cmp(Node const *UNUSED(dst)) {
+	return DijkstraCmp();
+}
+
+static AstarCmp make_astar_cmp(Node const *dst) {
+	return AstarCmp(dst);
+}
+
+/*
+ * Executa os experimentos [first, last) de um mapa com um método, primeiro
+ * com chamadas monolíticas a ShortestPath e depois com SLICE_TASKS buscas
+ * intercaladas em rodízio, cada fatia limitada a 'budget' expansões ou, se
+ * 'usecs' não for zero, a 'usecs' microssegundos. Cada busca, monolítica ou
+ * não, usa sua própria SearchOverlay sobre o mapa; a construção de uma tarefa
+ * (que só cria seus nós inicial e final) conta como parte de sua primeira
+ * fatia.
+ */
+template <typename Compare, typename Successors>
+static void run_sliced_map(Graph &g, ScenarioLoader const &scen, int first, int last,
+                           Compare (*make_cmp)(Node const *), Successors succ,
+                           size_t budget, long usecs, SliceStats &stats) {
+	typedef SearchTask<Compare, Successors, SliceGraph> Task;
+	timeval start, finish;
+
+	for (int jj = first; jj < last; jj++) {
+		Experiment const &exp = scen.GetNthExperiment(jj);
+		size_t ins, upd, pop;
+		gettimeofday(&start, NULL);
+		SliceGraph view(g);
+		Node *src = view.get_node(exp.GetStartX(), exp.GetStartY());
+		Node const *dst = view.get_node(exp.GetGoalX(), exp.GetGoalY());
+		ShortestPath(view, src, dst, make_cmp(dst), succ, ins, upd, pop);
+		gettimeofday(&finish, NULL);
+		stats.mono.push_back(delta_t(start, finish));
+	}
+
+	vector<SliceGraph *> views(SLICE_TASKS, static_cast<SliceGraph *>(0));
+	vector<Task *> tasks(SLICE_TASKS, static_cast<Task *>(0));
+	vector<int> which(SLICE_TASKS, 0);
+	int next = first, active = 0;
+	while (next < last || active > 0) {
+		for (unsigned slot = 0; slot < SLICE_TASKS; slot++) {
+			gettimeofday(&start, NULL);
+			if (!tasks[slot]) {
+				if (next >= last) {
+					continue;
+				}
+				Experiment const &exp = scen.GetNthExperiment(next);
+				views[slot] = new SliceGraph(g);
+				Node *src = views[slot]->get_node(exp.GetStartX(), exp.GetStartY());
+				Node const *dst = views[slot]->get_node(exp.GetGoalX(), exp.GetGoalY());
+				tasks[slot] = new Task(*views[slot], src, dst, make_cmp(dst), succ);
+				which[slot] = next++;
+				active++;
+			}
+
+			SearchStatus status;
+			if (usecs) {
+				timeval limit = start;
+				limit.tv_usec += usecs;
+				limit.tv_sec += limit.tv_usec / 1000000;
+				limit.tv_usec %= 1000000;
+				status = tasks[slot]->step(limit);
+			} else {
+				status = tasks[slot]->step(budget);
+			}
+			gettimeofday(&finish, NULL);
+			stats.slices.push_back(delta_t(start, finish));
+
+			if (status != eSearchRunning) {
+				Experiment const &exp = scen.GetNthExperiment(which[slot]);
+				Node const *dst = views[slot]->get_node(exp.GetGoalX(), exp.GetGoalY());
+				if (!distance_matches(dst, exp.GetDistance())) {
+					stats.mismatches++;
+				}
+				stats.queries++;
+				delete tasks[slot];
+				delete views[slot];
+				tasks[slot] = 0;
+				views[slot] = 0;
+				active--;
+			}
+		}
+	}
+}
+
+/*
+ * Modo fatiado: compara a latência de chamadas monolíticas com a das fatias
+ * de buscas intercaladas, para cada método selecionado. Retorna o código de
+ * saída do programa.
+ */
+int run_sliced(char **scens, int nscens, unsigned methods, size_t budget, long usecs,
+               Graph::Layout layout) {
+	SliceStats dijks, astar, jumps;
+	for (int ii = 0; ii < nscens; ii++) {
+		ScenarioLoader const scen(scens[ii]);
+		int numexps = scen.GetNumExperiments();
+		// Agrupa os experimentos consecutivos de um mesmo mapa.
+		for (int first = 0, last = 0; first < numexps; first = last) {
+			string const &mapname = scen.GetNthExperiment(first).GetMapName();
+			while (last < numexps && scen.GetNthExperiment(last).GetMapName() == mapname) {
+				last++;
+			}
+			Graph g(mapname.c_str(), layout);
+			if (!g.is_valid()) {
+				cerr << "No cenario '" << scen.GetScenarioName() << "': Grafo '"
+				     << mapname << "' invalido ou inexistente." << endl;
+				continue;
+			}
+			if (!check_inside(scen, first, last, g.get_width(), g.get_height())) {
+				continue;
+			}
+			if (methods & eDijkstra) {
+				run_sliced_map(g, scen, first, last, make_dijkstra_cmp,
+				               DijkstraSuccessors(), budget, usecs, dijks);
+			}
+			if (methods & eAstar) {
+				run_sliced_map(g, scen, first, last, make_astar_cmp,
+				               DijkstraSuccessors(), budget, usecs, astar);
+			}
+			if (methods & eJPS) {
+				run_sliced_map(g, scen, first, last, make_astar_cmp,
+				               BasicJPSSuccessors<SliceGraph>(), budget, usecs, jumps);
+			}
+		}
+	}
+
+	cout << "#### slices: tasks = " << SLICE_TASKS;
+	if (usecs) {
+		cout << ", deadline = " << usecs << " us";
+	} else {
+		cout << ", budget = " << budget << " expansions";
+	}
+	cout << " ####" << endl;
+
+	size_t mismatches = 0;
+	SliceStats *all[] = {&dijks, &astar, &jumps};
+	char const *tags[] = {"dijks", "astar", "jumps"};
+	for (unsigned ii = 0; ii < sizeof(all) / sizeof(all[0]); ii++) {
+		SliceStats &st = *all[ii];
+		if (st.queries == 0) {
+			continue;
+		}
+		cout << "method = " << tags[ii]
+		     << ", queries = " << setw(5) << st.queries
+		     << ", slices = " << setw(7) << st.slices.size()
+		     << ", mono p50 = " << setw(9) << percentile(st.mono, 0.5)
+		     << ", p99 = " << setw(9) << percentile(st.mono, 0.99)
+		     << ", max = " << setw(9) << percentile(st.mono, 1.0)
+		     << ", slice p50 = " << setw(9) << percentile(st.slices, 0.5)
+		     << ", p99 = " << setw(9) << percentile(st.slices, 0.99)
+		     << ", max = " << setw(9) << percentile(st.slices, 1.0)
+		     << ", mismatches = " << st.mismatches << endl;
+		mismatches += st.mismatches;
+	}
+	return mismatches ? 2 : 0;
+}
@@ -0,0 +1,58 @@
+#!/bin/bash
+#
+# Gera mapas sintéticos de tamanhos crescentes e mede, para cada método e
+# layout de memória dos nós, o tempo médio por consulta, o número médio de nós
+# extraídos do heap, as falhas de cache médias (se o programa foi compilado com
+# 'make perf'; "-" caso contrário) e o pico de memória residente do processo.
+#
+# Uso: scaling-suite.sh [diretório] [lado...]
+
+OUTDIR="${1:-scaling}"
+shift
+SIZES="${*:-64 128 256 512 1024 2048}"
+TYPES="${TYPES:-random maze rooms pillars}"
+METHODS="${METHODS:-dijkstra astar jps}"
+LAYOUTS="${LAYOUTS:-rowmajor}"
+# Experimentos por mapa.
+COUNT="${COUNT:-50}"
+
+if [[ ! -x ./mapgen || ! -x ./dijkstra ]]; then
+	echo "Run 'make' first!"
+	exit 1
+fi
+
+mkdir -p "$OUTDIR"
+DATA="$OUTDIR/scaling.data"
+echo "# type size cells layout method queries avgtime avgextract avgl1dmiss avgllcmiss maxrss_kb" > "$DATA"
+
+for type in $TYPES; do
+	for size in $SIZES; do
+		base="$OUTDIR/$type-$size"
+		./mapgen -n "$COUNT" "$type" "$size" "$base" || exit 1
+		for layout in $LAYOUTS; do
+		for method in $METHODS; do
+			log="$base.$layout.$method.log"
+			./dijkstra -l "$layout" -a "$method" "$base.map.scen" > "$log" || exit 1
+			# Linhas de estatísticas seguem o cabeçalho "==== <método> ====".
+			grep -A 1 '^====' "$log" | grep 'time =' \
+				| awk -F '[ =,]+' -v type="$type" -v size="$size" -v method="$method" \
+				      -v layout="$layout" \
+				      -v rss="$(sed -n 's/^#### maxrss = \([0-9]*\) kB ####$/\1/p' "$log")" '
+					{
+						for (ii = 1; ii < NF; ii++) {
+							if ($ii == "extract") { ext += $(ii + 1) }
+							if ($ii == "time") { time += $(ii + 1) }
+							if ($ii == "l1dmiss") { l1d += $(ii + 1); hasperf = 1 }
+							if ($ii == "llcmiss") { llc += $(ii + 1) }
+						}
+						n++
+					}
+					END {
+						if (n == 0) { n = 1 }
+						print type, size, size * size, layout, method, n, time / n, ext / n,
+						      (hasperf ? l1d / n : "-"), (hasperf ? llc / n : "-"), rss
+					}' | tee -a "$DATA"
+		done
+		done
+	done
+done
@@ -0,0 +1,753 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _SEARCH_H_
+#define _SEARCH_H_
+
+#include "coarsegrid.h"
+#include "deadends.h"
+#include "graph.h"
+#include "goalbounds.h"
+#include "heap.h"
+#include "memstats.h"
+#include "profiler.h"
+
+#include <sys/time.h>
+
+#include <vector>
+
+#if defined(__GNUC__) 
+# define UNUSED(x) UNUSED_ ## x __attribute__((unused))
+#else
+# define UNUSED(x) x 
+#endif
+
+/*
+ * Os functors e ShortestPath são genéricos no tipo do grafo, que tem que
+ * definir node_type e oferecer a mesma interface de Graph (get_node,
+ * get_adjacent, get_adjacent_list, get_adjacent_nodes, distance e
+ * init_single_source); veja
+ * TiledGraph e GridModel.
+ */
+
+// Functor de comparação para algoritmo de Dijkstra.
+struct DijkstraCmp {
+	template <typename N>
+	bool operator()(N const *lhs, N const *rhs) {
+		return lhs->get_distance() < rhs->get_distance();
+	}
+};
+
+// Functor de comparação para A* e derivados (inclusive JPS). A heurística é a
+// distância na métrica dada (veja movement.h).
+template <typename N, typename Metric = DefaultMetric>
+struct BasicAstarCmp {
+	BasicAstarCmp(N const *dest) : target(dest) {		}
+
+	bool operator()(N const *lhs, N const *rhs) {
+		double dlhs = metric_distance<Metric>(lhs, target);
+		double drhs = metric_distance<Metric>(rhs, target);
+#if 0
+		return lhs->get_distance() + dlhs < rhs->get_distance() + drhs;
+#else
+		double dl = lhs->get_distance() + dlhs, dr = rhs->get_distance() + drhs;
+		// Se os nós não empataram, retorne o resultado da comparação.
+		if (dl != dr)
+			return dl < dr;
+		// Caso contrário, vamos desempatar para tornar a busca mais eficiente.
+		// O critério de desempate é o nó com menor custo heurístico.
+		return dlhs < drhs;
+#endif
+	}
+private:
+	N const *target;
+};
+
+typedef BasicAstarCmp<Node> AstarCmp;
+
+/*
+ * Functor de comparação para A* ponderado: f = g + eps * h. Com eps > 1 a
+ * busca expande menos nós, e o caminho encontrado custa no máximo eps vezes o
+ * ótimo (mesmo sem reabrir nós já expandidos). A heurística é a distância na
+ * métrica dada, como em BasicAstarCmp.
+ */
+template <typename N, typename Metric = DefaultMetric>
+struct BasicWeightedAstarCmp {
+	BasicWeightedAstarCmp(N const *dest, double _eps) : target(dest), eps(_eps) {		}
+
+	bool operator()(N const *lhs, N const *rhs) {
+		double dlhs = metric_distance<Metric>(lhs, target);
+		double drhs = metric_distance<Metric>(rhs, target);
+		double dl = lhs->get_distance() + eps * dlhs, dr = rhs->get_distance() + eps * drhs;
+		if (dl != dr)
+			return dl < dr;
+		// Mesmo desempate de AstarCmp.
+		return dlhs < drhs;
+	}
+private:
+	N const *target;
+	double eps;
+};
+
+typedef BasicWeightedAstarCmp<Node> WeightedAstarCmp;
+
+/*
+ * Functor de comparação para A* com a heurística da grade reduzida (veja
+ * CoarseGrid): o maior entre a distância octil e o limite dos marcos entre as
+ * regiões do nó e do destino. A heurística é admissível mas não é
+ * consistente, e tem que ser usada com ReopeningSuccessors.
+ */
+template <typename N>
+struct BasicCoarseAstarCmp {
+	BasicCoarseAstarCmp(N const *dest, CoarseGrid const *_grid)
+		: target(dest), grid(_grid),
+		  region(_grid->region_of(dest->get_x(), dest->get_y())) {		}
+
+	bool operator()(N const *lhs, N const *rhs) {
+		double dlhs = heuristic(lhs), drhs = heuristic(rhs);
+		double dl = lhs->get_distance() + dlhs, dr = rhs->get_distance() + drhs;
+		if (dl != dr)
+			return dl < dr;
+		// Mesmo desempate de AstarCmp.
+		return dlhs < drhs;
+	}
+private:
+	double heuristic(N const *node) const {
+		double bound = grid->lower_bound(grid->region_of(node->get_x(), node->get_y()), region);
+		return std::max(node->distance_to(target), bound);
+	}
+
+	N const *target;
+	CoarseGrid const *grid;
+	uint32_t region;
+};
+
+typedef BasicCoarseAstarCmp<Node> CoarseAstarCmp;
+
+// Functor para obter índice dos vértices.
+struct GetIndex {
+	template <typename N>
+	size_t operator() (N const *node) {
+		return node->get_heapindex();
+	}
+};
+
+// Functor para modificar índice dos vértices.
+struct SetIndex {
+	template <typename N>
+	void operator() (N *node, size_t index) {
+		node->set_heapindex(index);
+	}
+};
+
+/*
+ * Functor que insere os vizinhos no heap para Dijkstra e A*. Com regiões sem
+ * saída (veja DeadEnds, já preparado com set_query para a consulta), os nós
+ * que não podem estar no caminho não são gerados; com caixas de destinos
+ * (veja GoalBounds), os passos que não começam um caminho mínimo até o destino
+ * também não.
+ */
+struct DijkstraSuccessors {
+	DijkstraSuccessors(DeadEnds const *_pruning = 0, GoalBounds const *_bounds = 0)
+		: pruning(_pruning), bounds(_bounds) {
+	}
+
+	template <typename G, typename H>
+	void operator()(typename G::node_type *node, typename G::node_type *UNUSED(src),
+	                typename G::node_type const *dst, G &g, H &heap,
+	                size_t &ins, size_t &upd) {
+		typedef typename G::node_type N;
+		// Todos nós adjacentes não-bloqueados são sucessores.
+		N *adj[MAX_NEIGHBOURS];
+		unsigned count = g.get_adjacent_nodes(node, adj);
+		for (unsigned ii = 0; ii < count; ii++) {
+			N *next = adj[ii];
+			if (next->already_done()
+			    || (pruning && pruning->is_pruned(next->get_x(), next->get_y()))) {
+				continue;
+			}
+			if (bounds) {
+				Direction dir = step_direction(next->get_x() - node->get_x(),
+				                               next->get_y() - node->get_y());
+				if (bounds->is_pruned(node->get_x(), node->get_y(), dir,
+				                      dst->get_x(), dst->get_y())) {
+					continue;
+				}
+			}
+			// "Relax" no Cormen.
+			double dst = node->get_distance() + G::distance(node, next);
+			if (next->get_distance() > dst) {
+				next->set_distance(dst);
+				next->set_parent(node);
+				if (next->still_unseen()) {
+					// Nó não foi visto ainda, então não está no heap.
+					next->mark_seen();
+					heap.insert(next);
+					ins++;
+				} else {
+					heap.update_elem(next);
+					upd++;
+				}
+			}
+		}
+	}
+private:
+	DeadEnds const *pruning;
+	GoalBounds const *bounds;
+};
+
+/*
+ * Functor que insere os vizinhos no heap para A* com heurísticas inconsistentes:
+ * como em DijkstraSuccessors (sem podas), mas um nó já expandido volta para o
+ * heap se for achado um caminho melhor até ele.
+ */
+struct ReopeningSuccessors {
+	template <typename G, typename H>
+	void operator()(typename G::node_type *node, typename G::node_type *UNUSED(src),
+	                typename G::node_type const *UNUSED(dst), G &g, H &heap,
+	                size_t &ins, size_t &upd) {
+		typedef typename G::node_type N;
+		N *adj[MAX_NEIGHBOURS];
+		unsigned count = g.get_adjacent_nodes(node, adj);
+		for (unsigned ii = 0; ii < count; ii++) {
+			N *next = adj[ii];
+			double dst = node->get_distance() + G::distance(node, next);
+			if (next->get_distance() > dst) {
+				next->set_distance(dst);
+				next->set_parent(node);
+				if (next->already_seen()) {
+					heap.update_elem(next);
+					upd++;
+				} else {
+					// Nó nunca visto ou reaberto: não está no heap.
+					next->mark_seen();
+					heap.insert(next);
+					ins++;
+				}
+			}
+		}
+	}
+};
+
+/*
+ * Functor que insere os vizinhos no heap para Jump Point Search. As regiões
+ * sem saída são tratadas como em DijkstraSuccessors: os saltos param ao
+ * entrar nelas. Os vizinhos forçados continuam sendo calculados com os
+ * obstáculos reais, e por isso a poda não muda os jump points fora delas.
+ * Com caixas de destinos, só se salta nas direções cuja caixa contém o
+ * destino; os saltos em si não são podados.
+ */
+template <typename G>
+struct BasicJPSSuccessors {
+	typedef typename G::node_type Node;
+
+	BasicJPSSuccessors(DeadEnds const *_pruning = 0, GoalBounds const *_bounds = 0)
+		: pruning(_pruning), bounds(_bounds) {
+	}
+
+	template <typename H>
+	void operator()(Node *node, Node *src, Node const *dst, G &g, H &heap,
+	                size_t &ins, size_t &upd) {
+		NeighbourList adj;
+		get_successor_dirs(node, src, g, adj);
+
+		// Para cada nó adjacente...
+		for (Neighbour const *it = adj.begin(); it != adj.end(); ++it) {
+			// O vizinho imediato já ter sido expandido não diz nada sobre os nós
+			// mais adiante nesta direção, de modo que sempre procuramos o jump
+			// point.
+			Direction dir = it->dir;
+			if (bounds && bounds->is_pruned(node->get_x(), node->get_y(), dir,
+			                                dst->get_x(), dst->get_y())) {
+				continue;
+			}
+			Node *next;
+			// ... ache o jump point nesta direção, se houver.
+			{
+				PROFILE_SCOPE(ePhaseJump);
+				next = jump(node, src, dst, dir, g);
+			}
+			if (!next) {
+				continue;
+			}
+			// Como houve, vamos realizar uma relaxação.
+			double dst = node->get_distance() + node->distance_to(next);
+			if (next->get_distance() > dst) {
+				next->set_dir_from(dir);
+				next->set_distance(dst);
+				next->set_parent(node);
+				// Faz diferença?
+				//if (next->still_unseen()) {
+				if (!next->already_seen()) {
+					// Nó não foi visto ainda, então não está no heap.
+					next->mark_seen();
+					heap.insert(next);
+					ins++;
+				} else {
+					heap.update_elem(next);
+					upd++;
+				}
+			}
+		}
+	}
+protected:
+	// Vizinho de um nó, junto com a direção em que ele está.
+	struct Neighbour {
+		Node *node;
+		Direction dir;
+	};
+
+	/*
+	 * Lista de vizinhos de tamanho fixo: um nó tem no máximo MAX_NEIGHBOURS,
+	 * e assim as listas ficam na pilha, sem alocar memória a cada expansão.
+	 */
+	struct NeighbourList {
+		NeighbourList() : count(0) {
+		}
+		void push_back(Neighbour const &nb) {
+			items[count++] = nb;
+		}
+		bool empty() const                  {	return count == 0;	}
+		Neighbour const *begin() const      {	return items;	}
+		Neighbour const *end() const        {	return items + count;	}
+
+		Neighbour items[MAX_NEIGHBOURS];
+		unsigned count;
+	};
+
+	// Vizinhos nas direções que precisam ser seguidas a partir do nó.
+	void get_successor_dirs(Node *node, Node *src, G &g, NeighbourList &adj) {
+		if (node == src) {
+			// Para o nó de origem, todas direções tem que ser verificadas.
+			// Como precisamos de saber a direção também, de modo que não dá
+			// para usar Graph::get_adjacent_list.
+			static Direction const dirs[] = {eNorth, eSouth, eEast, eWest,
+			                                 eNorthEast, eSouthEast,
+			                                 eSouthWest, eNorthWest};
+			for (unsigned ii = 0; ii < sizeof(dirs) / sizeof(dirs[0]); ii++) {
+				add_neighbour(g, node, dirs[ii], adj);
+			}
+		} else {
+			// Caso contrário, apenas alguns vizinhos são importantes.
+			get_neighbours(node, g, adj);
+		}
+	}
+
+	/*
+	 * Tenta achar um jump point na direção dada, usando as regras especificadas
+	 * no artigo original.
+	 */
+	Node *jump(Node *node, Node *src, Node const *dst, Direction dir, G &g) {
+		PROFILE_COUNT(eCountJumpCalls, 1);
+		Node *next = node;
+		do {
+			PROFILE_COUNT(eCountJumpSteps, 1);
+			next = g.get_adjacent(next, dir);
+			if (!next) {
+				// Se o nó for bloqueado, estiver fora do mapa, não há um jump point.
+				return 0;
+			} else if (next == dst) {
+				// O nó de destino é sempre um jump point.
+				return next;
+			} else if (pruning && pruning->is_pruned(next->get_x(), next->get_y())) {
+				// Só se sai de uma região sem saída por onde se entrou.
+				return 0;
+			}
+			
+			// O nó tem vizinhos forçados na sua vizinhança?
+			NeighbourList adj;
+			{
+				PROFILE_SCOPE(ePhaseForced);
+				forced_neighbours(g, next, dir, adj);
+			}
+			if (!adj.empty()) {
+				// Se sim, temos um jump point.
+				return next;
+			}
+
+			// Recursão nas diagonais: busque por jump points nas direções
+			// ortoginais componentes da diagonal.
+			switch (dir) {
+				case eNorthEast:
+					if (jump(next, src, dst, eNorth, g) != 0) {
+						return next;
+					}
+					if (jump(next, src, dst, eEast, g) != 0) {
+						return next;
+					}
+					break;
+				case eSouthEast:
+					if (jump(next, src, dst, eSouth, g) != 0) {
+						return next;
+					}
+					if (jump(next, src, dst, eEast, g) != 0) {
+						return next;
+					}
+					break;
+				case eSouthWest:
+					if (jump(next, src, dst, eSouth, g) != 0) {
+						return next;
+					}
+					if (jump(next, src, dst, eWest, g) != 0) {
+						return next;
+					}
+					break;
+				case eNorthWest:
+					if (jump(next, src, dst, eNorth, g) != 0) {
+						return next;
+					}
+					if (jump(next, src, dst, eWest, g) != 0) {
+						return next;
+					}
+					break;
+				default:
+					break;
+			}
+		} while (1);
+	}
+
+	// Adiciona o vizinho na direção dada se ele não estiver bloqueado, se ele
+	// estiver dentro do mapa *e* se ele for alcançável à partir do "pai".
+	void add_neighbour(G &g, Node *node, Direction dir, NeighbourList &adj) {
+		Node *next = g.get_adjacent(node, dir);
+		if (next) {
+			// A direção fica junto do vizinho, e não nele: se ele estiver no
+			// heap, sua direção de chegada ainda é necessária.
+			Neighbour nb = {next, dir};
+			adj.push_back(nb);
+		}
+	}
+
+	// Adiciona todos vizinhos naturais de um nó alcançado à partir de uma dada
+	// direção.
+	void natural_neighbours(G &g, Node *node, Direction dir, NeighbourList &adj) {
+		// Vizinhos especiais para diagonais.
+		switch (dir) {
+			case eNorthEast:
+				// Naturais:
+				add_neighbour(g, node, eNorth, adj);
+				add_neighbour(g, node, eEast, adj);
+				break;
+			case eSouthEast:
+				// Naturais:
+				add_neighbour(g, node, eSouth, adj);
+				add_neighbour(g, node, eEast, adj);
+				break;
+			case eSouthWest:
+				// Naturais:
+				add_neighbour(g, node, eSouth, adj);
+				add_neighbour(g, node, eWest, adj);
+				break;
+			case eNorthWest:
+				// Naturais:
+				add_neighbour(g, node, eNorth, adj);
+				add_neighbour(g, node, eWest, adj);
+				break;
+			default:
+				break;
+		}
+		// Vizinho natural comum a todos casos. Adicionado por último para que
+		// as diagonais venham depois das direções ortogonais.
+		add_neighbour(g, node, dir, adj);
+	}
+
+	// Adiciona todos vizinhos forçados de um nó alcançado à partir de uma dada
+	// direção.
+	void forced_neighbours(G &g, Node *node, Direction dir, NeighbourList &adj) {
+		switch (dir) {
+			case eEast:
+				if (!g.get_adjacent(node, eNorth)) {
+					add_neighbour(g, node, eNorthEast, adj);
+				}
+				if (!g.get_adjacent(node, eSouth)) {
+					add_neighbour(g, node, eSouthEast, adj);
+				}
+				break;
+			case eWest:
+				if (!g.get_adjacent(node, eNorth)) {
+					add_neighbour(g, node, eNorthWest, adj);
+				}
+				if (!g.get_adjacent(node, eSouth)) {
+					add_neighbour(g, node, eSouthWest, adj);
+				}
+				break;
+			case eNorth:
+				if (!g.get_adjacent(node, eEast)) {
+					add_neighbour(g, node, eNorthEast, adj);
+				}
+				if (!g.get_adjacent(node, eWest)) {
+					add_neighbour(g, node, eNorthWest, adj);
+				}
+				break;
+			case eSouth:
+				if (!g.get_adjacent(node, eEast)) {
+					add_neighbour(g, node, eSouthEast, adj);
+				}
+				if (!g.get_adjacent(node, eWest)) {
+					add_neighbour(g, node, eSouthWest, adj);
+				}
+				break;
+			case eNorthEast:
+				if (!g.get_adjacent(node, eWest)) {
+					add_neighbour(g, node, eNorthWest, adj);
+				}
+				if (!g.get_adjacent(node, eSouth)) {
+					add_neighbour(g, node, eSouthEast, adj);
+				}
+				break;
+			case eSouthEast:
+				if (!g.get_adjacent(node, eWest)) {
+					add_neighbour(g, node, eSouthWest, adj);
+				}
+				if (!g.get_adjacent(node, eNorth)) {
+					add_neighbour(g, node, eNorthEast, adj);
+				}
+				break;
+			case eSouthWest:
+				if (!g.get_adjacent(node, eEast)) {
+					add_neighbour(g, node, eSouthEast, adj);
+				}
+				if (!g.get_adjacent(node, eNorth)) {
+					add_neighbour(g, node, eNorthWest, adj);
+				}
+				break;
+			case eNorthWest:
+				if (!g.get_adjacent(node, eEast)) {
+					add_neighbour(g, node, eNorthEast, adj);
+				}
+				if (!g.get_adjacent(node, eSouth)) {
+					add_neighbour(g, node, eSouthWest, adj);
+				}
+				break;
+			default:
+				break;
+		}
+	}
+
+	// Obtém uma lista com todos vizinhos naturais e forçados de um nó.
+	void get_neighbours(Node *node, G &g, NeighbourList &adj) {
+		Direction dir = node->get_dir_from();
+		natural_neighbours(g, node, dir, adj);
+		{
+			PROFILE_SCOPE(ePhaseForced);
+			forced_neighbours(g, node, dir, adj);
+		}
+	}
+
+	DeadEnds const *pruning;
+	GoalBounds const *bounds;
+};
+
+typedef BasicJPSSuccessors<Graph> JPSSuccessors;
+
+/*
+ * Functor que insere os vizinhos no heap para Dijkstra e A* com ordem canônica
+ * (Sturtevant e Rabin, 2016): entre caminhos de mesmo custo, só se segue o que
+ * faz os passos diagonais antes dos ortogonais. Os sucessores de um nó são os
+ * vizinhos naturais e forçados da direção em que ele foi alcançado, como em
+ * JPS, mas sem saltos: cada sucessor é um vizinho imediato. Os caminhos
+ * simétricos de mesmo custo deixam de ser gerados, e a busca continua ótima.
+ */
+template <typename G>
+struct BasicCanonicalSuccessors : private BasicJPSSuccessors<G> {
+	typedef typename G::node_type Node;
+	typedef typename BasicJPSSuccessors<G>::Neighbour Neighbour;
+	typedef typename BasicJPSSuccessors<G>::NeighbourList NeighbourList;
+
+	template <typename H>
+	void operator()(Node *node, Node *src, Node const *UNUSED(dst), G &g, H &heap,
+	                size_t &ins, size_t &upd) {
+		NeighbourList adj;
+		this->get_successor_dirs(node, src, g, adj);
+		for (Neighbour const *it = adj.begin(); it != adj.end(); ++it) {
+			Node *next = it->node;
+			if (next->already_done()) {
+				continue;
+			}
+			double dst = node->get_distance() + G::distance(node, next);
+			if (next->get_distance() > dst) {
+				// A direção de chegada define os sucessores do nó.
+				next->set_dir_from(it->dir);
+				next->set_distance(dst);
+				next->set_parent(node);
+				if (next->still_unseen()) {
+					next->mark_seen();
+					heap.insert(next);
+					ins++;
+				} else {
+					heap.update_elem(next);
+					upd++;
+				}
+			}
+		}
+	}
+};
+
+typedef BasicCanonicalSuccessors<Graph> CanonicalSuccessors;
+
+// Estado de uma busca fatiada (veja SearchTask).
+enum SearchStatus {
+	eSearchRunning,		// A busca ainda não terminou.
+	eSearchFound,		// O destino foi alcançado.
+	eSearchUnreachable	// O heap esvaziou sem alcançar o destino.
+};
+
+/*
+ * Uma iteração do laço principal das buscas: extrai o melhor nó do heap e, se
+ * não for o destino, insere os sucessores dele. Retorna o estado da busca
+ * depois da iteração, e o nó extraído (0 se o heap estava vazio) em 'u'. É o
+ * laço de SearchTask e de BasicPathEngine, que reusa seus heaps.
+ */
+template <typename G, typename H, typename Successors>
+SearchStatus expand_next(G &g, H &heap, typename G::node_type *src,
+                         typename G::node_type const *dst, Successors &succ,
+                         size_t &ins, size_t &upd, size_t &pop,
+                         typename G::node_type *&u) {
+	if (heap.empty()) {
+		u = 0;
+		return eSearchUnreachable;
+	}
+	u = heap.extract();
+	pop++;
+	u->mark_done();
+
+	// Se chegamos ao destino, podemos parar.
+	if (u == dst) {
+		return eSearchFound;
+	}
+
+	// Adiciona todos sucessores do nó atual ao heap.
+	PROFILE_SCOPE(ePhaseSuccessors);
+	succ(u, src, dst, g, heap, ins, upd);
+	return eSearchRunning;
+}
+
+/*
+ * Busca que pode ser executada em fatias: cada chamada a step avança o laço
+ * principal até esgotar o orçamento dado (em expansões ou até um instante
+ * limite) e retorna, preservando o heap para a chamada seguinte. Assim, várias
+ * buscas podem ser intercaladas em uma mesma thread com latência limitada
+ * por fatia.
+ *
+ * O estado da busca (distâncias, pais, cores) fica nos nós do grafo, de modo
+ * que buscas intercaladas têm que usar grafos distintos, e o grafo não pode
+ * ser usado por outra busca enquanto a tarefa não terminar. Para intercalar
+ * buscas em um mesmo mapa, cada tarefa pode usar sua própria SearchOverlay
+ * sobre ele, que também torna barata a construção da tarefa.
+ */
+template <typename Compare, typename Successors, typename G = Graph>
+class SearchTask {
+public:
+	typedef typename G::node_type Node;
+
+	SearchTask(G &_g, Node *_src, Node const *_dst, Compare cmp, Successors _succ)
+		: g(_g), src(_src), dst(_dst), succ(_succ), heap(cmp),
+		  status(eSearchRunning), ins(0), upd(0), pop(0) {
+		PROFILE_SCOPE(ePhaseSearch);
+		{
+			PROFILE_SCOPE(ePhaseReset);
+			g.init_single_source(src);
+		}
+
+		// Heap tem apenas nó inicial.
+		heap.insert(src);
+		ins++;
+	}
+
+	// Expande no máximo max_expansions nós.
+	SearchStatus step(size_t max_expansions) {
+		PROFILE_SCOPE(ePhaseSearch);
+		for (size_t ii = 0; ii < max_expansions && status == eSearchRunning; ii++) {
+			expand();
+		}
+		return status;
+	}
+
+	/*
+	 * Expande nós até o instante dado (como retornado por gettimeofday). O
+	 * relógio é consultado a cada DEADLINE_CHECK expansões, e pelo menos uma
+	 * expansão é sempre feita.
+	 */
+	SearchStatus step(timeval const &deadline) {
+		PROFILE_SCOPE(ePhaseSearch);
+		while (status == eSearchRunning) {
+			for (unsigned ii = 0; ii < DEADLINE_CHECK && status == eSearchRunning; ii++) {
+				expand();
+			}
+			timeval now;
+			gettimeofday(&now, NULL);
+			if (!timercmp(&now, &deadline, <)) {
+				break;
+			}
+		}
+		return status;
+	}
+
+	SearchStatus get_status() const {	return status;	}
+
+	// Contadores de inserções, atualizações e remoções do heap até agora.
+	size_t get_inserts() const      {	return ins;	}
+	size_t get_updates() const      {	return upd;	}
+	size_t get_pops() const         {	return pop;	}
+
+private:
+	enum {
+		DEADLINE_CHECK = 16
+	};
+
+	// Uma iteração do laço principal.
+	void expand() {
+		Node *u;
+		SearchStatus st = expand_next(g, heap, src, dst, succ, ins, upd, pop, u);
+		if (st != eSearchRunning) {
+			finish(st);
+		}
+	}
+
+	void finish(SearchStatus st) {
+		status = st;
+		MemStats::record_open_list(heap.get_peak_size());
+	}
+
+	G &g;
+	Node *src;
+	Node const *dst;
+	Successors succ;
+	Heap<Node, Compare, GetIndex, SetIndex> heap;
+	SearchStatus status;
+	size_t ins, upd, pop;
+
+	// Não copiável: o heap aponta para os nós do grafo.
+	SearchTask(SearchTask const &);
+	SearchTask &operator=(SearchTask const &);
+};
+
+// Versão genérica para Dijkstra, A* e JPS usando functors ou poiteiros para
+// funções para efetuar as operações necessárias. Equivale a uma SearchTask
+// executada de uma só vez.
+template <typename G, typename Compare, typename Successors>
+void ShortestPath(G &g, typename G::node_type *src, typename G::node_type const *dst,
+                  Compare cmp, Successors succ, size_t &ins, size_t &upd, size_t &pop) {
+	SearchTask<Compare, Successors, G> task(g, src, dst, cmp, succ);
+	task.step(static_cast<size_t>(-1));
+	ins = task.get_inserts();
+	upd = task.get_updates();
+	pop = task.get_pops();
+}
+
+#endif // _SEARCH_H_
@@ -0,0 +1,259 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "simdsearch.h"
+#include "memstats.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#	define SIMD_X86 1
+#	include <immintrin.h>
+#else
+#	define SIMD_X86 0
+#endif
+
+using namespace std;
+
+// Deslocamento do vizinho em cada direção, em double para os núcleos.
+static double const STEP_DX[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+static double const STEP_DY[8] = {-1, -1, 0, 1, 1, 1, 0, -1};
+// A heurística dos núcleos é max(dx, dy) + DIAGDIST * min(dx, dy).
+static double const DIAGDIST = SimdSearch::Metric::diagonal_excess();
+
+static unsigned expand_scalar(double const *dist, size_t cell, int32_t const *offs,
+                              double const *step, double gc, double relx, double rely,
+                              double hscale, unsigned moves, double *newg, double *newf) {
+	unsigned mask = 0;
+	for (unsigned ii = 0; ii < 8; ii++) {
+		if (!(moves & (1u << ii))) {
+			continue;
+		}
+		double cand = gc + step[ii];
+		if (cand < dist[cell + offs[ii]]) {
+			double dx = fabs(relx + STEP_DX[ii]), dy = fabs(rely + STEP_DY[ii]);
+			newg[ii] = cand;
+			newf[ii] = cand + hscale * (max(dx, dy) + DIAGDIST * min(dx, dy));
+			mask |= 1u << ii;
+		}
+	}
+	return mask;
+}
+
+#if SIMD_X86
+/*
+ * SSE2 não tem gather: as distâncias são lidas duas a duas, mas o resto do
+ * cálculo é feito sobre os 8 vizinhos sem desvios.
+ */
+__attribute__((target("sse2")))
+static unsigned expand_sse2(double const *dist, size_t cell, int32_t const *offs,
+                            double const *step, double gc, double relx, double rely,
+                            double hscale, unsigned moves, double *newg, double *newf) {
+	__m128d const absmask = _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffLL));
+	__m128d const vg = _mm_set1_pd(gc), vhs = _mm_set1_pd(hscale);
+	__m128d const vrx = _mm_set1_pd(relx), vry = _mm_set1_pd(rely);
+	__m128d const vdiag = _mm_set1_pd(DIAGDIST);
+	double const *base = dist + cell;
+	unsigned mask = 0;
+	for (unsigned ii = 0; ii < 8; ii += 2) {
+		__m128d old = _mm_set_pd(base[offs[ii + 1]], base[offs[ii]]);
+		__m128d cand = _mm_add_pd(vg, _mm_loadu_pd(step + ii));
+		__m128d dx = _mm_and_pd(_mm_add_pd(vrx, _mm_loadu_pd(STEP_DX + ii)), absmask);
+		__m128d dy = _mm_and_pd(_mm_add_pd(vry, _mm_loadu_pd(STEP_DY + ii)), absmask);
+		__m128d h = _mm_add_pd(_mm_max_pd(dx, dy), _mm_mul_pd(vdiag, _mm_min_pd(dx, dy)));
+		_mm_storeu_pd(newg + ii, cand);
+		_mm_storeu_pd(newf + ii, _mm_add_pd(cand, _mm_mul_pd(vhs, h)));
+		mask |= static_cast<unsigned>(_mm_movemask_pd(_mm_cmplt_pd(cand, old))) << ii;
+	}
+	return mask & moves;
+}
+
+// AVX2: as distâncias dos vizinhos são lidas com gather, 4 de cada vez.
+__attribute__((target("avx2")))
+static unsigned expand_avx2(double const *dist, size_t cell, int32_t const *offs,
+                            double const *step, double gc, double relx, double rely,
+                            double hscale, unsigned moves, double *newg, double *newf) {
+	__m256d const absmask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+	__m256d const vg = _mm256_set1_pd(gc), vhs = _mm256_set1_pd(hscale);
+	__m256d const vrx = _mm256_set1_pd(relx), vry = _mm256_set1_pd(rely);
+	__m256d const vdiag = _mm256_set1_pd(DIAGDIST);
+	// Máscara explícita: a versão sem máscara gera um aviso falso no gcc.
+	__m256d const all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+	double const *base = dist + cell;
+	unsigned mask = 0;
+	for (unsigned ii = 0; ii < 8; ii += 4) {
+		__m128i idx = _mm_loadu_si128(reinterpret_cast<__m128i const *>(offs + ii));
+		__m256d old = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), base, idx, all, 8);
+		__m256d cand = _mm256_add_pd(vg, _mm256_loadu_pd(step + ii));
+		__m256d dx = _mm256_and_pd(_mm256_add_pd(vrx, _mm256_loadu_pd(STEP_DX + ii)), absmask);
+		__m256d dy = _mm256_and_pd(_mm256_add_pd(vry, _mm256_loadu_pd(STEP_DY + ii)), absmask);
+		__m256d h = _mm256_add_pd(_mm256_max_pd(dx, dy),
+		                          _mm256_mul_pd(vdiag, _mm256_min_pd(dx, dy)));
+		_mm256_storeu_pd(newg + ii, cand);
+		_mm256_storeu_pd(newf + ii, _mm256_add_pd(cand, _mm256_mul_pd(vhs, h)));
+		mask |= static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(cand, old, _CMP_LT_OQ))) << ii;
+	}
+	return mask & moves;
+}
+#endif
+
+SimdSearch::SimdSearch(Graph &_g)
+	: g(_g), version(g.get_version()), pw(g.get_width() + 2), heap(KeyCmp(this)) {
+	size_t total = static_cast<size_t>(pw) * (g.get_height() + 2);
+	dist.resize(total);
+	fval.resize(total);
+	heapidx.resize(total);
+	state.resize(total);
+	moves.resize(total);
+	for (unsigned ii = 0; ii < 8; ii++) {
+		offs[ii] = DIR_DY[ii] * static_cast<int32_t>(pw) + DIR_DX[ii];
+		step[ii] = Metric::cost(DIR_DX[ii], DIR_DY[ii]);
+	}
+	update_moves();
+}
+
+char const *SimdSearch::get_kernel_name(Kernel kern) {
+	static char const *const names[eNumKernels] = {"scalar", "sse2", "avx2"};
+	return kern < eNumKernels ? names[kern] : "?";
+}
+
+bool SimdSearch::is_supported(Kernel kern) {
+	switch (kern) {
+		case eScalar:
+			return true;
+#if SIMD_X86
+		case eSSE2:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("sse2");
+		case eAVX2:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2");
+#endif
+		default:
+			return false;
+	}
+}
+
+SimdSearch::Kernel SimdSearch::best_kernel() {
+	for (int kern = eNumKernels - 1; kern > eScalar; kern--) {
+		if (is_supported(static_cast<Kernel>(kern))) {
+			return static_cast<Kernel>(kern);
+		}
+	}
+	return eScalar;
+}
+
+SimdSearch::ExpandFn SimdSearch::get_kernel(Kernel kern) {
+	if (!is_supported(kern)) {
+		kern = best_kernel();
+	}
+	switch (kern) {
+#if SIMD_X86
+		case eSSE2:
+			return expand_sse2;
+		case eAVX2:
+			return expand_avx2;
+#endif
+		case eScalar:
+		default:
+			return expand_scalar;
+	}
+}
+
+// Copia do grafo os movimentos permitidos a partir de cada nó.
+void SimdSearch::update_moves() {
+	unsigned w = g.get_width(), h = g.get_height();
+	fill(moves.begin(), moves.end(), 0);
+	for (unsigned jj = 0; jj < h; jj++) {
+		for (unsigned ii = 0; ii < w; ii++) {
+			Node const *node = g.get_node(ii, jj);
+			if (node->is_blocked()) {
+				continue;
+			}
+			uint8_t mask = 0;
+			for (unsigned dir = 0; dir < 8; dir++) {
+				if (g.get_adjacent(node, static_cast<Direction>(dir))) {
+					mask |= 1u << dir;
+				}
+			}
+			moves[(jj + 1) * pw + ii + 1] = mask;
+		}
+	}
+	version = g.get_version();
+}
+
+double SimdSearch::search(int sx, int sy, int tx, int ty, Kernel kern, bool astar,
+                          size_t &ins, size_t &upd, size_t &pop) {
+	ins = upd = pop = 0;
+	if (version != g.get_version()) {
+		update_moves();
+	}
+	if (!g.is_passable(sx, sy) || !g.is_passable(tx, ty)) {
+		return -1.0;
+	}
+	ExpandFn expand = get_kernel(kern);
+	double hscale = astar ? 1.0 : 0.0;
+
+	fill(dist.begin(), dist.end(), 1.0E9);
+	fill(state.begin(), state.end(), static_cast<uint8_t>(eUnseen));
+
+	heap.clear(KeyCmp(this));
+	size_t src = static_cast<size_t>(sy + 1) * pw + sx + 1;
+	size_t dst = static_cast<size_t>(ty + 1) * pw + tx + 1;
+	dist[src] = 0;
+	fval[src] = hscale * Metric::cost(sx - tx, sy - ty);
+	state[src] = eOpen;
+	heap.insert(&heapidx[src]);
+	ins++;
+
+	double newg[8], newf[8];
+	while (!heap.empty()) {
+		size_t cell = heap.extract() - &heapidx[0];
+		pop++;
+		state[cell] = eClosed;
+		if (cell == dst) {
+			break;
+		}
+
+		double relx = static_cast<double>(cell % pw) - 1 - tx;
+		double rely = static_cast<double>(cell / pw) - 1 - ty;
+		unsigned mask = expand(&dist[0], cell, offs, step, dist[cell], relx, rely,
+		                       hscale, moves[cell], newg, newf);
+		while (mask) {
+			unsigned ii = __builtin_ctz(mask);
+			mask &= mask - 1;
+			size_t next = cell + offs[ii];
+			if (state[next] == eClosed) {
+				continue;
+			}
+			dist[next] = newg[ii];
+			fval[next] = newf[ii];
+			if (state[next] == eUnseen) {
+				state[next] = eOpen;
+				heap.insert(&heapidx[next]);
+				ins++;
+			} else {
+				heap.update_elem(&heapidx[next]);
+				upd++;
+			}
+		}
+	}
+	MemStats::record_open_list(heap.get_peak_size());
+	return state[dst] == eClosed ? dist[dst] : -1.0;
+}
@@ -0,0 +1,140 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _SIMDSEARCH_H_
+#define _SIMDSEARCH_H_
+
+#include "graph.h"
+#include "heap.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+/*
+ * Dijkstra e A* sobre uma cópia do estado da busca em vetores separados
+ * (structure of arrays) em vez de nos nós de Graph, de modo que a expansão de
+ * um nó pode ser feita com instruções SIMD: as distâncias dos 8 vizinhos são
+ * lidas de uma vez (gather), e os custos candidatos, as heurísticas octis e a
+ * máscara de vizinhos melhorados são calculados juntos. Só os vizinhos da
+ * máscara passam pelo código escalar que atualiza o heap.
+ *
+ * Há um núcleo AVX2, um SSE2 e um escalar, escolhidos em tempo de execução
+ * conforme o processador. A grade tem uma borda de nós bloqueados, para que os
+ * vizinhos de qualquer nó estejam sempre dentro dos vetores. Usa o modelo de
+ * movimento padrão (veja movement.h); os movimentos permitidos são copiados
+ * do grafo e atualizados quando a versão dele muda.
+ */
+class SimdSearch {
+public:
+	// Métrica dos custos e da heurística; os núcleos exigem uma métrica da
+	// forma de OctileMetric (veja diagonal_excess).
+	typedef DefaultMetric Metric;
+
+	enum Kernel {
+		eScalar,
+		eSSE2,
+		eAVX2,
+		eNumKernels
+	};
+
+	explicit SimdSearch(Graph &_g);
+
+	static char const *get_kernel_name(Kernel kern);
+	// Se o processador tem as instruções usadas pelo núcleo.
+	static bool is_supported(Kernel kern);
+	// O melhor núcleo disponível.
+	static Kernel best_kernel();
+
+	/*
+	 * Busca o caminho mínimo de (sx, sy) a (tx, ty) com o núcleo dado; sem
+	 * 'astar', é Dijkstra. Retorna a distância, ou um valor negativo se o
+	 * destino for inalcançável; os contadores são os mesmos de ShortestPath.
+	 */
+	double search(int sx, int sy, int tx, int ty, Kernel kern, bool astar,
+	              size_t &ins, size_t &upd, size_t &pop);
+
+private:
+	// Estado de um nó na busca.
+	enum {
+		eUnseen,
+		eOpen,
+		eClosed
+	};
+
+	// O heap guarda ponteiros para heapidx; o nó é a posição no vetor.
+	struct KeyCmp {
+		KeyCmp(SimdSearch const *_ss) : ss(_ss) {
+		}
+		bool operator()(uint32_t const *lhs, uint32_t const *rhs) const {
+			size_t lc = lhs - &ss->heapidx[0], rc = rhs - &ss->heapidx[0];
+			double fl = ss->fval[lc], fr = ss->fval[rc];
+			if (fl != fr)
+				return fl < fr;
+			// Mesmo desempate de AstarCmp: menor heurística, ou maior g.
+			return ss->dist[lc] > ss->dist[rc];
+		}
+		SimdSearch const *ss;
+	};
+
+	struct GetIndex {
+		size_t operator()(uint32_t const *idx) const {
+			return *idx;
+		}
+	};
+
+	struct SetIndex {
+		void operator()(uint32_t *idx, size_t index) const {
+			*idx = static_cast<uint32_t>(index);
+		}
+	};
+
+	/*
+	 * Núcleo de expansão: para os 8 vizinhos da posição 'cell', calcula o
+	 * custo candidato g e a prioridade f (g + hscale * octil até o destino,
+	 * estando o nó a (relx, rely) do destino), e retorna a máscara dos
+	 * vizinhos alcançáveis ('moves') cujo custo diminuiu.
+	 */
+	typedef unsigned (*ExpandFn)(double const *dist, size_t cell, int32_t const *offs,
+	                             double const *step, double gc, double relx, double rely,
+	                             double hscale, unsigned moves, double *newg, double *newf);
+
+	typedef Heap<uint32_t, KeyCmp, GetIndex, SetIndex> OpenHeap;
+
+	static ExpandFn get_kernel(Kernel kern);
+	void update_moves();
+
+	Graph &g;
+	unsigned version;
+	// Largura da grade com a borda.
+	unsigned pw;
+	// Deslocamento no vetor e custo do passo em cada direção.
+	int32_t offs[8];
+	double step[8];
+	std::vector<double> dist, fval;
+	std::vector<uint32_t> heapidx;
+	std::vector<uint8_t> moves, state;
+	// Reusado entre as buscas, como em CompactSearch.
+	OpenHeap heap;
+
+	// Não copiável: o heap guarda um ponteiro para o objeto.
+	SimdSearch(SimdSearch const &);
+	SimdSearch &operator=(SimdSearch const &);
+};
+
+#endif // _SIMDSEARCH_H_
@@ -0,0 +1,221 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tiledgraph.h"
+
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+/*
+ * Formato do arquivo: cabeçalho em texto,
+ *     type tiled
+ *     height <h>
+ *     width <w>
+ *     tile <lado>
+ *     data
+ * seguido dos blocos, em ordem de linhas de blocos, cada um com lado * lado
+ * bits (1 = impassável) em ordem de linhas. Nós de blocos que ultrapassam a
+ * borda do mapa são impassáveis.
+ */
+TiledGraph::TiledGraph(char const *fname, size_t _tilebudget, size_t _nodebudget)
+	: w(0), h(0), shift(0), tilesw(0), tilebytes(0), tilebudget(_tilebudget),
+	  nodebudget(_nodebudget), dataoffset(0),
+	  last(0), lastid(~static_cast<size_t>(0)), loads(0), evictions(0), peaknodes(0),
+	  failures(0), exhausted(false), stamp(Graph::new_search_stamp()) {
+	fin.open(fname, ios::in | ios::binary);
+	if (!fin.good()) {
+		return;
+	}
+
+	string hdr, sh, sw, st, sd;
+	unsigned side = 0;
+	getline(fin, hdr);
+	fin >> sh >> h >> sw >> w >> st >> side >> sd;
+	if (hdr != "type tiled" || !fin.good() || sh != "height" || sw != "width"
+	    || st != "tile" || sd != "data" || side == 0 || (side & (side - 1)) != 0) {
+		w = h = 0;
+		cerr << "Mapa '" << fname << "' invalido." << endl;
+		return;
+	}
+	// Pula o fim da linha de "data".
+	fin.get();
+	dataoffset = fin.tellg();
+
+	while ((1u << shift) < side) {
+		shift++;
+	}
+	tilesw = (w + side - 1) / side;
+	tilebytes = (static_cast<size_t>(side) * side + 7) / 8;
+}
+
+TiledGraph::TileBits const &TiledGraph::fetch_tile(size_t id) {
+	TileMap::iterator it = tiles.find(id);
+	if (it != tiles.end()) {
+		// Passa a ser o mais recente.
+		ages.splice(ages.begin(), ages, it->second.age);
+		return it->second.bits;
+	}
+
+	while (!tiles.empty() && get_tile_memory() + tilebytes > tilebudget) {
+		evict_tile();
+	}
+
+	Tile &tile = tiles[id];
+	tile.bits.resize(tilebytes);
+	fin.clear();
+	fin.seekg(dataoffset + static_cast<streamoff>(id) * tilebytes);
+	fin.read(reinterpret_cast<char *>(&tile.bits[0]), tilebytes);
+	if (!fin.good()) {
+		// Arquivo truncado: trata o bloco como todo impassável.
+		cerr << "Erro lendo o bloco " << id << " do mapa." << endl;
+		tile.bits.assign(tilebytes, 0xff);
+	}
+	ages.push_front(id);
+	tile.age = ages.begin();
+	loads++;
+	return tile.bits;
+}
+
+void TiledGraph::evict_tile() {
+	size_t oldest = ages.back();
+	ages.pop_back();
+	tiles.erase(oldest);
+	evictions++;
+	if (oldest == lastid) {
+		lastid = ~static_cast<size_t>(0);
+	}
+}
+
+TiledNode *TiledGraph::get_node(int x, int y) {
+	if (x < 0 || static_cast<unsigned>(x) >= w
+	    || y < 0 || static_cast<unsigned>(y) >= h) {
+		return 0;
+	}
+	uint64_t key = static_cast<uint64_t>(y) * w + x;
+	NodeMap::iterator it = index.find(key);
+	if (it != index.end()) {
+		return it->second;
+	}
+	if (!exhausted) {
+		exhausted = get_node_memory() + get_node_bytes() > nodebudget;
+	}
+	if (exhausted) {
+		failures++;
+		return 0;
+	}
+	pool.push_back(TiledNode(x, y, is_blocked(x, y)));
+	if (pool.size() > peaknodes) {
+		peaknodes = pool.size();
+	}
+	TiledNode *node = &pool.back();
+	index[key] = node;
+	return node;
+}
+
+void TiledGraph::release_nodes() {
+	pool.clear();
+	index.clear();
+	exhausted = false;
+	stamp = Graph::new_search_stamp();
+}
+
+/*
+ * Mesmas regras de Graph::get_adjacent: diagonais só são permitidas se pelo
+ * menos um dos nós ortogonais no caminho for passável. Nós bloqueados não
+ * chegam a ser criados. Com o grafo esgotado, não há vizinhos.
+ */
+TiledNode *TiledGraph::get_adjacent(TiledNode const *node, Direction dir) {
+	int x = node->get_x(), y = node->get_y();
+	if (exhausted) {
+		// Não lê blocos: a busca vai ser descartada de qualquer forma.
+		failures++;
+		return 0;
+	}
+	if (!DefaultMovement::can_step(*this, x, y, dir)) {
+		return 0;
+	}
+	return get_node(x + DIR_DX[dir], y + DIR_DY[dir]);
+}
+
+vector<TiledNode *> TiledGraph::get_adjacent_list(TiledNode const *node) {
+	return adjacent_list<DefaultMovement>(*this, node);
+}
+
+unsigned TiledGraph::get_adjacent_nodes(TiledNode const *node, TiledNode **adj) {
+	return adjacent_nodes<DefaultMovement>(*this, node, adj);
+}
+
+bool TiledGraph::convert(char const *mapname, char const *tiledname, unsigned side) {
+	ifstream fin(mapname, ios::in);
+	if (!fin.good()) {
+		return false;
+	}
+
+	string hdr, sw, sh, sm;
+	unsigned mw = 0, mh = 0;
+	getline(fin, hdr);
+	fin >> sh >> mh >> sw >> mw >> sm;
+	if (hdr != "type octile" || !fin.good() || sh != "height" || sw != "width"
+	    || sm != "map" || side == 0 || (side & (side - 1)) != 0) {
+		cerr << "Mapa '" << mapname << "' invalido." << endl;
+		return false;
+	}
+	fin >> ws;
+
+	ofstream fout(tiledname, ios::out | ios::binary);
+	if (!fout.good()) {
+		return false;
+	}
+	fout << "type tiled" << endl
+	     << "height " << mh << endl
+	     << "width " << mw << endl
+	     << "tile " << side << endl
+	     << "data" << endl;
+
+	size_t tilesw = (mw + side - 1) / side;
+	size_t tilebytes = (static_cast<size_t>(side) * side + 7) / 8;
+	vector<string> rows(side);
+	vector<unsigned char> bits(tilebytes);
+	for (unsigned ty = 0; ty < mh; ty += side) {
+		// Uma faixa de 'side' linhas do mapa; linhas além do fim ficam vazias.
+		for (unsigned jj = 0; jj < side; jj++) {
+			rows[jj].clear();
+			if (ty + jj < mh) {
+				getline(fin, rows[jj]);
+			}
+		}
+		for (size_t tx = 0; tx < tilesw; tx++) {
+			bits.assign(tilebytes, 0);
+			for (unsigned jj = 0; jj < side; jj++) {
+				for (unsigned ii = 0; ii < side; ii++) {
+					size_t x = tx * side + ii;
+					bool passable = x < mw && x < rows[jj].size()
+					             && (rows[jj][x] == '.' || rows[jj][x] == 'G');
+					if (!passable) {
+						unsigned bit = jj * side + ii;
+						bits[bit >> 3] |= 1 << (bit & 7);
+					}
+				}
+			}
+			fout.write(reinterpret_cast<char const *>(&bits[0]), tilebytes);
+		}
+	}
+	return fout.good();
+}
@@ -0,0 +1,187 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * Copyright (C) 2014 Marzo Sette Torres Junior <marzojr@dcc.ufmg.br>
+ *
+ * TP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TP is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TILEDGRAPH_H_
+#define _TILEDGRAPH_H_
+
+#include "graph.h"
+
+#include <stdint.h>
+
+#include <deque>
+#include <fstream>
+#include <list>
+#include <vector>
+#include <tr1/unordered_map>
+
+typedef BasicNode<int> TiledNode;
+
+/*
+ * Grafo para mapas grandes demais para caber na memória. O mapa fica em um
+ * arquivo em blocos (veja convert), dos quais apenas os usados recentemente
+ * (dentro do orçamento dos blocos) ficam na memória; os demais são lidos do
+ * disco quando necessário. Cada bloco guarda só a passabilidade dos nós, um
+ * bit por nó.
+ *
+ * Os nós (com o estado das buscas) só são criados quando uma busca chega até
+ * eles, e ficam vivos até release_nodes; como não dependem dos blocos, um
+ * bloco pode ser descartado a qualquer momento sem afetar a busca em
+ * andamento. A interface usada pelas buscas é a mesma de Graph.
+ *
+ * Os nós têm um orçamento separado, para que uma busca grande não expulse
+ * os blocos que ela mesma está usando. Se um nó não couber no seu orçamento,
+ * o grafo fica esgotado até release_nodes: get_node passa a retornar 0 para
+ * qualquer nó ainda não criado e get_adjacent para qualquer vizinho, sem
+ * consultar os blocos, e as falhas são contadas (veja get_node_failures). A
+ * busca em andamento então esvazia rapidamente seu heap, e seu resultado deve
+ * ser descartado.
+ */
+class TiledGraph {
+public:
+	typedef TiledNode node_type;
+
+	/*
+	 * Abre um mapa em blocos; 'tilebudget' e 'nodebudget' são a memória máxima
+	 * para os blocos (mas pelo menos um sempre fica na memória) e para os nós.
+	 */
+	TiledGraph(char const *fname, size_t tilebudget, size_t nodebudget);
+
+	/*
+	 * Converte um arquivo .map para o formato em blocos de lado 'side' (uma
+	 * potência de 2). Lê o mapa uma faixa de blocos por vez, de modo que mapas
+	 * enormes podem ser convertidos.
+	 */
+	static bool convert(char const *mapname, char const *tiledname, unsigned side = 64);
+
+	bool is_valid() const           {	return w != 0 && h != 0;	}
+
+	// Dimensões da grade.
+	unsigned get_width() const      {	return w;	}
+	unsigned get_height() const     {	return h;	}
+	unsigned get_tile_side() const  {	return 1u << shift;	}
+
+	// Se o nó (x, y) é impassável ou fora da grade. Pode ler um bloco do disco.
+	bool is_blocked(int x, int y) {
+		if (x < 0 || static_cast<unsigned>(x) >= w
+		    || y < 0 || static_cast<unsigned>(y) >= h) {
+			return true;
+		}
+		size_t id = (static_cast<size_t>(y) >> shift) * tilesw + (static_cast<unsigned>(x) >> shift);
+		if (id != lastid) {
+			last = &fetch_tile(id);
+			lastid = id;
+		}
+		unsigned mask = (1u << shift) - 1;
+		unsigned bit = ((y & mask) << shift) | (x & mask);
+		return ((*last)[bit >> 3] >> (bit & 7)) & 1;
+	}
+
+	bool is_passable(int x, int y) {
+		return !is_blocked(x, y);
+	}
+
+	// Distância entre nós vizinhos ou heurística, na métrica padrão.
+	static double distance(TiledNode const *lhs, TiledNode const *rhs) {
+		return lhs->distance_to(rhs);
+	}
+
+	/*
+	 * Retorna o nó nas coordenadas dadas, criando-o se ainda não existir, ou 0
+	 * para um nó fora dos limites ou que não cabe no orçamento.
+	 */
+	TiledNode *get_node(int x, int y);
+
+	std::vector<TiledNode *> get_adjacent_list(TiledNode const *node);
+	unsigned get_adjacent_nodes(TiledNode const *node, TiledNode **adj);
+	TiledNode *get_adjacent(TiledNode const *node, Direction dir);
+
+	// Prepara os nós já criados para uma nova busca.
+	void init_single_source(TiledNode *src) {
+		for (std::deque<TiledNode>::iterator it = pool.begin(); it != pool.end(); ++it) {
+			it->init_single_source();
+		}
+		src->set_distance(0);
+		stamp = Graph::new_search_stamp();
+	}
+
+	// Descarta todos os nós criados, invalidando ponteiros para eles.
+	void release_nodes();
+
+	// Marca de busca, como em Graph; release_nodes também a muda.
+	unsigned get_search_stamp() const   {	return stamp;	}
+
+	// Estatísticas.
+	size_t get_tile_loads() const       {	return loads;	}
+	size_t get_tile_evictions() const   {	return evictions;	}
+	size_t get_resident_tiles() const   {	return tiles.size();	}
+	size_t get_tile_bytes() const       {	return tilebytes;	}
+	size_t get_num_nodes() const        {	return pool.size();	}
+	size_t get_peak_nodes() const       {	return peaknodes;	}
+	// Nós que não foram criados por falta de memória desde a abertura.
+	size_t get_node_failures() const    {	return failures;	}
+	// Memória estimada de cada nó criado, incluindo sua entrada no índice.
+	static size_t get_node_bytes() {
+		return sizeof(TiledNode) + sizeof(NodeMap::value_type) + 2 * sizeof(void *);
+	}
+	// Orçamentos e memória usada por blocos e nós.
+	size_t get_tile_budget() const      {	return tilebudget;	}
+	size_t get_node_budget() const      {	return nodebudget;	}
+	size_t get_tile_memory() const      {	return tiles.size() * tilebytes;	}
+	size_t get_node_memory() const      {	return pool.size() * get_node_bytes();	}
+
+private:
+	typedef std::vector<unsigned char> TileBits;
+	struct Tile {
+		TileBits bits;
+		std::list<size_t>::iterator age;
+	};
+	typedef std::tr1::unordered_map<size_t, Tile> TileMap;
+	typedef std::tr1::unordered_map<uint64_t, TiledNode *> NodeMap;
+
+	TileBits const &fetch_tile(size_t id);
+	// Descarta o bloco usado há mais tempo.
+	void evict_tile();
+
+	unsigned w, h;
+	// Blocos têm lado 1 << shift; tilesw blocos por linha de blocos.
+	unsigned shift;
+	size_t tilesw, tilebytes, tilebudget, nodebudget;
+	std::ifstream fin;
+	std::streamoff dataoffset;
+
+	// Blocos na memória; 'ages' tem os ids do mais para o menos recente.
+	TileMap tiles;
+	std::list<size_t> ages;
+	// Último bloco consultado, para evitar a busca na tabela.
+	TileBits const *last;
+	size_t lastid;
+
+	// Nós criados; o deque não move os nós já criados ao crescer.
+	std::deque<TiledNode> pool;
+	NodeMap index;
+
+	size_t loads, evictions, peaknodes, failures;
+	bool exhausted;
+	unsigned stamp;
+
+	// Não copiável: guarda o arquivo aberto.
+	TiledGraph(TiledGraph const &);
+	TiledGraph &operator=(TiledGraph const &);
+};
+
+#endif // _TILEDGRAPH_H_